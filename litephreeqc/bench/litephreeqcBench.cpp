@@ -0,0 +1,206 @@
+/*
+ * This project is subject to the original PHREEQC license. `litephreeqc` is a
+ * version of the PHREEQC code that has been modified to be used as a library.
+ *
+ * It adds a C++ interface on top of the original PHREEQC code, with small
+ * changes to the original code base.
+ *
+ * Authors of Modifications:
+ * - Max Luebke (mluebke@uni-potsdam.de) - University of Potsdam
+ * - Marco De Lucia (delucia@gfz.de) - GFZ Helmholz Centre for Geosciences
+ *
+ */
+
+#include "PhreeqcEngine.hpp"
+#include "PhreeqcMatrix.hpp"
+#include "PhreeqcRunner.hpp"
+#include "utils.hpp"
+
+#include <benchInput.hpp>
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchInput {
+  std::string name;
+  std::string database;
+  std::string script;
+  double time_step;
+};
+
+const std::vector<BenchInput> &inputs() {
+  static const std::vector<BenchInput> inputs = {
+      {"barite_het", readFile(bench_input::barite_db),
+       readFile(bench_input::barite_pqi), 100},
+      {"dolo", readFile(bench_input::kinetics_db),
+       readFile(bench_input::dolo_pqi), 100},
+      {"run_kin_cor_end2", readFile(bench_input::kinetics_db),
+       readFile(bench_input::kin_cor_pqi), 100},
+      // equilibrium models of different size, dominated by the Newton
+      // iterations of the solver
+      {"seawater_phreeqc", readFile(bench_input::phreeqc_db),
+       readFile(bench_input::seawater_pqi), 100},
+      {"seawater_llnl", readFile(bench_input::llnl_db),
+       readFile(bench_input::seawater_pqi), 100},
+  };
+  return inputs;
+}
+
+// inputs which can't be initialized are reported as skipped benchmarks
+std::unique_ptr<PhreeqcMatrix> make_matrix(benchmark::State &state,
+                                           const BenchInput &input) {
+  try {
+    return std::make_unique<PhreeqcMatrix>(input.database, input.script);
+  } catch (const std::exception &e) {
+    state.SkipWithError(("Failed to initialize " + input.name + ": " + e.what())
+                            .c_str());
+    return nullptr;
+  }
+}
+
+// row-major field of `num_cells` cells, cycling through the cell templates
+std::vector<double> make_field(const PhreeqcMatrix &matrix,
+                               std::size_t num_cells, std::size_t &ncols) {
+  const auto exported = matrix.get();
+  ncols = exported.names.size();
+
+  const std::size_t num_templates = exported.values.size() / ncols;
+
+  std::vector<double> field(num_cells * ncols);
+  for (std::size_t cell = 0; cell < num_cells; cell++) {
+    const auto row = exported.values.begin() + (cell % num_templates) * ncols;
+    std::copy(row, row + ncols, field.begin() + cell * ncols);
+  }
+
+  return field;
+}
+
+void set_cell_counters(benchmark::State &state, std::size_t cells) {
+  state.counters["cells_per_second"] =
+      benchmark::Counter(static_cast<double>(cells),
+                         benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void BM_MatrixConstruction(benchmark::State &state, const BenchInput &input) {
+  for (auto _ : state) {
+    auto matrix = make_matrix(state, input);
+    if (!matrix) {
+      return;
+    }
+    benchmark::DoNotOptimize(matrix.get());
+  }
+}
+
+void BM_EngineConstruction(benchmark::State &state, const BenchInput &input) {
+  const auto matrix = make_matrix(state, input);
+  if (!matrix) {
+    return;
+  }
+
+  const int id = matrix->getIds().front();
+
+  for (auto _ : state) {
+    PhreeqcEngine engine(*matrix, id);
+    benchmark::DoNotOptimize(&engine);
+  }
+}
+
+void BM_EngineRunCell(benchmark::State &state, const BenchInput &input) {
+  const auto matrix = make_matrix(state, input);
+  if (!matrix) {
+    return;
+  }
+
+  const int id = matrix->getIds().front();
+  PhreeqcEngine engine(*matrix, id);
+
+  // values of the first cell template without the ID and unused columns
+  std::vector<double> initial;
+  const auto exported = matrix->get();
+  for (std::size_t col = 1; col < exported.names.size(); col++) {
+    if (!std::isnan(exported.values[col])) {
+      initial.push_back(exported.values[col]);
+    }
+  }
+
+  std::vector<double> cell;
+  for (auto _ : state) {
+    cell = initial;
+    engine.runCell(cell, input.time_step);
+    benchmark::DoNotOptimize(cell.data());
+  }
+
+  set_cell_counters(state, 1);
+}
+
+void BM_RunnerRun(benchmark::State &state, const BenchInput &input) {
+  const auto matrix = make_matrix(state, input);
+  if (!matrix) {
+    return;
+  }
+
+  const auto num_cells = static_cast<std::size_t>(state.range(0));
+  const auto num_threads = static_cast<std::size_t>(state.range(1));
+
+  std::size_t ncols;
+  const std::vector<double> initial = make_field(*matrix, num_cells, ncols);
+  std::vector<double> field;
+
+  PhreeqcRunner runner(*matrix, num_threads);
+
+  for (auto _ : state) {
+    // every iteration starts from the initial state of the cell templates
+    state.PauseTiming();
+    field = initial;
+    state.ResumeTiming();
+
+    runner.run(std::span<double>(field), ncols, input.time_step);
+  }
+
+  set_cell_counters(state, num_cells);
+}
+
+void register_benchmarks() {
+  for (const auto &input : inputs()) {
+    benchmark::RegisterBenchmark(("MatrixConstruction/" + input.name).c_str(),
+                                 BM_MatrixConstruction, input)
+        ->Unit(benchmark::kMillisecond);
+
+    benchmark::RegisterBenchmark(("EngineConstruction/" + input.name).c_str(),
+                                 BM_EngineConstruction, input)
+        ->Unit(benchmark::kMillisecond);
+
+    benchmark::RegisterBenchmark(("EngineRunCell/" + input.name).c_str(),
+                                 BM_EngineRunCell, input)
+        ->Unit(benchmark::kMicrosecond);
+
+    benchmark::RegisterBenchmark(("RunnerRun/" + input.name).c_str(),
+                                 BM_RunnerRun, input)
+        ->ArgNames({"cells", "threads"})
+        ->ArgsProduct({{100, 1000, 10000}, {1, 2, 4}})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+
+  register_benchmarks();
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
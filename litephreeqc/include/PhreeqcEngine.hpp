@@ -14,6 +14,7 @@
 #pragma once
 
 #include "PhreeqcMatrix.hpp"
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -39,12 +40,93 @@ public:
    */
   PhreeqcEngine(const PhreeqcMatrix &pqc_mat, const int cell_id);
 
+  /**
+   * @brief Reactants of all cell templates of a PhreeqcMatrix
+   *
+   * Holds the reactants (solution, exchange, kinetics, equilibrium phases,
+   * surfaces, ...) of every cell found in the PhreeqcMatrix. They are never
+   * changed after construction, so a single instance can be shared by the
+   * engines of several threads.
+   */
+  class Templates {
+  public:
+    explicit Templates(const PhreeqcMatrix &pqc_mat);
+    ~Templates();
+
+  private:
+    friend class PhreeqcEngine;
+    struct Data;
+    std::unique_ptr<Data> data;
+  };
+
+  /**
+   * @brief Construct a new Phreeqc Engine object able to simulate every cell
+   *
+   * Equal to PhreeqcEngine(pqc_mat, templates) with templates of its own.
+   *
+   * @param pqc_mat PhreeqcMatrix initialized with the *full* Phreeqc script and
+   * database.
+   */
+  explicit PhreeqcEngine(const PhreeqcMatrix &pqc_mat);
+
+  /**
+   * @brief Construct a new Phreeqc Engine object able to simulate every cell
+   * of shared templates
+   *
+   * The engine holds the reactants of a single cell. The cell to simulate is
+   * selected with bindCell(), which copies the reactants of that cell
+   * template from `templates`. Thus, a single engine serves all cell
+   * templates, while the templates are stored only once for all engines
+   * sharing them, which is used by PhreeqcRunner's engine pool.
+   *
+   * The engine is bound to the first cell of the PhreeqcMatrix after
+   * construction.
+   *
+   * @param pqc_mat PhreeqcMatrix initialized with the *full* Phreeqc script and
+   * database.
+   * @param templates Reactants of the cell templates of `pqc_mat`
+   */
+  PhreeqcEngine(const PhreeqcMatrix &pqc_mat,
+                std::shared_ptr<const Templates> templates);
+
   /**
    * @brief Destroy the Phreeqc Engine object
    *
    */
   ~PhreeqcEngine();
 
+  /**
+   * @brief Converged solver state of a single grid cell
+   *
+   * Holds the log activities of the master species, the activity coefficients
+   * and pH, pe, ionic strength and activity of water after the last step of a
+   * cell. Passed to runCell(), the next step of the same cell starts its
+   * Newton iterations from these values instead of the ones of the cell
+   * template. An empty state is filled by the first call to runCell().
+   */
+  class CellState {
+  public:
+    CellState();
+    ~CellState();
+    CellState(CellState &&) noexcept;
+    CellState &operator=(CellState &&) noexcept;
+
+    /**
+     * @brief Whether the state was filled by a previous step
+     */
+    bool empty() const;
+
+    /**
+     * @brief Discard the stored state, the next step starts cold
+     */
+    void clear();
+
+  private:
+    friend class PhreeqcEngine;
+    struct Data;
+    std::unique_ptr<Data> data;
+  };
+
   /**
    * @brief Siimulate a cell for a given time step
    *
@@ -55,7 +137,109 @@ public:
    */
   void runCell(std::vector<double> &cell_values, double time_step);
 
+  /**
+   * @brief Simulate a cell for a given time step, warm-started from the
+   * previous step of the same cell
+   *
+   * Equal to runCell(cell_values, time_step), but the solver starts from the
+   * values stored in `state`, which is updated with the converged values
+   * afterwards. A state stored for another cell template is discarded.
+   *
+   * @param cell_values Vector containing the input values for the cell
+   * (*without the ID*). Output values are written back in place to this
+   * vector.
+   * @param time_step Time step to simulate in seconds
+   * @param state Converged state of the previous step of this cell
+   */
+  void runCell(std::vector<double> &cell_values, double time_step,
+               CellState &state);
+
+  /**
+   * @brief Select the cell template used by subsequent calls to runCell
+   *
+   * Rebinding to another cell template copies its reactants from the
+   * templates of the engine, no data is parsed. Binding the current cell
+   * template again keeps the reactants of the previous step.
+   *
+   * @param cell_id ID of the cell (user id from Phreeqc script) to simulate
+   * @throw std::invalid_argument if the engine wasn't initialized with this
+   * cell
+   */
+  void bindCell(int cell_id);
+
+  /**
+   * @brief Get the ID of the cell template currently simulated by runCell
+   *
+   * @return int ID of the cell (user id from Phreeqc script)
+   */
+  int boundCell() const;
+
+  /**
+   * @brief Reset the start values of the solver before each step
+   *
+   * By default a step starts its Newton iterations from the pH, pe, ionic
+   * strength and further solver values left by the previous call to
+   * runCell(), just as PHREEQC does. When enabled, each step starts from the
+   * values of the cell template instead, so its result doesn't depend on the
+   * previously simulated cell. Used by PhreeqcRunner, which hands out cells
+   * to engines in no fixed order.
+   *
+   * @param enable Whether to reset the start values before each step
+   */
+  void setResetStartValues(bool enable);
+
+  /**
+   * @brief Counts of the linear solvers used for the Newton steps
+   *
+   * With KNOBS -dense_linear_solver true, Newton steps without active
+   * mineral, gas or solid solution constraints are solved by LU
+   * decomposition, all others by the L1 simplex solver cl1.
+   * Equilibrations with the same unknowns as the previous one reuse its
+   * prepared model instead of setting it up again.
+   */
+  struct SolverStats {
+    std::size_t dense_solves = 0; ///< Newton steps solved by LU decomposition
+    std::size_t cl1_solves = 0;   ///< Newton steps solved by cl1
+    std::size_t model_reuses = 0; ///< equilibrations reusing the last model
+  };
+
+  /**
+   * @brief Get the solver counts accumulated since construction of the engine
+   *
+   * @return SolverStats Number of Newton steps per linear solver
+   */
+  SolverStats getSolverStats() const;
+
+  /**
+   * @brief Counters of the temperature/pressure log K cache
+   *
+   * The log K's without the pressure term and the molar volumes at zero ionic
+   * strength of all species and phases only depend on the chemical model, the
+   * temperature and the pressure. They are cached per model and (T, P) and
+   * shared by all engines cloned from the same PhreeqcMatrix, so cells at the
+   * same conditions skip their recalculation. An engine looks up the cache
+   * once per model and (T, P) change, the oldest entries are dropped when it
+   * is full.
+   */
+  struct LogKCacheStats {
+    std::size_t hits = 0;    ///< lookups finding an entry of the cache
+    std::size_t misses = 0;  ///< lookups calculating a new entry
+    std::size_t entries = 0; ///< entries currently stored
+  };
+
+  /**
+   * @brief Get the counters of the log K cache used by this engine
+   *
+   * @return LogKCacheStats Counters accumulated by all engines sharing the
+   * cache
+   */
+  LogKCacheStats getLogKCacheStats() const;
+
 private:
+  // runCell(), warm-started from `state` unless it is null
+  void run_cell(std::vector<double> &cell_values, double time_step,
+                CellState *state);
+
   class Impl;
   std::unique_ptr<Impl> impl;
 };
\ No newline at end of file
@@ -28,6 +28,21 @@ struct PhreeqcKnobsParams {
   double step_size;
   double pe_step_size;
   bool diagonal_scale;
+  // accumulate cl1 sums in double with compensated summation instead of long
+  // double
+  bool cl1_compensated_sum;
+  // solve Newton steps without active inequalities by LU decomposition,
+  // results differ from cl1 at the convergence tolerance
+  bool dense_linear_solver;
+  // evaluate Debye-Hueckel type activity coefficients grouped by model
+  bool vectorized_gammas;
+  // run RATES as compiled programs instead of interpreting BASIC lines
+  bool compiled_rates;
+  // threads evaluating the columns of the CVODE Jacobian, 1 is serial
+  std::uint32_t cvode_jacobian_threads;
+  // relative change of the rates up to which a CVODE Jacobian is reused at
+  // the start of an integration, 0 never reuses it
+  double cvode_jacobian_reuse;
 };
 
 class Phreeqc;
@@ -326,6 +326,20 @@ public:
    */
   bool withRedox() const { return _m_with_redox; }
 
+  /**
+   * @brief Get the Phreeqc instance holding only the parsed database.
+   *
+   * The database is parsed and tidied once during construction of the
+   * PhreeqcMatrix. PhreeqcEngine clones this instance instead of reading the
+   * database again for every engine.
+   *
+   * @return const Phreeqc* Prototype instance or nullptr for a default
+   * constructed PhreeqcMatrix.
+   */
+  const Phreeqc *getDatabasePrototype() const {
+    return _m_db_prototype.get();
+  }
+
   // MDL
   /**
    * @brief Returns all column names of the Matrix pertaining to KINETICS
@@ -379,6 +393,7 @@ private:
   void remove_NaNs();
 
   std::shared_ptr<IPhreeqc> _m_pqc;
+  std::shared_ptr<const Phreeqc> _m_db_prototype;
   std::shared_ptr<PhreeqcKnobs> _m_knobs;
 
   std::string _m_database;
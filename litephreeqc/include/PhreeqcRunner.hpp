@@ -17,9 +17,13 @@
 #include "PhreeqcMatrix.hpp"
 #include <cstddef>
 #include <memory>
+#include <span>
 #include <unordered_map>
 #include <vector>
 
+class ResultCache;
+class WorkStealingScheduler;
+
 /**
  * @class PhreeqcRunner
  * @brief Manages the execution of Phreeqc simulations.
@@ -29,6 +33,22 @@
  * provided PhreeqcMatrix and provides functionality to run simulations and
  * retrieve the number of engines.
  *
+ * Cells can be simulated in parallel by a configurable number of threads.
+ * Each thread owns its own set of PhreeqcEngine instances and scratch buffer,
+ * while the cells are distributed by a work-stealing scheduler. With more
+ * than one thread, every cell is simulated by an engine initialized from the
+ * same cell template and starts from the solver values of that template (see
+ * setResetStartValues()), so results don't depend on the number of threads.
+ * A serial runner keeps the PHREEQC behaviour of starting each cell from the
+ * values left by the previous one unless the reset is enabled.
+ *
+ * By default one PhreeqcEngine per cell template and thread is created. In
+ * EngineMode::POOL each thread owns a single engine, which is rebound to the
+ * template of the current cell on demand by copying its reactants from
+ * templates shared by all threads. Memory and startup costs of the engines
+ * then scale with the number of threads instead of the number of cell
+ * templates, the templates are held only once.
+ *
  * @note Copy and move operations are deleted to prevent unintended behavior.
  */
 class PhreeqcRunner {
@@ -48,8 +68,44 @@ public:
    * @param matrix A reference to a PhreeqcMatrix object used to initialize the
    * PhreeqcRunner.
    */
-  PhreeqcRunner(const PhreeqcMatrix &matrix);
-  ~PhreeqcRunner() = default;
+  PhreeqcRunner(const PhreeqcMatrix &matrix) : PhreeqcRunner(matrix, 1) {}
+
+  /**
+   * @brief Defines how PhreeqcEngine instances are assigned to cell templates.
+   */
+  enum class EngineMode {
+    PER_TEMPLATE, ///< one engine per cell template and thread
+    POOL          ///< one engine per thread, rebound to the cell template
+  };
+
+  /**
+   * @brief Constructs a PhreeqcRunner object running cells in parallel.
+   *
+   * For each thread either a full set of PhreeqcEngine instances is created,
+   * i.e. one engine per cell found in the PhreeqcMatrix, or a single engine
+   * serving all cells (see EngineMode).
+   *
+   * @param matrix A reference to a PhreeqcMatrix object used to initialize the
+   * PhreeqcRunner.
+   * @param num_threads Number of threads used to simulate the cells. A value of
+   * 1 runs all cells serially on the calling thread.
+   * @param mode Whether to create one engine per cell template and thread or a
+   * pool of one engine per thread.
+   * @throw std::invalid_argument if num_threads is 0.
+   */
+  PhreeqcRunner(const PhreeqcMatrix &matrix, std::size_t num_threads,
+                EngineMode mode = EngineMode::PER_TEMPLATE);
+  ~PhreeqcRunner();
+
+  /**
+   * @brief Statistics of a single thread gathered during the last call to
+   * run().
+   */
+  struct ThreadStats {
+    double busy_seconds; ///< time spent simulating cells
+    std::size_t cells;   ///< number of simulated cells
+    std::size_t steals;  ///< number of successful steals from other threads
+  };
 
   /**
    * @brief Runs the simulation with the given input and output data for a
@@ -76,16 +132,210 @@ public:
            const double time_step, const std::vector<std::size_t> &to_ignore);
 
   /**
-   * @brief Returns the number of engines currently stored.
+   * @brief Memory layout of a contiguous field of cells.
+   */
+  using Layout = PhreeqcMatrix::VectorExportType;
+
+  /**
+   * @brief Runs the simulation in place on a contiguous field of cells.
+   *
+   * The field holds one cell per row with `ncols` columns each, starting with
+   * the cell ID, in the same layout as exported by PhreeqcMatrix::get(). In
+   * row-major layout the values of a cell are contiguous, in column-major
+   * layout the values of a single column are. No per cell vectors are
+   * allocated; the values of each cell are gathered into a per-thread buffer
+   * by an index map precomputed for its cell template and scattered back
+   * afterwards.
+   *
+   * @param field Values of all cells, overwritten with the results.
+   * @param ncols Number of columns, must match the PhreeqcMatrix.
+   * @param time_step The time step for the simulation.
+   * @param layout Layout of `field`.
+   * @throw std::invalid_argument if `ncols` doesn't match the PhreeqcMatrix
+   * or the size of `field` is not a multiple of `ncols`.
+   */
+  void run(std::span<double> field, std::size_t ncols, const double time_step,
+           Layout layout = Layout::ROW_MAJOR);
+
+  /**
+   * @brief Enables warm-starting the solver of each cell from its previous
+   * time step.
+   *
+   * When enabled, the converged activities, activity coefficients and ionic
+   * strength of every row of `simulationInOut` are kept between calls to
+   * run() and used as start values of the next time step of the same row.
+   * This reduces the number of Newton iterations if cells change only
+   * slightly per time step, but results then depend on the previous steps
+   * within the solver tolerance. Disabled by default.
+   *
+   * The stored states are discarded when warm-starting is disabled or the
+   * number of rows passed to run() changes.
+   *
+   * @param enable Whether to warm-start the cells.
+   */
+  void setWarmStart(bool enable);
+
+  /**
+   * @brief Returns whether the cells are warm-started from their previous
+   * time step.
+   */
+  bool warmStart() const { return _warm_start; }
+
+  /**
+   * @brief Resets the start values of the solver before each cell.
+   *
+   * When enabled, every cell starts its Newton iterations from the values of
+   * its cell template instead of those left by the cell simulated before by
+   * the same engine (see PhreeqcEngine::setResetStartValues()). The results
+   * are then identical for any number of threads, as the cells are handed
+   * out to the threads in no fixed order.
+   *
+   * Enabled by default if more than one thread is used, disabled for a
+   * serial runner.
+   *
+   * @param enable Whether to reset the start values before each cell.
+   */
+  void setResetStartValues(bool enable);
+
+  /**
+   * @brief Returns whether the start values of the solver are reset before
+   * each cell.
+   */
+  bool resetStartValues() const { return _reset_start_values; }
+
+  /**
+   * @brief Counters of the result cache.
+   */
+  struct CacheStats {
+    std::size_t hits = 0;      ///< cells answered from the cache
+    std::size_t misses = 0;    ///< cells simulated by an engine
+    std::size_t evictions = 0; ///< entries dropped to stay within the budget
+    std::size_t entries = 0;   ///< entries currently stored
+    std::size_t bytes = 0;     ///< approximated memory used by the entries
+  };
+
+  /**
+   * @brief Enables a cache of cell results keyed on the cell template ID, the
+   * time step and the quantized input values of a cell.
+   *
+   * Cells whose inputs did not change since a previous simulation, e.g.
+   * regions of the domain not reached by a reaction front, are then answered
+   * from the cache without running PHREEQC. With a `tolerance` of 0 only
+   * bitwise identical inputs hit the cache. Otherwise the mantissa of each
+   * value is rounded to multiples of `tolerance`, so inputs within roughly
+   * this relative difference return the result of the first simulated cell.
    *
-   * This function provides the count of engines that are currently
-   * stored in the _engineStorage container.
+   * The least recently used results are evicted once the entries exceed
+   * `max_bytes`. Cells answered from the cache don't update their warm start
+   * state. Any previously cached results are discarded.
+   *
+   * @param max_bytes Memory budget of the cache, 0 disables the cache.
+   * @param tolerance Relative tolerance used to quantize the input values.
+   * @throw std::invalid_argument if `tolerance` is not in [0, 1).
+   */
+  void setResultCache(std::size_t max_bytes, double tolerance = 0);
+
+  /**
+   * @brief Returns whether cell results are cached.
+   */
+  bool resultCache() const { return _cache != nullptr; }
+
+  /**
+   * @brief Discards all cached results and resets the counters.
+   */
+  void clearResultCache();
+
+  /**
+   * @brief Returns the counters of the result cache.
+   *
+   * @return CacheStats All zero if the cache is disabled.
+   */
+  CacheStats getCacheStats() const;
+
+  /**
+   * @brief Returns the number of engines simulating the cells of a thread.
+   *
+   * This is the number of cell templates, or 1 in EngineMode::POOL. Every
+   * thread owns such a set of engines.
    *
    * @return std::size_t The number of engines.
    */
-  std::size_t numEngines() const { return _engineStorage.size(); }
+  std::size_t numEngines() const {
+    return _engineStorage.size() / _threadEngines.size();
+  }
+
+  /**
+   * @brief Returns the number of engines stored for all threads.
+   *
+   * @return std::size_t The number of engines, summed over all threads.
+   */
+  std::size_t totalEngines() const { return _engineStorage.size(); }
+
+  /**
+   * @brief Returns the number of threads used to simulate the cells.
+   *
+   * @return std::size_t The number of threads.
+   */
+  std::size_t numThreads() const { return _threadEngines.size(); }
+
+  /**
+   * @brief Returns the per-thread statistics of the last call to run().
+   *
+   * @return std::vector<ThreadStats> One entry per thread.
+   */
+  std::vector<ThreadStats> getThreadStats() const;
+
+  /**
+   * @brief Returns the linear solver counts summed over all engines.
+   *
+   * @return PhreeqcEngine::SolverStats Number of Newton steps per linear
+   * solver since construction of the runner.
+   */
+  PhreeqcEngine::SolverStats getSolverStats() const;
+
+  /**
+   * @brief Returns the counters of the log K cache.
+   *
+   * All engines of the runner are cloned from the same PhreeqcMatrix and thus
+   * share a single cache across threads.
+   *
+   * @return PhreeqcEngine::LogKCacheStats Counters of the shared cache.
+   */
+  PhreeqcEngine::LogKCacheStats getLogKCacheStats() const;
 
 private:
-  std::unordered_map<int, std::unique_ptr<PhreeqcEngine>> _engineStorage;
-  std::vector<double> _buffer;
+  void run_cells(std::vector<std::vector<double>> &simulationInOut,
+                 const double time_step,
+                 const std::vector<std::size_t> &cell_indices);
+
+  // simulates the cell whose values are found at cell[k * stride]; `row` is
+  // the index of the cell in the field passed to run()
+  void run_cell(std::size_t thread, double *cell, std::size_t stride,
+                double time_step, std::size_t row);
+
+  void prepare_states(std::size_t num_rows);
+
+  using EngineMap = std::unordered_map<int, PhreeqcEngine *>;
+
+  // per cell template the columns holding its values, i.e. all columns
+  // besides the ID which are not NaN in the PhreeqcMatrix
+  std::unordered_map<int, std::vector<std::size_t>> _columnMaps;
+  std::size_t _numColumns;
+
+  std::vector<std::unique_ptr<PhreeqcEngine>> _engineStorage;
+
+  // cell ID to engine lookup and one scratch buffer per thread
+  std::vector<EngineMap> _threadEngines;
+  std::vector<std::vector<double>> _buffers;
+
+  std::unique_ptr<WorkStealingScheduler> _scheduler;
+
+  // converged state of each row of simulationInOut, used for warm starts
+  bool _warm_start = false;
+  std::vector<PhreeqcEngine::CellState> _cellStates;
+
+  bool _reset_start_values = false;
+
+  // optional cache of cell results, shared by all threads
+  std::unique_ptr<ResultCache> _cache;
 };
\ No newline at end of file
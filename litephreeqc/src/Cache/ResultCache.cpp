@@ -0,0 +1,141 @@
+/*
+ * This project is subject to the original PHREEQC license. `litephreeqc` is a
+ * version of the PHREEQC code that has been modified to be used as a library.
+ *
+ * It adds a C++ interface on top of the original PHREEQC code, with small
+ * changes to the original code base.
+ *
+ * Authors of Modifications:
+ * - Max Luebke (mluebke@uni-potsdam.de) - University of Potsdam
+ * - Marco De Lucia (delucia@gfz.de) - GFZ Helmholz Centre for Geosciences
+ *
+ */
+
+#include "ResultCache.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+// approximated bookkeeping costs of a single entry besides keys and results,
+// i.e. the list and hash map nodes
+constexpr std::size_t ENTRY_OVERHEAD = 128;
+} // namespace
+
+ResultCache::ResultCache(std::size_t max_bytes, double tolerance)
+    : _max_bytes(max_bytes), _tolerance(tolerance) {
+  if (!(tolerance >= 0) || tolerance >= 1) {
+    throw std::invalid_argument("Tolerance of the cache must be in [0, 1)");
+  }
+}
+
+ResultCache::Key ResultCache::makeKey(int id, double time_step,
+                                      std::span<const double> input) const {
+  Key key;
+  key.reserve(2 + (this->_tolerance > 0 ? 2 : 1) * input.size());
+
+  key.push_back(id);
+  key.push_back(std::bit_cast<std::int64_t>(time_step));
+
+  for (const double value : input) {
+    if (this->_tolerance == 0 || !std::isfinite(value)) {
+      // +0 and -0 are the same input
+      key.push_back(std::bit_cast<std::int64_t>(value == 0 ? 0. : value));
+      continue;
+    }
+
+    int exponent;
+    const double mantissa = std::frexp(value, &exponent);
+
+    key.push_back(exponent);
+    key.push_back(std::llround(mantissa / this->_tolerance));
+  }
+
+  return key;
+}
+
+std::size_t ResultCache::KeyHash::operator()(const Key &key) const {
+  // FNV-1a over the quantized values
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (const std::int64_t value : key) {
+    hash ^= static_cast<std::uint64_t>(value);
+    hash *= 1099511628211ULL;
+  }
+  return static_cast<std::size_t>(hash ^ (hash >> 32));
+}
+
+bool ResultCache::lookup(const Key &key, std::span<double> output) {
+  std::lock_guard<std::mutex> lock(this->_mtx);
+
+  const auto it = this->_index.find(key);
+
+  if (it == this->_index.end() || it->second->result.size() != output.size()) {
+    this->_stats.misses++;
+    return false;
+  }
+
+  this->_lru.splice(this->_lru.begin(), this->_lru, it->second);
+  std::memcpy(output.data(), it->second->result.data(),
+              output.size() * sizeof(double));
+
+  this->_stats.hits++;
+  return true;
+}
+
+void ResultCache::evict(std::size_t needed_bytes) {
+  while (!this->_lru.empty() &&
+         this->_stats.bytes + needed_bytes > this->_max_bytes) {
+    const Entry &last = this->_lru.back();
+
+    this->_stats.bytes -= last.bytes;
+    this->_stats.evictions++;
+
+    this->_index.erase(*last.key);
+    this->_lru.pop_back();
+  }
+}
+
+void ResultCache::insert(Key &&key, std::span<const double> result) {
+  const std::size_t bytes = key.size() * sizeof(std::int64_t) +
+                            result.size() * sizeof(double) + ENTRY_OVERHEAD;
+
+  if (bytes > this->_max_bytes) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(this->_mtx);
+
+  // another thread may have stored the same cell in the meantime
+  if (this->_index.find(key) != this->_index.end()) {
+    return;
+  }
+
+  this->evict(bytes);
+
+  this->_lru.push_front(
+      Entry{nullptr, std::vector<double>(result.begin(), result.end()), bytes});
+
+  const auto inserted =
+      this->_index.emplace(std::move(key), this->_lru.begin());
+  this->_lru.front().key = &inserted.first->first;
+
+  this->_stats.bytes += bytes;
+}
+
+void ResultCache::clear() {
+  std::lock_guard<std::mutex> lock(this->_mtx);
+
+  this->_index.clear();
+  this->_lru.clear();
+  this->_stats = Stats{};
+}
+
+ResultCache::Stats ResultCache::getStats() const {
+  std::lock_guard<std::mutex> lock(this->_mtx);
+
+  Stats stats = this->_stats;
+  stats.entries = this->_index.size();
+  return stats;
+}
@@ -0,0 +1,105 @@
+/*
+ * This project is subject to the original PHREEQC license. `litephreeqc` is a
+ * version of the PHREEQC code that has been modified to be used as a library.
+ *
+ * It adds a C++ interface on top of the original PHREEQC code, with small
+ * changes to the original code base.
+ *
+ * Authors of Modifications:
+ * - Max Luebke (mluebke@uni-potsdam.de) - University of Potsdam
+ * - Marco De Lucia (delucia@gfz.de) - GFZ Helmholz Centre for Geosciences
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Thread-safe LRU cache of cell results keyed on quantized inputs.
+ *
+ * The key of a cell consists of its cell template ID, the time step and its
+ * input values. With a tolerance of 0 the inputs are compared bit by bit.
+ * Otherwise the mantissa of each value is rounded to a multiple of the
+ * relative tolerance, so inputs differing by less than roughly this fraction
+ * share an entry.
+ *
+ * The memory used by keys and results is bounded by a budget given in bytes;
+ * once exceeded, the least recently used entries are evicted.
+ */
+class ResultCache {
+public:
+  /**
+   * @brief Counters of the cache since construction or the last clear().
+   */
+  struct Stats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+  };
+
+  using Key = std::vector<std::int64_t>;
+
+  ResultCache(std::size_t max_bytes, double tolerance);
+
+  /**
+   * @brief Builds the key of a cell from its template ID, time step and
+   * input values.
+   */
+  Key makeKey(int id, double time_step, std::span<const double> input) const;
+
+  /**
+   * @brief Copies the cached result of `key` to `output` if present.
+   *
+   * @return true on a hit. The entry becomes the most recently used one.
+   */
+  bool lookup(const Key &key, std::span<double> output);
+
+  /**
+   * @brief Stores the result of `key`, evicting old entries if needed.
+   *
+   * Entries larger than the whole budget are not stored.
+   */
+  void insert(Key &&key, std::span<const double> result);
+
+  void clear();
+
+  Stats getStats() const;
+
+  std::size_t maxBytes() const { return _max_bytes; }
+
+  double tolerance() const { return _tolerance; }
+
+private:
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const;
+  };
+
+  struct Entry {
+    const Key *key;
+    std::vector<double> result;
+    std::size_t bytes;
+  };
+
+  using LruList = std::list<Entry>;
+
+  void evict(std::size_t needed_bytes);
+
+  const std::size_t _max_bytes;
+  const double _tolerance;
+
+  // most recently used entry first; the map owns the keys
+  LruList _lru;
+  std::unordered_map<Key, LruList::iterator, KeyHash> _index;
+
+  mutable std::mutex _mtx;
+  Stats _stats;
+};
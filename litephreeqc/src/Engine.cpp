@@ -13,13 +13,19 @@
 
 #include "PhreeqcEngine.hpp"
 #include <cstddef>
-#include <iomanip>
+#include <map>
+#include <memory>
 #include <regex>
 #include <span>
-#include <sstream>
+#include <utility>
 
+#include <GasPhase.h>
 #include <IPhreeqc.hpp>
 #include <Phreeqc.h>
+#include <Pressure.h>
+#include <Reaction.h>
+#include <SSassemblage.h>
+#include <Temperature.h>
 #include <string>
 #include <vector>
 
@@ -33,6 +39,10 @@
 class PhreeqcEngine::Impl : public IPhreeqc {
 public:
   Impl(const PhreeqcMatrix &pqc_mat, const int cell_id);
+  Impl(const PhreeqcMatrix &pqc_mat,
+       std::shared_ptr<const PhreeqcEngine::Templates> templates);
+  // only holds the reactants of all cell templates, see Templates
+  explicit Impl(const PhreeqcMatrix &pqc_mat);
   void run(double time_step);
 
   cxxSolution *Get_solution(std::size_t n) {
@@ -60,16 +70,6 @@ public:
 
   void set_essential_values(const std::span<double> &data);
 
-  std::unique_ptr<SolutionWrapper> solutionWrapperPtr;
-  std::unique_ptr<ExchangeWrapper> exchangeWrapperPtr;
-  std::unique_ptr<KineticWrapper> kineticsWrapperPtr;
-  std::unique_ptr<EquilibriumWrapper> equilibriumWrapperPtr;
-  std::unique_ptr<SurfaceWrapper> surfaceWrapperPtr;
-
-  bool has_exchange = false;
-  bool has_kinetics = false;
-  bool has_equilibrium = false;
-  bool has_surface = false;
   struct InitCell {
     std::vector<std::string> solutions;
     bool with_redox;
@@ -80,49 +80,277 @@ public:
     std::vector<std::string> surface_charges;
     std::vector<std::string> solution_primaries;
   };
-  void init_wrappers(const InitCell &cell);
+
+  /**
+   * Wrappers pointing to the reactants of one cell template. The reactants
+   * are stored under `phreeqc_id` in the Phreeqc instance of the engine.
+   */
+  struct CellBinding {
+    int phreeqc_id;
+
+    std::unique_ptr<SolutionWrapper> solutionWrapperPtr;
+    std::unique_ptr<ExchangeWrapper> exchangeWrapperPtr;
+    std::unique_ptr<KineticWrapper> kineticsWrapperPtr;
+    std::unique_ptr<EquilibriumWrapper> equilibriumWrapperPtr;
+    std::unique_ptr<SurfaceWrapper> surfaceWrapperPtr;
+
+    bool has_exchange = false;
+    bool has_kinetics = false;
+    bool has_equilibrium = false;
+    bool has_surface = false;
+  };
+
+  void load_database(const PhreeqcMatrix &pqc_mat);
+
+  InitCell get_init_cell(const PhreeqcMatrix &pqc_mat, int cell_id) const;
+
+  void init_wrappers(CellBinding &binding, const InitCell &cell);
+
+  void bind(int cell_id);
+
+  void swap_in(int cell_id);
+
+  std::map<int, CellBinding> cells;
+  int bound_id;
+  CellBinding *bound;
+
+  // reactants of all cell templates, the bound one is copied into the
+  // reactants with ID 1 by bind(); null for an engine of a single cell
+  std::shared_ptr<const PhreeqcEngine::Templates> templates;
+
+  bool reset_start_values = false;
 };
 
 PhreeqcEngine::PhreeqcEngine(const PhreeqcMatrix &pqc_mat, const int cell_id)
     : impl(std::make_unique<Impl>(pqc_mat, cell_id)) {}
 
+PhreeqcEngine::PhreeqcEngine(const PhreeqcMatrix &pqc_mat)
+    : PhreeqcEngine(pqc_mat, std::make_shared<const Templates>(pqc_mat)) {}
+
+PhreeqcEngine::PhreeqcEngine(const PhreeqcMatrix &pqc_mat,
+                             std::shared_ptr<const Templates> templates)
+    : impl(std::make_unique<Impl>(pqc_mat, std::move(templates))) {}
+
 PhreeqcEngine::~PhreeqcEngine() = default;
 
+struct PhreeqcEngine::Templates::Data {
+  explicit Data(const PhreeqcMatrix &pqc_mat) : store(pqc_mat) {
+    for (const auto &id : pqc_mat.getIds()) {
+      this->cells[id] = this->store.get_init_cell(pqc_mat, id);
+    }
+  }
+
+  // never changed after construction, so engines of several threads can copy
+  // the reactants at the same time
+  Impl store;
+  std::map<int, Impl::InitCell> cells;
+};
+
+PhreeqcEngine::Templates::Templates(const PhreeqcMatrix &pqc_mat)
+    : data(std::make_unique<Data>(pqc_mat)) {}
+
+PhreeqcEngine::Templates::~Templates() = default;
+
 static inline std::string
 replaceRawKeywordID(const std::string &raw_dump_string) {
   std::regex re(R"((RAW\s+)(\d+))");
   return std::regex_replace(raw_dump_string, re, "RAW 1");
 }
 
+void PhreeqcEngine::Impl::load_database(const PhreeqcMatrix &pqc_mat) {
+  const Phreeqc *prototype = pqc_mat.getDatabasePrototype();
+
+  if (prototype != nullptr) {
+    // Clone the already parsed database. The Phreeqc instance is freshly
+    // initialized by IPhreeqc's constructor, just as Phreeqc's copy
+    // constructor expects it.
+    this->PhreeqcPtr->InternalCopy(prototype);
+    this->DatabaseLoaded = true;
+  } else {
+    this->LoadDatabaseString(pqc_mat.getDatabase().c_str());
+  }
+
+  pqc_mat.getKnobs().writeKnobs(this->PhreeqcPtr);
+}
+
+PhreeqcEngine::Impl::InitCell
+PhreeqcEngine::Impl::get_init_cell(const PhreeqcMatrix &pqc_mat,
+                                   int cell_id) const {
+  return {pqc_mat.getSolutionNames(),
+          pqc_mat.withRedox(),
+          pqc_mat.getExchanger(cell_id),
+          pqc_mat.getKineticsNames(cell_id),
+          pqc_mat.getEquilibriumNames(cell_id),
+          pqc_mat.getSurfaceCompNames(cell_id),
+          pqc_mat.getSurfaceChargeNames(cell_id),
+          pqc_mat.getSolutionPrimaries()};
+}
+
 PhreeqcEngine::Impl::Impl(const PhreeqcMatrix &pqc_mat, const int cell_id) {
 
   if (!pqc_mat.checkIfExists(cell_id)) {
     throw std::invalid_argument("Cell ID does not exist in PhreeqcMatrix");
   }
 
-  this->LoadDatabaseString(pqc_mat.getDatabase().c_str());
-
-  pqc_mat.getKnobs().writeKnobs(this->PhreeqcPtr);
+  this->load_database(pqc_mat);
 
   const std::string pqc_string =
       replaceRawKeywordID(pqc_mat.getDumpStringsPQI(cell_id));
 
   this->RunString(pqc_string.c_str());
 
-  InitCell cell = {pqc_mat.getSolutionNames(),
-                   pqc_mat.withRedox(),
-                   pqc_mat.getExchanger(cell_id),
-                   pqc_mat.getKineticsNames(cell_id),
-                   pqc_mat.getEquilibriumNames(cell_id),
-                   pqc_mat.getSurfaceCompNames(cell_id),
-                   pqc_mat.getSurfaceChargeNames(cell_id),
-                   pqc_mat.getSolutionPrimaries()};
+  CellBinding &binding = this->cells[cell_id];
+  binding.phreeqc_id = 1;
+
+  this->init_wrappers(binding, this->get_init_cell(pqc_mat, cell_id));
+
+  this->bind(cell_id);
+}
+
+PhreeqcEngine::Impl::Impl(const PhreeqcMatrix &pqc_mat) {
+  const auto ids = pqc_mat.getIds();
+
+  if (ids.empty()) {
+    throw std::invalid_argument("PhreeqcMatrix does not contain any cell");
+  }
+
+  this->load_database(pqc_mat);
 
-  this->init_wrappers(cell);
+  // reactants of all cell templates are kept under their original ID
+  for (const auto &id : ids) {
+    this->RunString(pqc_mat.getDumpStringsPQI(id).c_str());
+  }
+}
+
+PhreeqcEngine::Impl::Impl(
+    const PhreeqcMatrix &pqc_mat,
+    std::shared_ptr<const PhreeqcEngine::Templates> templates)
+    : templates(std::move(templates)) {
+  this->load_database(pqc_mat);
+
+  // the wrappers of a cell template are created when it is bound, as they
+  // point to the reactants copied for it
+  for (const auto &[id, _] : this->templates->data->cells) {
+    this->cells[id].phreeqc_id = 1;
+  }
+
+  this->bind(this->cells.begin()->first);
+}
+
+template <typename T>
+static void copy_reactant(std::map<int, T> &to, std::map<int, T> &from,
+                          int n_user, PHRQ_io *io) {
+  const auto it = from.find(n_user);
+
+  if (it == from.end()) {
+    to.erase(1);
+    return;
+  }
+
+  T &reactant = to.insert_or_assign(1, it->second).first->second;
+  reactant.Set_n_user_both(1);
+  reactant.Set_io(io);
+}
+
+void PhreeqcEngine::Impl::swap_in(int cell_id) {
+  // same reactants as written by 'DUMP -cells', without a mix
+  Phreeqc *from = this->templates->data->store.PhreeqcPtr;
+  Phreeqc *to = this->PhreeqcPtr;
+  PHRQ_io *io = to->Get_phrq_io();
+
+  copy_reactant(to->Get_Rxn_solution_map(), from->Get_Rxn_solution_map(),
+                cell_id, io);
+  copy_reactant(to->Get_Rxn_pp_assemblage_map(),
+                from->Get_Rxn_pp_assemblage_map(), cell_id, io);
+  copy_reactant(to->Get_Rxn_exchange_map(), from->Get_Rxn_exchange_map(),
+                cell_id, io);
+  copy_reactant(to->Get_Rxn_surface_map(), from->Get_Rxn_surface_map(),
+                cell_id, io);
+  copy_reactant(to->Get_Rxn_ss_assemblage_map(),
+                from->Get_Rxn_ss_assemblage_map(), cell_id, io);
+  copy_reactant(to->Get_Rxn_gas_phase_map(), from->Get_Rxn_gas_phase_map(),
+                cell_id, io);
+  copy_reactant(to->Get_Rxn_kinetics_map(), from->Get_Rxn_kinetics_map(),
+                cell_id, io);
+  copy_reactant(to->Get_Rxn_reaction_map(), from->Get_Rxn_reaction_map(),
+                cell_id, io);
+  copy_reactant(to->Get_Rxn_temperature_map(),
+                from->Get_Rxn_temperature_map(), cell_id, io);
+  copy_reactant(to->Get_Rxn_pressure_map(), from->Get_Rxn_pressure_map(),
+                cell_id, io);
+}
+
+void PhreeqcEngine::Impl::bind(int cell_id) {
+  auto it = this->cells.find(cell_id);
+
+  if (it == this->cells.end()) {
+    throw std::invalid_argument("Cell ID is not known to this PhreeqcEngine");
+  }
+
+  if (this->templates) {
+    this->swap_in(cell_id);
+    this->init_wrappers(it->second, this->templates->data->cells.at(cell_id));
+  }
+
+  this->bound_id = cell_id;
+  this->bound = &it->second;
+}
+
+void PhreeqcEngine::bindCell(int cell_id) {
+  if (cell_id == this->impl->bound_id) {
+    return;
+  }
+
+  this->impl->bind(cell_id);
+}
+
+int PhreeqcEngine::boundCell() const { return this->impl->bound_id; }
+
+void PhreeqcEngine::setResetStartValues(bool enable) {
+  this->impl->reset_start_values = enable;
+}
+
+PhreeqcEngine::SolverStats PhreeqcEngine::getSolverStats() const {
+  const Phreeqc *pqc = this->impl->GetPhreeqcPtr();
+
+  return {pqc->Get_count_ineq_dense(), pqc->Get_count_ineq_cl1(),
+          pqc->Get_count_same_model()};
+}
+
+PhreeqcEngine::LogKCacheStats PhreeqcEngine::getLogKCacheStats() const {
+  const Phreeqc *pqc = this->impl->GetPhreeqcPtr();
+
+  return {pqc->Get_logk_cache_hits(), pqc->Get_logk_cache_misses(),
+          pqc->Get_logk_cache_entries()};
 }
 
 void PhreeqcEngine::runCell(std::vector<double> &cell_values,
                             double time_step) {
+  this->run_cell(cell_values, time_step, nullptr);
+}
+
+struct PhreeqcEngine::CellState::Data {
+  int cell_id;
+  SolutionWrapper::ConvergedState solution;
+};
+
+PhreeqcEngine::CellState::CellState() = default;
+PhreeqcEngine::CellState::~CellState() = default;
+PhreeqcEngine::CellState::CellState(CellState &&) noexcept = default;
+PhreeqcEngine::CellState &
+PhreeqcEngine::CellState::operator=(CellState &&) noexcept = default;
+
+bool PhreeqcEngine::CellState::empty() const { return !this->data; }
+
+void PhreeqcEngine::CellState::clear() { this->data.reset(); }
+
+void PhreeqcEngine::runCell(std::vector<double> &cell_values,
+                            double time_step, CellState &state) {
+  this->run_cell(cell_values, time_step, &state);
+}
+
+void PhreeqcEngine::run_cell(std::vector<double> &cell_values,
+                             double time_step, CellState *state) {
 
   if (time_step < 0) {
     throw std::invalid_argument("Time step must be positive");
@@ -131,134 +359,171 @@ void PhreeqcEngine::runCell(std::vector<double> &cell_values,
   // ID is already skipped by PhreeqcRunner, so no need to start ahead
   std::span<double> cell_data{cell_values.begin(), cell_values.end()};
 
+  if (state != nullptr && state->data &&
+      state->data->cell_id != this->impl->bound_id) {
+    state->clear();
+  }
+
   this->impl->set_essential_values(cell_data);
+
+  SolutionWrapper &solution = *this->impl->bound->solutionWrapperPtr;
+
+  if (state != nullptr) {
+    if (state->data) {
+      solution.warm_start(state->data->solution);
+    } else {
+      state->data = std::make_unique<CellState::Data>();
+      state->data->cell_id = this->impl->bound_id;
+    }
+  }
+
   this->impl->run(time_step);
+
+  if (state != nullptr) {
+    solution.save_state(state->data->solution);
+  }
   this->impl->get_essential_values(cell_data);
 }
 
 void PhreeqcEngine::Impl::run(double time_step) {
-  std::stringstream time_ss;
-  time_ss << std::fixed << std::setprecision(20) << time_step;
-
-  const std::string runs_string =
-      "RUN_CELLS\n -cells 1\n -time_step " + time_ss.str() + "\nEND\n";
-  this->RunString(runs_string.c_str());
+  // equivalent to 'RUN_CELLS -cells <id> -time_step <dt>', but without
+  // formatting and parsing an input string for every single step
+  int input_errors;
+  try {
+    // clears errors and warnings of the previous step, as RunString does
+    this->check_database("run");
+
+    input_errors =
+        this->PhreeqcPtr->run_cell_step(this->bound->phreeqc_id, time_step);
+  } catch (const IPhreeqcStop &) {
+    input_errors = 1;
+  } catch (const PhreeqcStop &) {
+    input_errors = 1;
+  }
 
-  if (this->GetErrorStringLineCount() > 0) {
+  if (input_errors > 0) {
+    this->update_errors();
     std::cerr << ":: Error in Phreeqc script: " << this->GetErrorString()
               << "\n";
     throw std::runtime_error("Phreeqc script error");
   }
 }
 
-void PhreeqcEngine::Impl::init_wrappers(const InitCell &cell) {
+void PhreeqcEngine::Impl::init_wrappers(CellBinding &binding,
+                                        const InitCell &cell) {
+  const int id = binding.phreeqc_id;
 
   // Solutions
-  this->solutionWrapperPtr = std::make_unique<SolutionWrapper>(
-      this->Get_solution(1), cell.solutions, cell.with_redox);
+  binding.solutionWrapperPtr = std::make_unique<SolutionWrapper>(
+      this->Get_solution(id), cell.solutions, cell.with_redox);
 
-  if (this->Get_exchange(1) != nullptr) {
-    this->exchangeWrapperPtr = std::make_unique<ExchangeWrapper>(
-        this->Get_exchange(1), cell.exchanger);
-    this->has_exchange = true;
+  if (this->Get_exchange(id) != nullptr) {
+    binding.exchangeWrapperPtr = std::make_unique<ExchangeWrapper>(
+        this->Get_exchange(id), cell.exchanger);
+    binding.has_exchange = true;
   }
 
-  if (this->Get_kinetic(1) != nullptr) {
-    this->kineticsWrapperPtr =
-        std::make_unique<KineticWrapper>(this->Get_kinetic(1), cell.kinetics);
+  if (this->Get_kinetic(id) != nullptr) {
+    binding.kineticsWrapperPtr =
+        std::make_unique<KineticWrapper>(this->Get_kinetic(id), cell.kinetics);
 
-    this->has_kinetics = true;
+    binding.has_kinetics = true;
   }
 
-  if (this->Get_equilibrium(1) != nullptr) {
-    this->equilibriumWrapperPtr = std::make_unique<EquilibriumWrapper>(
-        this->Get_equilibrium(1), cell.equilibrium);
+  if (this->Get_equilibrium(id) != nullptr) {
+    binding.equilibriumWrapperPtr = std::make_unique<EquilibriumWrapper>(
+        this->Get_equilibrium(id), cell.equilibrium);
 
-    this->has_equilibrium = true;
+    binding.has_equilibrium = true;
   }
 
-  if (this->Get_surface(1) != nullptr) {
+  if (this->Get_surface(id) != nullptr) {
     std::set<std::string> primaries(cell.solution_primaries.begin(),
                                     cell.solution_primaries.end());
-    this->surfaceWrapperPtr = std::make_unique<SurfaceWrapper>(
-        this->Get_surface(1), primaries, cell.surface_comps,
+    binding.surfaceWrapperPtr = std::make_unique<SurfaceWrapper>(
+        this->Get_surface(id), primaries, cell.surface_comps,
         cell.surface_charges);
 
-    this->has_surface = true;
+    binding.has_surface = true;
   }
 }
 
 void PhreeqcEngine::Impl::get_essential_values(std::span<double> &data) {
+  const CellBinding &binding = *this->bound;
 
-  this->solutionWrapperPtr->get(data);
+  binding.solutionWrapperPtr->get(data);
 
-  std::size_t offset = this->solutionWrapperPtr->size();
+  std::size_t offset = binding.solutionWrapperPtr->size();
 
-  if (this->has_exchange) {
+  if (binding.has_exchange) {
     std::span<double> exch_span{
-        data.subspan(offset, this->exchangeWrapperPtr->size())};
-    this->exchangeWrapperPtr->get(exch_span);
+        data.subspan(offset, binding.exchangeWrapperPtr->size())};
+    binding.exchangeWrapperPtr->get(exch_span);
 
-    offset += this->exchangeWrapperPtr->size();
+    offset += binding.exchangeWrapperPtr->size();
   }
 
-  if (this->has_kinetics) {
+  if (binding.has_kinetics) {
     std::span<double> kin_span{
-        data.subspan(offset, this->kineticsWrapperPtr->size())};
-    this->kineticsWrapperPtr->get(kin_span);
+        data.subspan(offset, binding.kineticsWrapperPtr->size())};
+    binding.kineticsWrapperPtr->get(kin_span);
 
-    offset += this->kineticsWrapperPtr->size();
+    offset += binding.kineticsWrapperPtr->size();
   }
 
-  if (this->has_equilibrium) {
+  if (binding.has_equilibrium) {
     std::span<double> equ_span{
-        data.subspan(offset, this->equilibriumWrapperPtr->size())};
-    this->equilibriumWrapperPtr->get(equ_span);
+        data.subspan(offset, binding.equilibriumWrapperPtr->size())};
+    binding.equilibriumWrapperPtr->get(equ_span);
 
-    offset += this->equilibriumWrapperPtr->size();
+    offset += binding.equilibriumWrapperPtr->size();
   }
 
-  if (this->has_surface) {
+  if (binding.has_surface) {
     std::span<double> surf_span{
-        data.subspan(offset, this->surfaceWrapperPtr->size())};
-    this->surfaceWrapperPtr->get(surf_span);
+        data.subspan(offset, binding.surfaceWrapperPtr->size())};
+    binding.surfaceWrapperPtr->get(surf_span);
   }
 }
 
 void PhreeqcEngine::Impl::set_essential_values(const std::span<double> &data) {
+  CellBinding &binding = *this->bound;
 
-  this->solutionWrapperPtr->set(data);
+  binding.solutionWrapperPtr->set(data);
+  if (this->reset_start_values) {
+    binding.solutionWrapperPtr->restore_initial_guesses();
+  }
   // this->PhreeqcPtr->initial_solutions_poet(1);
 
-  std::size_t offset = this->solutionWrapperPtr->size();
+  std::size_t offset = binding.solutionWrapperPtr->size();
 
-  if (this->has_exchange) {
+  if (binding.has_exchange) {
     std::span<double> exch_span{
-        data.subspan(offset, this->exchangeWrapperPtr->size())};
-    this->exchangeWrapperPtr->set(exch_span);
+        data.subspan(offset, binding.exchangeWrapperPtr->size())};
+    binding.exchangeWrapperPtr->set(exch_span);
 
-    offset += this->exchangeWrapperPtr->size();
+    offset += binding.exchangeWrapperPtr->size();
   }
 
-  if (this->has_kinetics) {
+  if (binding.has_kinetics) {
     std::span<double> kin_span{
-        data.subspan(offset, this->kineticsWrapperPtr->size())};
-    this->kineticsWrapperPtr->set(kin_span);
+        data.subspan(offset, binding.kineticsWrapperPtr->size())};
+    binding.kineticsWrapperPtr->set(kin_span);
 
-    offset += this->kineticsWrapperPtr->size();
+    offset += binding.kineticsWrapperPtr->size();
   }
 
-  if (this->has_equilibrium) {
+  if (binding.has_equilibrium) {
     std::span<double> equ_span{
-        data.subspan(offset, this->equilibriumWrapperPtr->size())};
-    this->equilibriumWrapperPtr->set(equ_span);
+        data.subspan(offset, binding.equilibriumWrapperPtr->size())};
+    binding.equilibriumWrapperPtr->set(equ_span);
 
-    offset += this->equilibriumWrapperPtr->size();
+    offset += binding.equilibriumWrapperPtr->size();
   }
 
-  if (this->has_surface) {
+  if (binding.has_surface) {
     std::span<double> surf_span{
-        data.subspan(offset, this->surfaceWrapperPtr->size())};
-    this->surfaceWrapperPtr->set(surf_span);
+        data.subspan(offset, binding.surfaceWrapperPtr->size())};
+    binding.surfaceWrapperPtr->set(surf_span);
   }
 }
@@ -27,6 +27,16 @@ void PhreeqcKnobs::readKnobs(Phreeqc *pqc_instance) {
   this->_params.pe_step_size = pqc_instance->pe_step_size;
   this->_params.diagonal_scale =
       static_cast<bool>(pqc_instance->diagonal_scale);
+  this->_params.cl1_compensated_sum =
+      static_cast<bool>(pqc_instance->cl1_compensated_sum);
+  this->_params.dense_linear_solver =
+      static_cast<bool>(pqc_instance->dense_linear_solver);
+  this->_params.vectorized_gammas =
+      static_cast<bool>(pqc_instance->vectorized_gammas);
+  this->_params.compiled_rates =
+      static_cast<bool>(pqc_instance->compiled_rates);
+  this->_params.cvode_jacobian_threads = pqc_instance->cvode_jacobian_threads;
+  this->_params.cvode_jacobian_reuse = pqc_instance->cvode_jacobian_reuse;
 }
 
 void PhreeqcKnobs::writeKnobs(Phreeqc *pqc_instance) const {
@@ -36,4 +46,10 @@ void PhreeqcKnobs::writeKnobs(Phreeqc *pqc_instance) const {
   pqc_instance->step_size = this->_params.step_size;
   pqc_instance->pe_step_size = this->_params.pe_step_size;
   pqc_instance->diagonal_scale = this->_params.diagonal_scale;
+  pqc_instance->cl1_compensated_sum = this->_params.cl1_compensated_sum;
+  pqc_instance->dense_linear_solver = this->_params.dense_linear_solver;
+  pqc_instance->vectorized_gammas = this->_params.vectorized_gammas;
+  pqc_instance->compiled_rates = this->_params.compiled_rates;
+  pqc_instance->cvode_jacobian_threads = this->_params.cvode_jacobian_threads;
+  pqc_instance->cvode_jacobian_reuse = this->_params.cvode_jacobian_reuse;
 }
\ No newline at end of file
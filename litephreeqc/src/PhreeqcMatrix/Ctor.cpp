@@ -29,6 +29,11 @@ PhreeqcMatrix::PhreeqcMatrix(const std::string &database,
   this->_m_pqc = std::make_shared<IPhreeqc>();
 
   this->_m_pqc->LoadDatabaseString(database.c_str());
+
+  // keep a copy of the parsed database before the input script is run
+  this->_m_db_prototype =
+      std::make_shared<const Phreeqc>(*this->_m_pqc->GetPhreeqcPtr());
+
   this->_m_pqc->RunString(input_script.c_str());
 
   if (this->_m_pqc->GetErrorStringLineCount() > 0) {
@@ -14,61 +14,187 @@
 #include "PhreeqcEngine.hpp"
 #include "PhreeqcMatrix.hpp"
 #include "PhreeqcRunner.hpp"
-#include <algorithm>
+#include "Cache/ResultCache.hpp"
+#include "Scheduler/WorkStealingScheduler.hpp"
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <memory>
 #include <set>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
-PhreeqcRunner::PhreeqcRunner(const PhreeqcMatrix &matrix) {
-  // first make sure to have enough space in our buffer
-  this->_buffer.reserve(matrix.get().names.size());
+PhreeqcRunner::PhreeqcRunner(const PhreeqcMatrix &matrix,
+                             std::size_t num_threads, EngineMode mode) {
+  if (num_threads == 0) {
+    throw std::invalid_argument("Number of threads must be at least 1");
+  }
+
+  this->_threadEngines.resize(num_threads);
+  this->_buffers.resize(num_threads);
+
+  const auto stl_mat = matrix.get();
+  const std::size_t num_columns = stl_mat.names.size();
 
-  // Create a PhreeqcEngine for each id
-  for (const auto &id : matrix.getIds()) {
-    this->_engineStorage[id] = std::make_unique<PhreeqcEngine>(matrix, id);
+  this->_numColumns = num_columns;
+
+  for (std::size_t row = 0; row < stl_mat.values.size() / num_columns; row++) {
+    const double *values = stl_mat.values.data() + row * num_columns;
+    auto &columns = this->_columnMaps[static_cast<int>(values[0])];
+
+    for (std::size_t col = 1; col < num_columns; col++) {
+      if (!std::isnan(values[col])) {
+        columns.push_back(col);
+      }
+    }
   }
-}
 
-static void copy_to_buffer(std::vector<double> &buffer,
-                           const std::vector<double> &current_inout) {
-  for (std::size_t j = 1; j < current_inout.size(); j++) {
-    if (std::isnan(current_inout[j])) {
+  // reactants of all cell templates, shared by the engines of a pool
+  std::shared_ptr<const PhreeqcEngine::Templates> templates;
+
+  if (mode == EngineMode::POOL) {
+    templates = std::make_shared<const PhreeqcEngine::Templates>(matrix);
+  }
+
+  for (std::size_t thread = 0; thread < num_threads; thread++) {
+    // first make sure to have enough space in our buffer
+    this->_buffers[thread].reserve(num_columns);
+
+    if (mode == EngineMode::POOL) {
+      // A single engine serving all ids
+      this->_engineStorage.push_back(
+          std::make_unique<PhreeqcEngine>(matrix, templates));
+
+      for (const auto &id : matrix.getIds()) {
+        this->_threadEngines[thread][id] = this->_engineStorage.back().get();
+      }
       continue;
     }
-    buffer.push_back(current_inout[j]);
+
+    // Create a PhreeqcEngine for each id
+    for (const auto &id : matrix.getIds()) {
+      this->_engineStorage.push_back(
+          std::make_unique<PhreeqcEngine>(matrix, id));
+      this->_threadEngines[thread][id] = this->_engineStorage.back().get();
+    }
   }
+
+  // threads take the cells in no fixed order, so each step has to start from
+  // the values of its cell template
+  this->setResetStartValues(num_threads > 1);
+
+  this->_scheduler = std::make_unique<WorkStealingScheduler>(num_threads);
 }
 
-static void copy_from_buffer(const std::vector<double> &buffer,
-                             std::vector<double> &current_inout) {
-  std::size_t buffer_index = 0;
-  for (std::size_t j = 1; j < current_inout.size(); j++) {
-    if (std::isnan(current_inout[j])) {
-      continue;
+PhreeqcRunner::~PhreeqcRunner() = default;
+
+void PhreeqcRunner::run_cell(std::size_t thread, double *cell,
+                              std::size_t stride, double time_step,
+                              std::size_t row) {
+  const auto pqc_id = static_cast<int>(cell[0]);
+
+  PhreeqcEngine *engine = this->_threadEngines[thread].at(pqc_id);
+  const auto &columns = this->_columnMaps.at(pqc_id);
+
+  // gather the values of the cell template, skipping the ID and unused
+  // columns, into the buffer; it never grows beyond the number of columns
+  auto &buffer = this->_buffers[thread];
+  buffer.resize(columns.size());
+
+  for (std::size_t k = 0; k < columns.size(); k++) {
+    buffer[k] = cell[columns[k] * stride];
+  }
+
+  ResultCache::Key key;
+  bool cached = false;
+
+  if (this->_cache) {
+    key = this->_cache->makeKey(pqc_id, time_step, buffer);
+    cached = this->_cache->lookup(key, buffer);
+  }
+
+  if (!cached) {
+    engine->bindCell(pqc_id);
+
+    if (this->_warm_start) {
+      engine->runCell(buffer, time_step, this->_cellStates[row]);
+    } else {
+      engine->runCell(buffer, time_step);
     }
-    current_inout[j] = buffer[buffer_index++];
+
+    if (this->_cache) {
+      this->_cache->insert(std::move(key), buffer);
+    }
+  }
+
+  for (std::size_t k = 0; k < columns.size(); k++) {
+    cell[columns[k] * stride] = buffer[k];
   }
 }
 
-void PhreeqcRunner::run(std::vector<std::vector<double>> &simulationInOut,
-                        const double time_step) {
-  for (std::size_t i = 0; i < simulationInOut.size(); i++) {
-    const auto &current_inout = simulationInOut[i];
-    const auto pqc_id = static_cast<int>(current_inout[0]);
+void PhreeqcRunner::prepare_states(std::size_t num_rows) {
+  if (this->_warm_start && this->_cellStates.size() != num_rows) {
+    this->_cellStates.clear();
+    this->_cellStates.resize(num_rows);
+  }
+}
+
+void PhreeqcRunner::run_cells(std::vector<std::vector<double>> &simulationInOut,
+                              const double time_step,
+                              const std::vector<std::size_t> &cell_indices) {
+  for (const auto i : cell_indices) {
+    if (simulationInOut[i].size() != this->_numColumns) {
+      throw std::invalid_argument(
+          "Number of values of a cell doesn't match the PhreeqcMatrix");
+    }
+  }
 
-    this->_buffer.clear();
+  this->prepare_states(simulationInOut.size());
 
-    // Copy the input to the buffer while ignoring the first element and NaNs
-    copy_to_buffer(this->_buffer, current_inout);
+  this->_scheduler->run(
+      cell_indices.size(), [&](std::size_t thread, std::size_t task) {
+        const std::size_t i = cell_indices[task];
 
-    this->_engineStorage.at(pqc_id)->runCell(this->_buffer, time_step);
+        this->run_cell(thread, simulationInOut[i].data(), 1, time_step, i);
+      });
+}
 
-    // Copy the buffer back to the output while ignoring the first element and
-    // NaNs
-    copy_from_buffer(this->_buffer, simulationInOut[i]);
+void PhreeqcRunner::run(std::span<double> field, std::size_t ncols,
+                        const double time_step, Layout layout) {
+  if (ncols != this->_numColumns) {
+    throw std::invalid_argument(
+        "Number of columns doesn't match the PhreeqcMatrix");
   }
+
+  if (field.size() % ncols != 0) {
+    throw std::invalid_argument(
+        "Size of the field is not a multiple of the number of columns");
+  }
+
+  const std::size_t num_rows = field.size() / ncols;
+
+  this->prepare_states(num_rows);
+
+  const bool row_major = layout == Layout::ROW_MAJOR;
+  const std::size_t stride = row_major ? 1 : num_rows;
+
+  this->_scheduler->run(num_rows, [&](std::size_t thread, std::size_t row) {
+    double *cell = field.data() + (row_major ? row * ncols : row);
+
+    this->run_cell(thread, cell, stride, time_step, row);
+  });
+}
+
+void PhreeqcRunner::run(std::vector<std::vector<double>> &simulationInOut,
+                        const double time_step) {
+  std::vector<std::size_t> cell_indices(simulationInOut.size());
+
+  for (std::size_t i = 0; i < cell_indices.size(); i++) {
+    cell_indices[i] = i;
+  }
+
+  this->run_cells(simulationInOut, time_step, cell_indices);
 }
 
 void PhreeqcRunner::run(std::vector<std::vector<double>> &simulationInOut,
@@ -76,23 +202,88 @@ void PhreeqcRunner::run(std::vector<std::vector<double>> &simulationInOut,
                         const std::vector<std::size_t> &to_ignore) {
   const std::set<std::size_t> to_ignore_set(to_ignore.begin(), to_ignore.end());
 
+  std::vector<std::size_t> cell_indices;
+  cell_indices.reserve(simulationInOut.size());
+
   for (std::size_t i = 0; i < simulationInOut.size(); i++) {
     if (to_ignore_set.find(i) != to_ignore_set.end()) {
       continue;
     }
+    cell_indices.push_back(i);
+  }
+
+  this->run_cells(simulationInOut, time_step, cell_indices);
+}
+
+void PhreeqcRunner::setWarmStart(bool enable) {
+  this->_warm_start = enable;
+
+  if (!enable) {
+    this->_cellStates.clear();
+  }
+}
+
+void PhreeqcRunner::setResetStartValues(bool enable) {
+  this->_reset_start_values = enable;
+
+  for (auto &engine : this->_engineStorage) {
+    engine->setResetStartValues(enable);
+  }
+}
 
-    const auto &current_inout = simulationInOut[i];
-    const auto pqc_id = static_cast<int>(current_inout[0]);
+void PhreeqcRunner::setResultCache(std::size_t max_bytes, double tolerance) {
+  if (max_bytes == 0) {
+    this->_cache.reset();
+    return;
+  }
 
-    this->_buffer.clear();
+  this->_cache = std::make_unique<ResultCache>(max_bytes, tolerance);
+}
 
-    // Copy the input to the buffer while ignoring the first element and NaNs
-    copy_to_buffer(this->_buffer, current_inout);
+void PhreeqcRunner::clearResultCache() {
+  if (this->_cache) {
+    this->_cache->clear();
+  }
+}
 
-    this->_engineStorage.at(pqc_id)->runCell(this->_buffer, time_step);
+PhreeqcRunner::CacheStats PhreeqcRunner::getCacheStats() const {
+  if (!this->_cache) {
+    return {};
+  }
+
+  const auto stats = this->_cache->getStats();
+  return {stats.hits, stats.misses, stats.evictions, stats.entries,
+          stats.bytes};
+}
 
-    // Copy the buffer back to the output while ignoring the first element and
-    // NaNs
-    copy_from_buffer(this->_buffer, simulationInOut[i]);
+PhreeqcEngine::SolverStats PhreeqcRunner::getSolverStats() const {
+  PhreeqcEngine::SolverStats result;
+
+  for (const auto &engine : this->_engineStorage) {
+    const auto stats = engine->getSolverStats();
+    result.dense_solves += stats.dense_solves;
+    result.cl1_solves += stats.cl1_solves;
+    result.model_reuses += stats.model_reuses;
   }
-}
\ No newline at end of file
+
+  return result;
+}
+
+PhreeqcEngine::LogKCacheStats PhreeqcRunner::getLogKCacheStats() const {
+  if (this->_engineStorage.empty()) {
+    return {};
+  }
+
+  return this->_engineStorage.front()->getLogKCacheStats();
+}
+
+std::vector<PhreeqcRunner::ThreadStats> PhreeqcRunner::getThreadStats() const {
+  std::vector<ThreadStats> result;
+
+  for (const auto &stats : this->_scheduler->getStats()) {
+    const std::chrono::duration<double> busy = stats.busy_time;
+    result.push_back({busy.count(), stats.tasks, stats.steals});
+  }
+
+  return result;
+}
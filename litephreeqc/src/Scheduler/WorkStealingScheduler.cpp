@@ -0,0 +1,140 @@
+/*
+ * This project is subject to the original PHREEQC license. `litephreeqc` is a
+ * version of the PHREEQC code that has been modified to be used as a library.
+ *
+ * It adds a C++ interface on top of the original PHREEQC code, with small
+ * changes to the original code base.
+ *
+ * Authors of Modifications:
+ * - Max Luebke (mluebke@uni-potsdam.de) - University of Potsdam
+ * - Marco De Lucia (delucia@gfz.de) - GFZ Helmholz Centre for Geosciences
+ *
+ */
+
+#include "WorkStealingScheduler.hpp"
+
+#include <stdexcept>
+#include <thread>
+
+WorkStealingScheduler::WorkStealingScheduler(std::size_t num_workers)
+    : _num_workers(num_workers) {
+  if (num_workers == 0) {
+    throw std::invalid_argument("Number of workers must be at least 1");
+  }
+
+  this->_ranges = std::make_unique<TaskRange[]>(num_workers);
+  this->_stats.resize(num_workers);
+}
+
+bool WorkStealingScheduler::pop(std::size_t worker, std::size_t &task) {
+  TaskRange &own = this->_ranges[worker];
+  std::lock_guard<std::mutex> lock(own.mtx);
+
+  if (own.begin >= own.end) {
+    return false;
+  }
+
+  task = own.begin++;
+  return true;
+}
+
+bool WorkStealingScheduler::steal(std::size_t worker) {
+  for (std::size_t offset = 1; offset < this->_num_workers; offset++) {
+    TaskRange &victim = this->_ranges[(worker + offset) % this->_num_workers];
+
+    std::size_t stolen_begin;
+    std::size_t stolen_end;
+    {
+      std::lock_guard<std::mutex> lock(victim.mtx);
+
+      if (victim.begin >= victim.end) {
+        continue;
+      }
+
+      const std::size_t remaining = victim.end - victim.begin;
+
+      // take the upper half, the victim keeps working on the lower part
+      const std::size_t to_steal = (remaining + 1) / 2;
+      stolen_end = victim.end;
+      stolen_begin = victim.end - to_steal;
+      victim.end = stolen_begin;
+    }
+
+    TaskRange &own = this->_ranges[worker];
+    std::lock_guard<std::mutex> lock(own.mtx);
+    own.begin = stolen_begin;
+    own.end = stolen_end;
+
+    this->_stats[worker].steals++;
+    return true;
+  }
+
+  return false;
+}
+
+void WorkStealingScheduler::work(std::size_t worker, const Task &task) {
+  WorkerStats &stats = this->_stats[worker];
+
+  while (!this->_abort.load(std::memory_order_relaxed)) {
+    std::size_t index;
+
+    if (!this->pop(worker, index)) {
+      if (!this->steal(worker)) {
+        // every other range was empty during one full sweep
+        return;
+      }
+      continue;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    try {
+      task(worker, index);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(this->_error_mtx);
+      if (!this->_error) {
+        this->_error = std::current_exception();
+      }
+      this->_abort.store(true, std::memory_order_relaxed);
+    }
+
+    stats.busy_time += std::chrono::steady_clock::now() - start;
+    stats.tasks++;
+  }
+}
+
+void WorkStealingScheduler::run(std::size_t num_tasks, const Task &task) {
+  this->_abort.store(false);
+  this->_error = nullptr;
+
+  const std::size_t chunk = num_tasks / this->_num_workers;
+  const std::size_t remainder = num_tasks % this->_num_workers;
+
+  std::size_t begin = 0;
+  for (std::size_t i = 0; i < this->_num_workers; i++) {
+    const std::size_t size = chunk + (i < remainder ? 1 : 0);
+
+    this->_ranges[i].begin = begin;
+    this->_ranges[i].end = begin + size;
+    this->_stats[i] = WorkerStats{};
+
+    begin += size;
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(this->_num_workers - 1);
+
+  for (std::size_t i = 1; i < this->_num_workers; i++) {
+    threads.emplace_back([this, i, &task]() { this->work(i, task); });
+  }
+
+  this->work(0, task);
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  if (this->_error) {
+    std::rethrow_exception(this->_error);
+  }
+}
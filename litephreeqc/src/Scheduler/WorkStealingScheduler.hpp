@@ -0,0 +1,83 @@
+/*
+ * This project is subject to the original PHREEQC license. `litephreeqc` is a
+ * version of the PHREEQC code that has been modified to be used as a library.
+ *
+ * It adds a C++ interface on top of the original PHREEQC code, with small
+ * changes to the original code base.
+ *
+ * Authors of Modifications:
+ * - Max Luebke (mluebke@uni-potsdam.de) - University of Potsdam
+ * - Marco De Lucia (delucia@gfz.de) - GFZ Helmholz Centre for Geosciences
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Distributes a range of task indices over a fixed number of workers.
+ *
+ * Each worker starts with a contiguous block of the index range. Once a worker
+ * runs out of work it steals half of the remaining block of another worker.
+ * This keeps all workers busy even if the cost of single tasks differs by
+ * orders of magnitude (e.g. kinetic cells vs. plain equilibrium cells).
+ *
+ * Worker 0 always runs on the calling thread, thus a scheduler with a single
+ * worker executes all tasks serially in ascending order without spawning any
+ * thread.
+ */
+class WorkStealingScheduler {
+public:
+  /**
+   * @brief Statistics of a single worker gathered during the last run.
+   */
+  struct WorkerStats {
+    std::chrono::nanoseconds busy_time{0};
+    std::size_t tasks = 0;
+    std::size_t steals = 0;
+  };
+
+  using Task = std::function<void(std::size_t worker, std::size_t task)>;
+
+  explicit WorkStealingScheduler(std::size_t num_workers);
+
+  /**
+   * @brief Executes `task` for every index in [0, num_tasks).
+   *
+   * Blocks until all tasks are done. If a task throws, the remaining tasks
+   * are skipped and the first exception is rethrown on the calling thread.
+   */
+  void run(std::size_t num_tasks, const Task &task);
+
+  std::size_t numWorkers() const { return _num_workers; }
+
+  const std::vector<WorkerStats> &getStats() const { return _stats; }
+
+private:
+  struct alignas(64) TaskRange {
+    std::mutex mtx;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+  };
+
+  bool pop(std::size_t worker, std::size_t &task);
+  bool steal(std::size_t worker);
+
+  void work(std::size_t worker, const Task &task);
+
+  std::size_t _num_workers;
+  std::unique_ptr<TaskRange[]> _ranges;
+  std::vector<WorkerStats> _stats;
+
+  std::atomic<bool> _abort{false};
+  std::mutex _error_mtx;
+  std::exception_ptr _error;
+};
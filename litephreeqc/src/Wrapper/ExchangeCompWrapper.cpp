@@ -17,40 +17,69 @@ ExchangeWrapper::ExchangeCompWrapper::ExchangeCompWrapper(cxxExchComp &comp)
     : exch_comp(comp) {
   const std::size_t totals_size = exch_comp.Get_totals().size() - 1;
   this->num_elements = totals_size + NUM_NOT_TOTALS;
+
+  for (const auto &[name, _] : exch_comp.Get_totals()) {
+    if (name == exch_comp.Get_formula()) {
+      formula_index = total_names.size();
+    }
+    total_names.push_back(name);
+  }
 }
 
 void ExchangeWrapper::ExchangeCompWrapper::get(
     std::span<LDBLE> &exchange) const {
+  const cxxNameDouble &totals = exch_comp.Get_totals();
 
-  std::size_t exch_index = this->NUM_NOT_TOTALS;
-
-  exchange[0] = exch_comp.Get_totals().find(exch_comp.Get_formula())->second;
   exchange[1] = exch_comp.Get_charge_balance();
   exchange[2] = exch_comp.Get_la();
   exchange[3] = exch_comp.Get_phase_proportion();
   exchange[4] = exch_comp.Get_formula_z();
 
-  for (const auto &[name, value] : exch_comp.Get_totals()) {
-    if (name != exch_comp.Get_formula()) {
+  if (same_keys(totals, total_names)) {
+    std::size_t exch_index = this->NUM_NOT_TOTALS;
+    std::size_t k = 0;
+    for (const auto &[_, value] : totals) {
+      if (k++ == formula_index) {
+        exchange[0] = value;
+        continue;
+      }
       exchange[exch_index++] = value;
     }
+    return;
+  }
+
+  // phreeqc added or removed a total, fall back to look up the bound names
+  for (std::size_t k = 0; k < total_names.size(); k++) {
+    const auto it = totals.find(total_names[k]);
+    const LDBLE value = it == totals.end() ? 0. : it->second;
+
+    if (k == formula_index) {
+      exchange[0] = value;
+    } else {
+      exchange[this->NUM_NOT_TOTALS + k - (k > formula_index)] = value;
+    }
   }
 }
 
 void ExchangeWrapper::ExchangeCompWrapper::set(
     const std::span<LDBLE> &exchange) {
+  cxxNameDouble &totals = exch_comp.Get_totals();
 
-  std::size_t exch_index = this->NUM_NOT_TOTALS;
-
-  exch_comp.Get_totals().find(exch_comp.Get_formula())->second = exchange[0];
   exch_comp.Set_charge_balance(exchange[1]);
   exch_comp.Set_la(exchange[2]);
   exch_comp.Set_phase_proportion(exchange[3]);
   exch_comp.Set_formula_z(exchange[4]);
 
-  for (auto &[name, value] : exch_comp.Get_totals()) {
-    if (name != exch_comp.Get_formula()) {
-      value = exchange[exch_index++];
+  if (!same_keys(totals, total_names)) {
+    totals.clear();
+    for (const auto &name : total_names) {
+      totals.emplace_hint(totals.end(), name, 0.);
     }
   }
+
+  std::size_t exch_index = this->NUM_NOT_TOTALS;
+  std::size_t k = 0;
+  for (auto &[_, value] : totals) {
+    value = k++ == formula_index ? exchange[0] : exchange[exch_index++];
+  }
 }
@@ -50,6 +50,11 @@ private:
     cxxExchComp &exch_comp;
 
     static constexpr std::size_t NUM_NOT_TOTALS = 5;
+
+    // keys of the totals in map order and the position of the formula among
+    // them, bound at construction
+    std::vector<std::string> total_names;
+    std::size_t formula_index = 0;
   };
 
   std::vector<std::unique_ptr<ExchangeCompWrapper>> exchange_comps;
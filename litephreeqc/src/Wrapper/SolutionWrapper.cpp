@@ -13,9 +13,25 @@
 
 #include "SolutionWrapper.hpp"
 #include "NameDouble.h"
+#include <algorithm>
+#include <numeric>
 #include <set>
 #include <vector>
 
+namespace {
+// element name a total is summed into by cxxNameDouble::Simplify_redox()
+std::string simplified_name(const std::string &name) {
+  if (name.size() < 4) {
+    return name;
+  }
+  return name.substr(0, name.find('('));
+}
+
+bool is_dropped_by_simplify(const std::string &element) {
+  return element == "H" || element == "O" || element == "Charge";
+}
+} // namespace
+
 SolutionWrapper::SolutionWrapper(
     cxxSolution *soln, const std::vector<std::string> &_solution_order,
     bool with_redox)
@@ -24,7 +40,66 @@ SolutionWrapper::SolutionWrapper(
       _with_redox(with_redox) {
   this->num_elements = _solution_order.size();
 
-  auto &totals = solution->Get_totals();
+  this->initial_guesses = {solution->Get_ph(),       solution->Get_pe(),
+                           solution->Get_mu(),       solution->Get_ah2o(),
+                           solution->Get_potV(),     solution->Get_density(),
+                           solution->Get_viscosity(), solution->Get_viscos_0()};
+
+  // cxxSolution::Update() always simplifies the redox states of the new
+  // totals, summing them up in key order. Bind each column to its element
+  // once, so set() doesn't need to build and simplify a map per call.
+  std::vector<std::size_t> order(solution_order.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+    return solution_order[a] < solution_order[b];
+  });
+
+  std::set<std::string> elements;
+  for (const auto &name : solution_order) {
+    const std::string element = simplified_name(name);
+    if (!is_dropped_by_simplify(element)) {
+      elements.insert(element);
+    }
+  }
+  _elements.assign(elements.begin(), elements.end());
+
+  for (const std::size_t column : order) {
+    const std::string element = simplified_name(solution_order[column]);
+    if (is_dropped_by_simplify(element)) {
+      continue;
+    }
+
+    _set_columns.push_back(NUM_ESSENTIALS + column);
+    _set_slots.push_back(
+        std::distance(_elements.begin(), std::lower_bound(_elements.begin(),
+                                                          _elements.end(),
+                                                          element)));
+  }
+
+  _element_totals.resize(_elements.size());
+  _element_present.resize(_elements.size());
+}
+
+void SolutionWrapper::bind_get_slots(const cxxNameDouble &totals) const {
+  _get_keys.clear();
+  _get_slots.clear();
+
+  for (const auto &[name, _] : totals) {
+    _get_keys.push_back(name);
+
+    const std::string column = _with_redox ? name : simplified_name(name);
+    if (!_with_redox && is_dropped_by_simplify(column)) {
+      _get_slots.push_back(NO_SLOT);
+      continue;
+    }
+
+    const auto it =
+        std::find(solution_order.begin(), solution_order.end(), column);
+    _get_slots.push_back(it == solution_order.end()
+                             ? NO_SLOT
+                             : NUM_ESSENTIALS +
+                                   std::distance(solution_order.begin(), it));
+  }
 }
 
 void SolutionWrapper::get(std::span<LDBLE> &data) const {
@@ -37,43 +112,125 @@ void SolutionWrapper::get(std::span<LDBLE> &data) const {
   data[6] = solution->Get_ph();
   data[7] = solution->Get_pe();
 
-  const cxxNameDouble &totals =
-      (_with_redox ? solution->Get_totals()
-                   : solution->Get_totals().Simplify_redox());
-
-  std::size_t i = NUM_ESSENTIALS;
-  for (const auto &tot_name : solution_order) {
-    auto it = totals.find(tot_name);
-    if (it == totals.end()) {
-      data[i++] = 0.0;
+  const cxxNameDouble &totals = solution->Get_totals();
+
+  if (!same_keys(totals, _get_keys)) {
+    bind_get_slots(totals);
+  }
+
+  const auto columns = data.subspan(NUM_ESSENTIALS, solution_order.size());
+  std::fill(columns.begin(), columns.end(), 0.);
+
+  // without redox, states of an element are summed up in key order just like
+  // Simplify_redox() does
+  std::size_t k = 0;
+  for (const auto &[_, value] : totals) {
+    const std::size_t slot = _get_slots[k++];
+    if (slot != NO_SLOT) {
+      data[slot] += value;
+    }
+  }
+
+  for (auto &value : columns) {
+    value = value > 1e-25 ? value : 0.;
+  }
+}
+
+void SolutionWrapper::write_totals() {
+  cxxNameDouble &totals = this->solution->Get_totals();
+  totals.type = cxxNameDouble::ND_ELT_MOLES;
+
+  // usually the solution still holds the same elements, so just overwrite the
+  // values instead of allocating new map nodes
+  auto it = totals.begin();
+  bool same_layout = true;
+  for (std::size_t slot = 0; slot < _elements.size(); slot++) {
+    if (!_element_present[slot]) {
       continue;
     }
-    data[i++] = it->second > 1e-25 ? it->second : 0.;
+    if (it == totals.end() || it->first != _elements[slot]) {
+      same_layout = false;
+      break;
+    }
+    (it++)->second = _element_totals[slot];
+  }
+
+  if (same_layout && it == totals.end()) {
+    return;
+  }
+
+  totals.clear();
+  for (std::size_t slot = 0; slot < _elements.size(); slot++) {
+    if (_element_present[slot]) {
+      totals.emplace_hint(totals.end(), _elements[slot],
+                          _element_totals[slot]);
+    }
   }
 }
 
 void SolutionWrapper::set(const std::span<LDBLE> &data) {
-  std::size_t i = NUM_ESSENTIALS;
-  cxxNameDouble new_totals;
-
   const double &total_h = data[0];
   const double &total_o = data[1];
   const double &cb = data[2];
   const double &tc = data[3];
   const double &patm = data[4];
 
-  for (const auto &tot_name : solution_order) {
-    const double value = data[i++];
+  std::fill(_element_totals.begin(), _element_totals.end(), 0.);
+  std::fill(_element_present.begin(), _element_present.end(), false);
+
+  for (std::size_t k = 0; k < _set_columns.size(); k++) {
+    const double value = data[_set_columns[k]];
 
     if (value < 1E-25) {
       continue;
     }
-    new_totals[tot_name] = value;
+    _element_totals[_set_slots[k]] += value;
+    _element_present[_set_slots[k]] = true;
   }
 
-  this->solution->Update(total_h, total_o, cb, tc, patm,
-                         _with_redox ? new_totals
-                                     : new_totals.Simplify_redox());
+  // same as cxxSolution::Update(), without building the intermediate maps
+  this->solution->Set_new_def(false);
+  this->solution->Set_patm(patm);
+  this->solution->Set_tc(tc);
+  this->solution->Set_total_h(total_h);
+  this->solution->Set_total_o(total_o);
+  this->solution->Set_cb(cb);
+  this->solution->Set_mass_water(total_o / 55.55);
+  this->solution->Get_master_activity().clear();
+  this->solution->Get_species_gamma().clear();
+
+  this->write_totals();
+}
+
+void SolutionWrapper::restore_initial_guesses() {
+  // must be called after set(), which keeps the values of the last step
+  this->solution->Set_ph(initial_guesses.ph);
+  this->solution->Set_pe(initial_guesses.pe);
+  this->solution->Set_mu(initial_guesses.mu);
+  this->solution->Set_ah2o(initial_guesses.ah2o);
+  this->solution->Set_potV(initial_guesses.potV);
+  this->solution->Set_density(initial_guesses.density);
+  this->solution->Set_viscosity(initial_guesses.viscosity);
+  this->solution->Set_viscos_0(initial_guesses.viscos_0);
+}
+
+void SolutionWrapper::save_state(ConvergedState &state) const {
+  state.master_activity = solution->Get_master_activity();
+  state.species_gamma = solution->Get_species_gamma();
+  state.ph = solution->Get_ph();
+  state.pe = solution->Get_pe();
+  state.mu = solution->Get_mu();
+  state.ah2o = solution->Get_ah2o();
+}
+
+void SolutionWrapper::warm_start(const ConvergedState &state) {
+  // must be called after set(), as it clears the activities
+  this->solution->Get_master_activity() = state.master_activity;
+  this->solution->Get_species_gamma() = state.species_gamma;
+  this->solution->Set_ph(state.ph);
+  this->solution->Set_pe(state.pe);
+  this->solution->Set_mu(state.mu);
+  this->solution->Set_ah2o(state.ah2o);
 }
 
 std::vector<std::string>
@@ -30,12 +30,31 @@ public:
 
   void set(const std::span<LDBLE> &data);
 
+  // resets the start values of the solver to the ones of the cell template,
+  // so the result of a step doesn't depend on the previously simulated cell
+  void restore_initial_guesses();
+
   static std::vector<std::string>
   names(cxxSolution *solution, bool include_h0_o0,
         std::vector<std::string> &solution_order, bool with_redox);
 
   std::vector<std::string> getEssentials() const;
 
+  // converged solver values of a solution, used as start values of the next
+  // step instead of the ones of the cell template
+  struct ConvergedState {
+    cxxNameDouble master_activity;
+    cxxNameDouble species_gamma;
+    LDBLE ph;
+    LDBLE pe;
+    LDBLE mu;
+    LDBLE ah2o;
+  };
+
+  void save_state(ConvergedState &state) const;
+
+  void warm_start(const ConvergedState &state);
+
 private:
   cxxSolution *solution;
   const std::vector<std::string> solution_order;
@@ -48,4 +67,36 @@ private:
   static constexpr std::size_t NUM_ESSENTIALS = ESSENTIALS.size();
 
   const bool _with_redox;
+
+  static constexpr std::size_t NO_SLOT = static_cast<std::size_t>(-1);
+
+  // column layout of set(), bound at construction: the (redox simplified)
+  // elements of the solution totals and, in key order of the totals, the
+  // column and element slot of each input value
+  std::vector<std::string> _elements;
+  std::vector<std::size_t> _set_columns;
+  std::vector<std::size_t> _set_slots;
+  std::vector<LDBLE> _element_totals;
+  std::vector<char> _element_present;
+
+  // layout of the totals seen on the last get() and the column each total is
+  // summed into; only rebound if phreeqc changes the set of totals
+  mutable std::vector<std::string> _get_keys;
+  mutable std::vector<std::size_t> _get_slots;
+
+  void bind_get_slots(const cxxNameDouble &totals) const;
+
+  void write_totals();
+
+  // start values of the solver as found in the cell template
+  struct InitialGuesses {
+    LDBLE ph;
+    LDBLE pe;
+    LDBLE mu;
+    LDBLE ah2o;
+    LDBLE potV;
+    LDBLE density;
+    LDBLE viscosity;
+    LDBLE viscos_0;
+  } initial_guesses;
 };
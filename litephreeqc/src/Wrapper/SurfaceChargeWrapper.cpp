@@ -27,19 +27,22 @@ void SurfaceWrapper::SurfaceChargeWrapper::get(
   surface[3] = this->surface_charge.Get_mass_water();
   surface[4] = this->surface_charge.Get_la_psi();
 
-  const auto dl_map = this->surface_charge.Get_diffuse_layer_totals();
-
-  for (auto it = this->primaries.begin(); it != this->primaries.end(); it++) {
-    const std::size_t index =
-        NUM_NOT_TOTALS + std::distance(this->primaries.begin(), it);
-
-    const auto dl_it = dl_map.find(*it);
+  const auto &dl_map = this->surface_charge.Get_diffuse_layer_totals();
+
+  // both the primaries and the diffuse layer totals are sorted by name, so a
+  // single merge walk assigns every total to its column
+  auto dl_it = dl_map.begin();
+  std::size_t index = NUM_NOT_TOTALS;
+  for (const auto &name : this->primaries) {
+    while (dl_it != dl_map.end() && dl_it->first < name) {
+      dl_it++;
+    }
 
-    if (dl_it == dl_map.end()) {
-      surface[index] = 0;
+    if (dl_it != dl_map.end() && dl_it->first == name) {
+      surface[index++] = (dl_it++)->second;
       continue;
     }
-    surface[index] = dl_it->second;
+    surface[index++] = 0;
   }
 }
 
@@ -52,17 +55,36 @@ void SurfaceWrapper::SurfaceChargeWrapper::set(
   this->surface_charge.Set_la_psi(surface[4]);
 
   auto &dl_map = this->surface_charge.Get_diffuse_layer_totals();
-  dl_map.clear();
-
-  for (auto it = this->primaries.begin(); it != this->primaries.end(); it++) {
-    const std::size_t index =
-        NUM_NOT_TOTALS + std::distance(this->primaries.begin(), it);
 
-    if (surface[index] == 0) {
+  // overwrite the values in place as long as the non-zero totals still match
+  // the keys of the map
+  const auto values = surface.subspan(NUM_NOT_TOTALS, this->primaries.size());
+  auto dl_it = dl_map.begin();
+  bool same_layout = true;
+  std::size_t k = 0;
+  for (const auto &name : this->primaries) {
+    const LDBLE value = values[k++];
+    if (value == 0) {
       continue;
     }
+    if (dl_it == dl_map.end() || dl_it->first != name) {
+      same_layout = false;
+      break;
+    }
+    (dl_it++)->second = value;
+  }
+
+  if (same_layout && dl_it == dl_map.end()) {
+    return;
+  }
 
-    dl_map[*it] = surface[index];
+  dl_map.clear();
+  k = 0;
+  for (const auto &name : this->primaries) {
+    const LDBLE value = values[k++];
+    if (value != 0) {
+      dl_map.emplace_hint(dl_map.end(), name, value);
+    }
   }
 }
 
@@ -28,6 +28,15 @@ void SurfaceWrapper::SurfaceCompWrapper::get(std::span<LDBLE> &surface) const {
   surface[2] = this->surface_comp.Get_charge_balance();
 
   const auto &totals = this->surface_comp.Get_totals();
+
+  if (same_keys(totals, this->total_names)) {
+    std::size_t index = NUM_NOT_TOTALS;
+    for (const auto &[_, value] : totals) {
+      surface[index++] = value;
+    }
+    return;
+  }
+
   for (std::size_t i = 0; i < this->total_names.size(); i++) {
     surface[NUM_NOT_TOTALS + i] = totals.at(this->total_names[i]);
   }
@@ -39,12 +48,17 @@ void SurfaceWrapper::SurfaceCompWrapper::set(const std::span<LDBLE> &surface) {
   this->surface_comp.Set_charge_balance(surface[2]);
 
   auto &totals = this->surface_comp.Get_totals();
-  totals.clear();
 
-  for (std::size_t i = 0; i < this->total_names.size(); i++) {
-    const std::size_t index = NUM_NOT_TOTALS + i;
+  if (!same_keys(totals, this->total_names)) {
+    totals.clear();
+    for (const auto &name : this->total_names) {
+      totals.emplace_hint(totals.end(), name, 0.);
+    }
+  }
 
-    totals[this->total_names[i]] = surface[index];
+  std::size_t index = NUM_NOT_TOTALS;
+  for (auto &[_, value] : totals) {
+    value = surface[index++];
   }
 }
 
@@ -13,8 +13,12 @@
 
 #pragma once
 
+#include "NameDouble.h"
+#include <algorithm>
 #include <phrqtype.h>
 #include <span>
+#include <string>
+#include <vector>
 
 class WrapperBase {
 public:
@@ -28,4 +32,15 @@ public:
 
 protected:
   std::size_t num_elements = 0;
+
+  // true if the keys of `totals` are exactly `names` in map order, i.e. the
+  // slots bound at construction can be used without any lookup by name
+  static bool same_keys(const cxxNameDouble &totals,
+                        const std::vector<std::string> &names) {
+    return totals.size() == names.size() &&
+           std::equal(names.begin(), names.end(), totals.begin(),
+                      [](const std::string &name, const auto &total) {
+                        return name == total.first;
+                      });
+  }
 };
\ No newline at end of file
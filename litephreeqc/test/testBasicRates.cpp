@@ -0,0 +1,246 @@
+/*
+ * This project is subject to the original PHREEQC license. `litephreeqc` is a
+ * version of the PHREEQC code that has been modified to be used as a library.
+ *
+ * It adds a C++ interface on top of the original PHREEQC code, with small
+ * changes to the original code base.
+ *
+ * Authors of Modifications:
+ * - Max Luebke (mluebke@uni-potsdam.de) - University of Potsdam
+ * - Marco De Lucia (delucia@gfz.de) - GFZ Helmholz Centre for Geosciences
+ *
+ */
+
+#include <cctype>
+#include <cstddef>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <testInput.hpp>
+
+#include "IPhreeqc.hpp"
+#include "Phreeqc.h"
+#include "utils.hpp"
+
+// names of the rates defined in the RATES blocks of a database
+static std::vector<std::string> rate_names(const std::string &db) {
+  std::vector<std::string> names;
+  std::istringstream lines(db);
+  std::string line;
+  std::string last;
+  bool in_rates = false;
+
+  while (std::getline(lines, line)) {
+    const std::size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string::npos || line[begin] == '#') {
+      continue;
+    }
+    const std::string token =
+        line.substr(begin, line.find_first_of(" \t\r#", begin) - begin);
+
+    if (begin == 0 && token == "RATES") {
+      in_rates = true;
+      continue;
+    }
+    if (!in_rates) {
+      continue;
+    }
+    if (token == "-start") {
+      names.push_back(last);
+    } else if (begin == 0 && token != "-end" &&
+               !std::isdigit(static_cast<unsigned char>(token[0]))) {
+      // keywords are in capitals, rate names are not
+      bool keyword = token.size() > 3;
+      for (const char c : token) {
+        keyword = keyword && (std::isupper(static_cast<unsigned char>(c)) ||
+                              c == '_');
+      }
+      if (keyword) {
+        in_rates = false;
+      }
+    }
+    last = token;
+  }
+  return names;
+}
+
+// solutions are tried in this order until one is accepted by the database
+static const std::vector<std::string> rate_solutions = {
+    R"(SOLUTION 1
+    temp 40
+    pH 6.5
+    units mmol/kgw
+    Na 10; K 1; Ca 2; Mg 1; Fe(2) 0.01; Al 0.001; Si 0.5
+    C(4) 2; S(6) 1; Cl 10 charge
+)",
+    R"(SOLUTION 1
+    temp 40
+    pH 6.5
+    units mmol/kgw
+    Na 10; Ca 2; C(4) 2; Cl 10 charge
+)"};
+
+// phreeqc.dat style (area, exponent) and Kinec style (mass based surface)
+static const std::vector<std::string> rate_parms = {"1 0.67 1 1 1 1",
+                                                    "0 1 0 0 1 1"};
+
+struct RateResult {
+  int errors;
+  std::string error;
+  std::string warning;
+  std::vector<double> values;
+};
+
+static RateResult run_rate(IPhreeqc &pqc, const std::string &solution,
+                           const std::string &name, double m,
+                           const std::string &parms) {
+  std::ostringstream input;
+  input << solution << "KINETICS 1\n"
+        << name << "\n"
+        << "    -formula H2O 0\n"
+        << "    -m " << m << "\n"
+        << "    -m0 1\n"
+        << "    -parms " << parms << "\n"
+        << "    -steps 100\n"
+        << "SELECTED_OUTPUT\n"
+        << "    -reset false\n"
+        << "    -kinetic_reactants " << name << "\n"
+        << "END\n";
+
+  RateResult result;
+  result.errors = pqc.RunString(input.str().c_str());
+  result.error = pqc.GetErrorString();
+  result.warning = pqc.GetWarningString();
+  for (int row = 0; row < pqc.GetSelectedOutputRowCount(); row++) {
+    for (int col = 0; col < pqc.GetSelectedOutputColumnCount(); col++) {
+      VAR v;
+      VarInit(&v);
+      pqc.GetSelectedOutputValue(row, col, &v);
+      result.values.push_back(v.type == TT_DOUBLE ? v.dVal : 0.0);
+      VarClear(&v);
+    }
+  }
+  return result;
+}
+
+// every rate of the databases gives the same moles, warnings and errors when
+// it is run as compiled program and by the interpreter
+POET_TEST(BasicRatesCompiledParity) {
+  std::size_t count_rates = 0;
+  std::size_t count_compiled = 0;
+
+  for (const auto &entry :
+       std::filesystem::directory_iterator(rates_test::database_dir)) {
+    if (entry.path().extension() != ".dat") {
+      continue;
+    }
+    const std::string db = readFile(entry.path().string());
+    const std::vector<std::string> names = rate_names(db);
+    if (names.empty()) {
+      continue;
+    }
+
+    IPhreeqc interpreted;
+    IPhreeqc compiled;
+    if (interpreted.LoadDatabaseString(db.c_str()) != 0) {
+      // not a valid database for PHREEQC either (Kinec_v3.dat)
+      continue;
+    }
+    ASSERT_EQ(compiled.LoadDatabaseString(db.c_str()), 0) << entry.path();
+    interpreted.RunString("KNOBS\n -compiled_rates false\nEND\n");
+    compiled.RunString("KNOBS\n -compiled_rates true\nEND\n");
+
+    std::string solution;
+    for (const auto &candidate : rate_solutions) {
+      if (compiled.RunString(candidate.c_str()) == 0) {
+        solution = candidate;
+        break;
+      }
+    }
+    ASSERT_FALSE(solution.empty()) << entry.path();
+
+    for (const auto &name : names) {
+      for (const double m : {1.0, 0.0}) {
+        for (const std::string &parms : rate_parms) {
+          const RateResult expected =
+              run_rate(interpreted, solution, name, m, parms);
+          const RateResult actual =
+              run_rate(compiled, solution, name, m, parms);
+
+          EXPECT_EQ(actual.errors, expected.errors)
+              << entry.path() << " " << name;
+          EXPECT_EQ(actual.error, expected.error)
+              << entry.path() << " " << name;
+          EXPECT_EQ(actual.warning, expected.warning)
+              << entry.path() << " " << name;
+          EXPECT_EQ(actual.values, expected.values)
+              << entry.path() << " " << name;
+        }
+      }
+    }
+    EXPECT_EQ(interpreted.GetPhreeqcPtr()->Get_rates_compiled(), 0)
+        << entry.path();
+    count_rates += names.size();
+    count_compiled += compiled.GetPhreeqcPtr()->Get_rates_compiled();
+  }
+
+  ASSERT_GT(count_rates, 0);
+  EXPECT_GT(count_compiled, count_rates / 2);
+}
+
+// names bound in a compiled rate are resolved again when the model changes
+POET_TEST(BasicRatesRebindNames) {
+  const std::string db =
+      readFile(rates_test::database_dir + std::string("/phreeqc.dat"));
+  const std::string rate = R"(RATES
+Probe
+    -start
+10 SAVE 1e-6 * (SI("Probe_phase") + 100 - LA("CaCl+") + TOT("Ca")) * TIME
+    -end
+END
+)";
+  const std::string definitions = R"(SOLUTION_SPECIES
+Ca+2 + Cl- = CaCl+
+    log_k 0.4
+PHASES
+Probe_phase
+    CaCO3 = CO3-2 + Ca+2
+    log_k -8.48
+END
+)";
+
+  IPhreeqc interpreted;
+  IPhreeqc compiled;
+  ASSERT_EQ(interpreted.LoadDatabaseString(db.c_str()), 0);
+  ASSERT_EQ(compiled.LoadDatabaseString(db.c_str()), 0);
+  interpreted.RunString("KNOBS\n -compiled_rates false\nEND\n");
+  compiled.RunString("KNOBS\n -compiled_rates true\nEND\n");
+  ASSERT_EQ(interpreted.RunString(rate.c_str()), 0);
+  ASSERT_EQ(compiled.RunString(rate.c_str()), 0);
+
+  const RateResult missing_expected =
+      run_rate(interpreted, rate_solutions[0], "Probe", 1, "1");
+  const RateResult missing =
+      run_rate(compiled, rate_solutions[0], "Probe", 1, "1");
+  EXPECT_EQ(missing.errors, 0) << missing.error;
+  EXPECT_NE(missing.warning.find("Probe_phase"), std::string::npos);
+  EXPECT_EQ(missing.warning, missing_expected.warning);
+  EXPECT_EQ(missing.values, missing_expected.values);
+  EXPECT_EQ(compiled.GetPhreeqcPtr()->Get_rates_compiled(), 1);
+
+  ASSERT_EQ(interpreted.RunString(definitions.c_str()), 0);
+  ASSERT_EQ(compiled.RunString(definitions.c_str()), 0);
+
+  const RateResult found_expected =
+      run_rate(interpreted, rate_solutions[0], "Probe", 1, "1");
+  const RateResult found =
+      run_rate(compiled, rate_solutions[0], "Probe", 1, "1");
+  EXPECT_EQ(found.errors, 0) << found.error;
+  EXPECT_EQ(found.warning.find("Probe_phase"), std::string::npos);
+  EXPECT_EQ(found.warning, found_expected.warning);
+  EXPECT_EQ(found.values, found_expected.values);
+  EXPECT_NE(found.values, missing.values);
+}
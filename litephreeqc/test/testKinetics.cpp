@@ -0,0 +1,248 @@
+/*
+ * This project is subject to the original PHREEQC license. `litephreeqc` is a
+ * version of the PHREEQC code that has been modified to be used as a library.
+ *
+ * It adds a C++ interface on top of the original PHREEQC code, with small
+ * changes to the original code base.
+ *
+ * Authors of Modifications:
+ * - Max Luebke (mluebke@uni-potsdam.de) - University of Potsdam
+ * - Marco De Lucia (delucia@gfz.de) - GFZ Helmholz Centre for Geosciences
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <testInput.hpp>
+
+#include "IPhreeqc.hpp"
+#include "Phreeqc.h"
+#include "cxxKinetics.h"
+#include "utils.hpp"
+
+static const std::string kinetics_db = readFile(base_test::phreeqc_database);
+
+// three CVODE reactions next to equilibrium phases and a solid solution
+static std::string cvode_three(int n) {
+  std::ostringstream input;
+  input << "SOLUTION " << n << "\n"
+        << "    pH 6\n"
+        << "    Ca 1; C(4) 2 charge; Na 1; Cl 1; Si 0.1; Al 0.001; K 0.1\n"
+        << "EQUILIBRIUM_PHASES " << n << "\n"
+        << "    Gibbsite 0 0\n"
+        << "    Kaolinite 0 0\n"
+        << "SOLID_SOLUTIONS " << n << "\n"
+        << "    CaSr\n"
+        << "    -comp Calcite 0.001\n"
+        << "    -comp Strontianite 0.0001\n"
+        << "KINETICS " << n << "\n"
+        << "Calcite\n"
+        << "    -m 1; -m0 1; -parms 1 0.67\n"
+        << "K-feldspar\n"
+        << "    -m 1; -m0 1; -parms 1 0.1\n"
+        << "Quartz\n"
+        << "    -m 1; -m0 1; -parms 1 0.1\n"
+        << "    -steps 86400 in 5\n"
+        << "    -cvode true\n"
+        << "INCREMENTAL_REACTIONS true\n"
+        << "SELECTED_OUTPUT 1\n"
+        << "    -reset false\n"
+        << "    -kinetic_reactants Calcite K-feldspar Quartz\n"
+        << "    -equilibrium_phases Gibbsite Kaolinite\n"
+        << "    -totals Ca Si Al K\n"
+        << "    -pH\n"
+        << "END\n";
+  return input.str();
+}
+
+// one CVODE reaction with a lower maximum order
+static std::string cvode_one(int n) {
+  std::ostringstream input;
+  input << "SOLUTION " << n << "\n"
+        << "    pH 7\n"
+        << "    Ca 1; C(4) 2 charge; Si 0.1\n"
+        << "KINETICS " << n << "\n"
+        << "Quartz\n"
+        << "    -m 1; -m0 1; -parms 10 0.1\n"
+        << "    -steps 86400 864000\n"
+        << "    -cvode true\n"
+        << "    -cvode_order 3\n"
+        << "SELECTED_OUTPUT 1\n"
+        << "    -reset false\n"
+        << "    -kinetic_reactants Quartz\n"
+        << "    -totals Si\n"
+        << "    -pH\n"
+        << "END\n";
+  return input.str();
+}
+
+// cvode_three with a reaction that does not change the solution
+static std::string cvode_tracer(int n) {
+  std::ostringstream input;
+  input << "RATES\n"
+        << "Tracer\n"
+        << "    -start\n"
+        << "10 SAVE 1e-9 * M * (1 + SI(\"Calcite\")^2) * TIME\n"
+        << "    -end\n"
+        << cvode_three(n);
+  std::string text = input.str();
+  text.insert(text.find("    -steps"),
+              "Tracer\n    -formula H2O 0; -m 1; -m0 1\n");
+  return text;
+}
+
+// values of the last row of the selected output
+static std::vector<double> run_kinetics(IPhreeqc &pqc,
+                                        const std::string &input) {
+  std::vector<double> values;
+
+  EXPECT_EQ(pqc.RunString(input.c_str()), 0) << pqc.GetErrorString();
+  const int row = pqc.GetSelectedOutputRowCount() - 1;
+  for (int col = 0; col < pqc.GetSelectedOutputColumnCount(); col++) {
+    VAR v;
+    VarInit(&v);
+    pqc.GetSelectedOutputValue(row, col, &v);
+    values.push_back(v.type == TT_DOUBLE ? v.dVal : 0.0);
+    VarClear(&v);
+  }
+  return values;
+}
+
+static std::vector<double> run_kinetics_fresh(const std::string &input) {
+  IPhreeqc pqc;
+
+  EXPECT_EQ(pqc.LoadDatabaseString(kinetics_db.c_str()), 0);
+  return run_kinetics(pqc, input);
+}
+
+// a simulation starts from the initial guesses of the previous one, so the
+// results of a used instance are only close to the ones of a new instance
+static void expect_close(const std::vector<double> &actual,
+                         const std::vector<double> &expected) {
+  ASSERT_EQ(actual.size(), expected.size());
+  for (std::size_t i = 0; i < actual.size(); i++) {
+    EXPECT_NEAR(actual[i], expected[i],
+                1e-6 * std::max(std::fabs(expected[i]), 1e-6))
+        << "column " << i;
+  }
+}
+
+// the CVODE workspace kept between simulations gives the results of a new
+// workspace, also when the number of reactions and the order change in
+// between; a new instance is only close, it starts from other initial guesses
+POET_TEST(KineticsCvodeWorkspaceReuse) {
+  IPhreeqc pqc;
+  IPhreeqc renewed;
+  ASSERT_EQ(pqc.LoadDatabaseString(kinetics_db.c_str()), 0);
+  ASSERT_EQ(renewed.LoadDatabaseString(kinetics_db.c_str()), 0);
+
+  const auto run_renewed = [&renewed](const std::string &input) {
+    renewed.GetPhreeqcPtr()->free_cvode();
+    return run_kinetics(renewed, input);
+  };
+
+  for (int n = 1; n <= 4; n += 3) {
+    const std::vector<std::string> inputs = {cvode_three(n), cvode_three(n + 1),
+                                             cvode_one(n + 2)};
+
+    for (const std::string &input : inputs) {
+      const std::vector<double> expected = run_renewed(input);
+      ASSERT_FALSE(expected.empty());
+
+      const std::vector<double> actual = run_kinetics(pqc, input);
+      EXPECT_EQ(actual, expected);
+      expect_close(actual, run_kinetics_fresh(input));
+    }
+  }
+}
+
+// Jacobian columns calculated by worker clones, with and without reuse of
+// the Jacobian of the previous step, give the results of the serial Jacobian
+POET_TEST(KineticsCvodeJacobianOptions) {
+  const std::vector<double> expected = run_kinetics_fresh(cvode_tracer(1));
+  ASSERT_FALSE(expected.empty());
+
+  IPhreeqc threaded;
+  ASSERT_EQ(threaded.LoadDatabaseString(kinetics_db.c_str()), 0);
+  threaded.RunString("KNOBS\n -cvode_jacobian_threads 3\nEND\n");
+  expect_close(run_kinetics(threaded, cvode_tracer(1)), expected);
+  EXPECT_GT(threaded.GetPhreeqcPtr()->Get_cvode_jacobian_evaluations(), 0);
+  EXPECT_EQ(threaded.GetPhreeqcPtr()->Get_cvode_jacobian_reuses(), 0);
+
+  // a stale Jacobian only slows down the Newton iterations of CVODE, the
+  // results stay within the tolerances of the integration
+  IPhreeqc reused;
+  ASSERT_EQ(reused.LoadDatabaseString(kinetics_db.c_str()), 0);
+  reused.RunString("KNOBS\n -cvode_jacobian_threads 2\n"
+                   " -cvode_jacobian_reuse 0.5\nEND\n");
+  const std::vector<double> actual = run_kinetics(reused, cvode_tracer(1));
+  ASSERT_EQ(actual.size(), expected.size());
+  for (std::size_t i = 0; i < actual.size(); i++) {
+    EXPECT_NEAR(actual[i], expected[i],
+                1e-4 * std::max(std::fabs(expected[i]), 1e-6))
+        << "column " << i;
+  }
+  EXPECT_GT(reused.GetPhreeqcPtr()->Get_cvode_jacobian_reuses(), 0);
+}
+
+// cvode_three integrated by the Runge-Kutta method of the option
+static std::string runge_kutta_three(int n, const std::string &method) {
+  std::string text = cvode_three(n);
+  text.replace(text.find("-cvode true"), std::string("-cvode true").size(),
+               "-runge_kutta " + method);
+  return text;
+}
+
+// the embedded methods give the results of Cash-Karp within the tolerances
+// of the integration. Each of the 5 time steps of the input is one step of
+// the methods: Cash-Karp and Dormand-Prince equilibrate 6 times per step,
+// Rosenbrock 2 times and 3 times for the Jacobian of the 3 reactions
+POET_TEST(KineticsRungeKuttaMethods) {
+  struct method {
+    std::string option;
+    cxxKinetics::RK_METHOD rk_method;
+    std::size_t equilibrations;
+  };
+  const std::vector<method> methods = {
+      {"6", cxxKinetics::RK_CASH_KARP, 5 * 6},
+      {"dormand_prince", cxxKinetics::RK_DORMAND_PRINCE, 5 * 6},
+      {"rosenbrock", cxxKinetics::RK_ROSENBROCK, 5 * (2 + 3)}};
+
+  std::vector<double> expected;
+  for (const method &m : methods) {
+    IPhreeqc pqc;
+    ASSERT_EQ(pqc.LoadDatabaseString(kinetics_db.c_str()), 0);
+    const std::vector<double> actual =
+        run_kinetics(pqc, runge_kutta_three(1, m.option));
+
+    const std::map<int, cxxKinetics> &kinetics =
+        pqc.GetPhreeqcPtr()->Get_Rxn_kinetics_map();
+    ASSERT_EQ(kinetics.count(1), 1) << m.option;
+    EXPECT_EQ(kinetics.at(1).Get_rk_method(), m.rk_method) << m.option;
+    EXPECT_EQ(pqc.GetPhreeqcPtr()->Get_rk_equilibrations(), m.equilibrations)
+        << m.option;
+
+    if (expected.empty()) {
+      expected = actual;
+      ASSERT_FALSE(expected.empty());
+      continue;
+    }
+    ASSERT_EQ(actual.size(), expected.size());
+    for (std::size_t i = 0; i < actual.size(); i++) {
+      EXPECT_NEAR(actual[i], expected[i],
+                  1e-5 * std::max(std::fabs(expected[i]), 1e-4))
+          << m.option << ", column " << i;
+    }
+  }
+
+  IPhreeqc pqc;
+  ASSERT_EQ(pqc.LoadDatabaseString(kinetics_db.c_str()), 0);
+  EXPECT_NE(pqc.RunString(runge_kutta_three(1, "simpson").c_str()), 0);
+}
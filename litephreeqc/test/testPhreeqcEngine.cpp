@@ -11,12 +11,16 @@
  *
  */
 
+#include <cmath>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <testInput.hpp>
 
 #include <gtest/gtest.h>
 
+#include "IPhreeqc.hpp"
 #include "IPhreeqcReader.hpp"
 #include "PhreeqcEngine.hpp"
 #include "PhreeqcMatrix.hpp"
@@ -63,3 +67,232 @@ POET_TEST(PhreeqcEngineStep) {
 
   EXPECT_THROW(engine.runCell(cell_values, -1), std::invalid_argument);
 }
+
+POET_TEST(PhreeqcEngineBindCell) {
+  const std::string barite_database = readFile(barite_test::database);
+  const std::string barite_script = readFile(barite_test::script);
+
+  PhreeqcMatrix pqc_mat(barite_database, barite_script);
+  const auto ids = pqc_mat.getIds();
+
+  PhreeqcEngine engine(pqc_mat);
+
+  EXPECT_EQ(engine.boundCell(), ids.front());
+  EXPECT_THROW(engine.bindCell(1000), std::invalid_argument);
+
+  const auto stl_mat = pqc_mat.get();
+  const std::size_t num_columns = stl_mat.names.size();
+
+  for (std::size_t row = 0; row < ids.size(); ++row) {
+    const int id = ids[row];
+
+    EXPECT_NO_THROW(engine.bindCell(id));
+    EXPECT_EQ(engine.boundCell(), id);
+
+    PhreeqcEngine single_engine(pqc_mat, id);
+
+    // remove NaNs and the ID as PhreeqcRunner does
+    std::vector<double> cell_values;
+    for (std::size_t col = 1; col < num_columns; ++col) {
+      const double value = stl_mat.values[row * num_columns + col];
+      if (!std::isnan(value)) {
+        cell_values.push_back(value);
+      }
+    }
+    std::vector<double> single_values = cell_values;
+
+    EXPECT_NO_THROW(engine.runCell(cell_values, 100));
+    EXPECT_NO_THROW(single_engine.runCell(single_values, 100));
+
+    for (std::size_t i = 0; i < cell_values.size(); ++i) {
+      EXPECT_EQ(cell_values[i], single_values[i]);
+    }
+  }
+}
+
+POET_TEST(PhreeqcEngineModelReuse) {
+  PhreeqcMatrix pqc_mat(test_database, base_test::script);
+
+  PhreeqcEngine engine(pqc_mat, 1);
+  engine.setResetStartValues(true);
+
+  std::vector<double> input = pqc_mat.get().values;
+  input.erase(input.begin(), input.begin() + 1);
+
+  // the first step sets up the model, the following steps reuse it and, with
+  // the same start values, must not depend on the previous step
+  std::vector<double> first = input;
+  EXPECT_NO_THROW(engine.runCell(first, 100));
+
+  for (int step = 0; step < 3; ++step) {
+    std::vector<double> next = input;
+    const auto before = engine.getSolverStats();
+    EXPECT_NO_THROW(engine.runCell(next, 100));
+    EXPECT_GT(engine.getSolverStats().model_reuses, before.model_reuses);
+
+    for (std::size_t i = 0; i < first.size(); ++i) {
+      EXPECT_EQ(first[i], next[i]);
+    }
+  }
+}
+
+POET_TEST(PhreeqcEngineSolverStats) {
+  const std::string aqueous_script = R"(KNOBS
+ -dense_linear_solver true
+SOLUTION 1
+units mol/kgw
+Ca 0.1
+Mg 0.1
+Cl 0.4 charge
+RUN_CELLS
+ -cells 1
+END)";
+
+  PhreeqcMatrix aqueous_mat(test_database, aqueous_script);
+  PhreeqcEngine aqueous_engine(aqueous_mat, 1);
+
+  std::vector<double> aqueous_input = aqueous_mat.get().values;
+  aqueous_input.erase(aqueous_input.begin(), aqueous_input.begin() + 1);
+
+  // without pure phases every newton step is a square system
+  const auto aqueous_before = aqueous_engine.getSolverStats();
+  EXPECT_NO_THROW(aqueous_engine.runCell(aqueous_input, 100));
+  const auto aqueous_after = aqueous_engine.getSolverStats();
+
+  EXPECT_GT(aqueous_after.dense_solves, aqueous_before.dense_solves);
+  EXPECT_EQ(aqueous_after.cl1_solves, aqueous_before.cl1_solves);
+
+  // calcite is present, thus its inequality needs cl1, which is also the
+  // default for all other steps
+  PhreeqcMatrix pqc_mat(test_database, base_test::script);
+  PhreeqcEngine engine(pqc_mat, 1);
+
+  std::vector<double> input = pqc_mat.get().values;
+  input.erase(input.begin(), input.begin() + 1);
+
+  const auto before = engine.getSolverStats();
+  EXPECT_NO_THROW(engine.runCell(input, 100));
+  const auto after = engine.getSolverStats();
+
+  EXPECT_GT(after.cl1_solves, before.cl1_solves);
+  EXPECT_EQ(after.dense_solves, before.dense_solves);
+}
+
+POET_TEST(PhreeqcEngineDenseSolverParity) {
+  const std::string script = R"(SOLUTION 1
+units mol/kgw
+pH 7.5
+Ca 0.01
+Mg 0.005
+Na 0.1
+C(4) 0.004
+Cl 0.12 charge
+EXCHANGE 1
+X 0.05
+-equilibrate 1
+RUN_CELLS
+ -cells 1
+END)";
+
+  PhreeqcMatrix cl1_mat(test_database, script);
+  PhreeqcMatrix dense_mat(test_database,
+                          "KNOBS\n -dense_linear_solver true\n" + script);
+  PhreeqcEngine cl1_engine(cl1_mat, 1);
+  PhreeqcEngine dense_engine(dense_mat, 1);
+
+  std::vector<double> cl1_values = cl1_mat.get().values;
+  cl1_values.erase(cl1_values.begin(), cl1_values.begin() + 1);
+  std::vector<double> dense_values = dense_mat.get().values;
+  dense_values.erase(dense_values.begin(), dense_values.begin() + 1);
+  ASSERT_EQ(dense_values.size(), cl1_values.size());
+
+  EXPECT_NO_THROW(cl1_engine.runCell(cl1_values, 100));
+  EXPECT_NO_THROW(dense_engine.runCell(dense_values, 100));
+  EXPECT_GT(dense_engine.getSolverStats().dense_solves, 0);
+  EXPECT_EQ(cl1_engine.getSolverStats().dense_solves, 0);
+
+  // both solvers converge to the same solution up to the convergence
+  // tolerance, except pe, which the solution does not poise
+  const std::vector<std::string> &names = dense_mat.get().names;
+  for (std::size_t i = 0; i < cl1_values.size(); i++) {
+    if (names[i + 1] == "pe") {
+      continue;
+    }
+    EXPECT_NEAR(dense_values[i], cl1_values[i],
+                1e-9 * std::abs(cl1_values[i]) + 1e-12)
+        << names[i + 1];
+  }
+}
+
+POET_TEST(PhreeqcLogKAfterBasisSwitch) {
+  // total S and Fe at extreme pe, so that a secondary master species
+  // predominates and the basis is switched while solving
+  const std::string script = R"(KNOBS
+ -logfile true
+SOLUTION 1
+ pH 7; pe -6
+ S 1; Fe 0.1; Na 2
+SOLUTION 2
+ pH 7; pe -5
+ S 1; Fe 0.1; Na 2
+SOLUTION 3
+ pH 3; pe 18
+ S 1; Fe 1; Na 2; Cl 1
+SOLUTION 4
+ temp 60
+ pH 7; pe -6
+ S 1; Fe 0.1; Na 2
+SELECTED_OUTPUT 1
+ -reset false
+ -pH true
+ -molalities HS- H2S SO4-2 Fe+2 Fe+3
+END)";
+
+  // results before the log k's were cached
+  const std::vector<std::vector<double>> expected = {
+      {7, 0.00043305719442429549, 0.00036389278468315324,
+       1.0883760838300316e-22, 7.1585154914285994e-07,
+       8.1938237277665542e-26},
+      {7, 0.00043305719441897895, 0.00036389278467854034,
+       1.0883766024060447e-14, 7.1585154915871058e-07,
+       8.1938237279615418e-25},
+      {3, 0, 0, 0.00063956255088495808, 7.3782014628206436e-10,
+       9.7673925593482229e-05},
+      {7, 0.00056775226554004864, 0.00022729987922189991,
+       6.1713309685403357e-18, 4.2129229143026074e-07,
+       2.7292070669611391e-25}};
+
+  IPhreeqc pqc;
+  ASSERT_EQ(pqc.LoadDatabaseString(test_database.c_str()), 0);
+  pqc.SetLogStringOn(true);
+
+  // the second run starts with the log k's left by the first one
+  for (int run = 0; run < 2; ++run) {
+    ASSERT_EQ(pqc.RunString(script.c_str()), 0) << pqc.GetErrorString();
+
+    int switches = 0;
+    for (int i = 0; i < pqc.GetLogStringLineCount(); ++i) {
+      if (std::string(pqc.GetLogStringLine(i)).find("Switching bases") !=
+          std::string::npos) {
+        switches++;
+      }
+    }
+    EXPECT_GT(switches, 0);
+
+    ASSERT_EQ(pqc.GetSelectedOutputRowCount(), expected.size() + 1);
+    for (std::size_t row = 0; row < expected.size(); ++row) {
+      for (std::size_t col = 0; col < expected[row].size(); ++col) {
+        VAR v;
+        VarInit(&v);
+        pqc.GetSelectedOutputValue(static_cast<int>(row) + 1,
+                                   static_cast<int>(col), &v);
+        ASSERT_EQ(v.type, TT_DOUBLE);
+        EXPECT_NEAR(v.dVal, expected[row][col],
+                    1e-10 * std::abs(expected[row][col]))
+            << "run " << run << ", solution " << row + 1 << ", column "
+            << col;
+        VarClear(&v);
+      }
+    }
+  }
+}
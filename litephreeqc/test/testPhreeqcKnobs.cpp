@@ -11,15 +11,21 @@
  *
  */
 
+#include <cmath>
+#include <limits>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <testInput.hpp>
 
 #include "IPhreeqc.hpp"
+#include "Phreeqc.h"
 #include "PhreeqcKnobs.hpp"
 #include "utils.hpp"
 
 const std::string barite_db = readFile(barite_test::database);
 const std::string barite_script = readFile(barite_test::script);
+const std::string phreeqc_db = readFile(base_test::phreeqc_database);
 
 const std::string knob_input = R"(
 KNOBS 
@@ -29,6 +35,12 @@ KNOBS
     -step_size 200
     -pe_step_size 20
     -diagonal_scale true
+    -cl1_compensated_sum true
+    -dense_linear_solver true
+    -vectorized_gammas false
+    -compiled_rates false
+    -cvode_jacobian_threads 4
+    -cvode_jacobian_reuse 0.01
 END
 )";
 
@@ -48,6 +60,12 @@ POET_TEST(PhreeqcKnobsDefaultParams) {
   EXPECT_DOUBLE_EQ(params.step_size, 100);
   EXPECT_DOUBLE_EQ(params.pe_step_size, 10);
   EXPECT_FALSE(params.diagonal_scale);
+  EXPECT_FALSE(params.cl1_compensated_sum);
+  EXPECT_FALSE(params.dense_linear_solver);
+  EXPECT_TRUE(params.vectorized_gammas);
+  EXPECT_TRUE(params.compiled_rates);
+  EXPECT_EQ(params.cvode_jacobian_threads, 1);
+  EXPECT_DOUBLE_EQ(params.cvode_jacobian_reuse, 0);
 }
 
 inline void compare_params(const PhreeqcKnobsParams &params) {
@@ -57,6 +75,12 @@ inline void compare_params(const PhreeqcKnobsParams &params) {
   EXPECT_DOUBLE_EQ(params.step_size, 200);
   EXPECT_DOUBLE_EQ(params.pe_step_size, 20);
   EXPECT_TRUE(params.diagonal_scale);
+  EXPECT_TRUE(params.cl1_compensated_sum);
+  EXPECT_TRUE(params.dense_linear_solver);
+  EXPECT_FALSE(params.vectorized_gammas);
+  EXPECT_FALSE(params.compiled_rates);
+  EXPECT_EQ(params.cvode_jacobian_threads, 4);
+  EXPECT_DOUBLE_EQ(params.cvode_jacobian_reuse, 0.01);
 }
 
 POET_TEST(PhreeqcKnobsSetFromScript) {
@@ -94,4 +118,239 @@ POET_TEST(PhreeqcKnobsSetFromClass) {
   const PhreeqcKnobsParams params = new_knobs.getParams();
 
   compare_params(params);
-}
\ No newline at end of file
+}
+
+POET_TEST(PhreeqcKnobsRejectInvalidJacobianOptions) {
+  const char *invalid[] = {"KNOBS\n -cvode_jacobian_threads 0\nEND\n",
+                           "KNOBS\n -cvode_jacobian_threads many\nEND\n",
+                           "KNOBS\n -cvode_jacobian_reuse -0.1\nEND\n",
+                           "KNOBS\n -cvode_jacobian_reuse\nEND\n"};
+
+  for (const char *input : invalid) {
+    IPhreeqc pqc;
+
+    pqc.LoadDatabaseString(barite_db.c_str());
+    EXPECT_GT(pqc.RunString(input), 0) << input;
+
+    PhreeqcKnobs knobs(pqc.GetPhreeqcPtr());
+    const PhreeqcKnobsParams params = knobs.getParams();
+
+    EXPECT_EQ(params.cvode_jacobian_threads, 1) << input;
+    EXPECT_DOUBLE_EQ(params.cvode_jacobian_reuse, 0) << input;
+  }
+}
+
+// Na+ uses the LLNL model, so all grouped activity models are covered
+const std::string gammas_input = R"(
+LLNL_AQUEOUS_MODEL_PARAMETERS
+    -temperatures 0.01 25 60 100 150 200 250 300
+    -dh_a 0.4939 0.5114 0.5465 0.5995 0.6855 0.7994 0.9593 1.218
+    -dh_b 0.3253 0.3288 0.3346 0.3421 0.3525 0.3639 0.3766 0.3925
+    -bdot 0.0374 0.041 0.0438 0.046 0.047 0.047 0.034 0
+    -co2_coefs -1.0312 0.0012806 255.9 0.4445 -0.001606
+SOLUTION_SPECIES
+Na+ = Na+
+    -llnl_gamma 4
+    log_k 0
+SOLUTION 1
+    units mol/kgw
+    temp 40
+    pH 8.2
+    Ca 0.01
+    Mg 0.05
+    Na 0.45
+    K 0.01
+    S(6) 0.03
+    C(4) 0.002
+    Cl 0.55 charge
+EXCHANGE 1
+    X 0.05
+    -equilibrate 1
+SELECTED_OUTPUT
+    -reset false
+    -ionic_strength true
+    -activities Ca+2 Mg+2 Na+ K+ Cl- SO4-2 HCO3- CO3-2 CO2 CaSO4 OH-
+    -molalities CaX2 MgX2 NaX KX
+END
+)";
+
+static std::vector<double> run_gammas_input(bool vectorized) {
+  IPhreeqc pqc;
+
+  EXPECT_EQ(pqc.LoadDatabaseString(phreeqc_db.c_str()), 0);
+  pqc.RunString(vectorized ? "KNOBS\n -vectorized_gammas true\nEND\n"
+                           : "KNOBS\n -vectorized_gammas false\nEND\n");
+  EXPECT_EQ(pqc.RunString(gammas_input.c_str()), 0) << pqc.GetErrorString();
+
+  std::vector<double> values;
+  const int row = pqc.GetSelectedOutputRowCount() - 1;
+  for (int col = 0; col < pqc.GetSelectedOutputColumnCount(); col++) {
+    int type;
+    double value;
+    char svalue[100];
+    pqc.GetSelectedOutputValue2(row, col, &type, &value, svalue,
+                                sizeof(svalue));
+    values.push_back(value);
+  }
+  return values;
+}
+
+POET_TEST(PhreeqcKnobsVectorizedGammasGolden) {
+  const std::vector<double> scalar = run_gammas_input(false);
+  const std::vector<double> vectorized = run_gammas_input(true);
+
+  ASSERT_EQ(scalar.size(), 16);
+  ASSERT_EQ(vectorized.size(), scalar.size());
+
+  for (std::size_t i = 0; i < scalar.size(); i++) {
+    EXPECT_NEAR(vectorized[i], scalar[i],
+                std::numeric_limits<double>::epsilon() * std::abs(scalar[i]))
+        << "column " << i;
+  }
+}
+
+// the solutions are defined first, the inputs react them
+const std::string cd_music_solution = R"(
+SURFACE_MASTER_SPECIES
+    Goe_uni Goe_uniOH1.5
+    Goe_tri Goe_triOH0.5
+SURFACE_SPECIES
+    Goe_triOH0.5 = Goe_triOH0.5
+        -cd_music 0 0 0 0 0
+        log_k 0
+    Goe_triOH0.5 = Goe_triO-0.5 + 0.5H+
+        -cd_music -0.5 0 0 0 0
+        log_k 10
+    Goe_triO-0.5 + H+ = Goe_triOH+0.5
+        -cd_music 1 0 0 0 0
+        log_k 9.20
+    Goe_triO-0.5 + Na+ = Goe_triONa+0.5
+        -cd_music 0 1 0 0 0
+        log_k -0.60
+    Goe_uniOH1.5 = Goe_uniOH1.5
+        -cd_music 0 0 0 0 0
+        log_k 0
+    Goe_uniOH1.5 = Goe_uniOH-0.5 + 0.5H+
+        -cd_music -0.5 0 0 0 0
+        log_k 10
+    Goe_uniOH-0.5 + H+ = Goe_uniOH2+0.5
+        -cd_music 1 0 0 0 0
+        log_k 9.20
+    Goe_uniOH-0.5 + Na+ = Goe_uniOHNa+0.5
+        -cd_music 0 1 0 0 0
+        log_k -0.60
+SOLUTION 1
+    units mol/kgw
+    pH 5
+    Na 0.001
+    K 0.001
+    Cl 0.002
+END
+)";
+
+const std::string cd_music_input = R"(
+USE solution 1
+SURFACE 1
+    Goe_uniOH1.5 3.45 98 1
+    Goe_triOH0.5 2.7
+    -cd_music
+    -sites_units density
+    -capacitances 0.85 0.75
+    -equilibrate 1
+SELECTED_OUTPUT
+    -reset false
+    -pH true
+    -ionic_strength true
+    -molalities Goe_uniOH2+0.5 Goe_uniOHNa+0.5 Goe_triOH+0.5 K+
+END
+)";
+
+const std::string gas_phase_solution = R"(
+SOLUTION 1
+    units mol/kgw
+    pH 7
+    Ca 0.001
+    C(4) 0.002 charge
+END
+)";
+
+// Peng-Robinson fixed-volume gas phase
+const std::string gas_phase_input = R"(
+USE solution 1
+EQUILIBRIUM_PHASES 1
+    Calcite 0 1
+GAS_PHASE 1
+    -fixed_volume
+    -volume 1
+    CO2(g) 0.1
+    CH4(g) 0.01
+SELECTED_OUTPUT
+    -reset false
+    -pH true
+    -ionic_strength true
+    -gases CO2(g) CH4(g)
+END
+)";
+
+struct numerical_jacobian_run {
+  std::vector<double> values;
+  std::size_t analytic_columns;
+};
+
+static numerical_jacobian_run run_numerical_jacobian(const std::string &solution,
+                                                     const std::string &input,
+                                                     bool numerical_deriv) {
+  IPhreeqc pqc;
+
+  EXPECT_EQ(pqc.LoadDatabaseString(phreeqc_db.c_str()), 0);
+  pqc.RunString(numerical_deriv ? "KNOBS\n -numerical_derivatives true\n"
+                                  " -numerical_fixed_volume true\nEND\n"
+                                : "KNOBS\n -numerical_fixed_volume true\nEND\n");
+  EXPECT_EQ(pqc.RunString(solution.c_str()), 0) << pqc.GetErrorString();
+  const std::size_t analytic =
+      pqc.GetPhreeqcPtr()->Get_count_analytic_columns();
+  EXPECT_EQ(pqc.RunString(input.c_str()), 0) << pqc.GetErrorString();
+
+  numerical_jacobian_run run;
+  run.analytic_columns =
+      pqc.GetPhreeqcPtr()->Get_count_analytic_columns() - analytic;
+  const int row = pqc.GetSelectedOutputRowCount() - 1;
+  for (int col = 0; col < pqc.GetSelectedOutputColumnCount(); col++) {
+    int type;
+    double value;
+    char svalue[100];
+    pqc.GetSelectedOutputValue2(row, col, &type, &value, svalue,
+                                sizeof(svalue));
+    run.values.push_back(value);
+  }
+  return run;
+}
+
+// keeping the analytical columns gives other iterates than perturbing all
+// columns, the gas moles agree to about 1e-6 relative
+static void expect_analytic_columns_parity(const std::string &solution,
+                                           const std::string &input) {
+  const numerical_jacobian_run full =
+      run_numerical_jacobian(solution, input, true);
+  const numerical_jacobian_run mixed =
+      run_numerical_jacobian(solution, input, false);
+
+  EXPECT_EQ(full.analytic_columns, 0);
+  EXPECT_GT(mixed.analytic_columns, 0);
+
+  ASSERT_FALSE(full.values.empty());
+  ASSERT_EQ(mixed.values.size(), full.values.size());
+  for (std::size_t i = 0; i < full.values.size(); i++) {
+    EXPECT_NEAR(mixed.values[i], full.values[i],
+                1e-5 * std::abs(full.values[i]))
+        << "column " << i;
+  }
+}
+
+POET_TEST(PhreeqcNumericalJacobianAnalyticColumnsCdMusic) {
+  expect_analytic_columns_parity(cd_music_solution, cd_music_input);
+}
+
+POET_TEST(PhreeqcNumericalJacobianAnalyticColumnsGasPhase) {
+  expect_analytic_columns_parity(gas_phase_solution, gas_phase_input);
+}
@@ -261,3 +261,18 @@ POET_TEST(PhreeqcMatrixWithoutRedoxAndH0O0) {
 
   EXPECT_EQ(expected_names_without_redox, pqc_mat.getSolutionNames());
 }
+
+POET_TEST(PhreeqcMatrixDatabasePrototype) {
+  PhreeqcMatrix empty_mat;
+  EXPECT_EQ(empty_mat.getDatabasePrototype(), nullptr);
+
+  PhreeqcMatrix pqc_mat(base_db, base_test::script);
+  EXPECT_NE(pqc_mat.getDatabasePrototype(), nullptr);
+
+  // copies and subsets share the parsed database
+  PhreeqcMatrix pqc_mat_copy(pqc_mat);
+  EXPECT_EQ(pqc_mat_copy.getDatabasePrototype(),
+            pqc_mat.getDatabasePrototype());
+  EXPECT_EQ(pqc_mat.subset({1}).getDatabasePrototype(),
+            pqc_mat.getDatabasePrototype());
+}
@@ -17,6 +17,7 @@
 #include <cmath>
 #include <cstddef>
 #include <gtest/gtest.h>
+#include <string>
 #include <testInput.hpp>
 #include <vector>
 
@@ -25,14 +26,62 @@ const std::string test_script = readFile(barite_test::script);
 
 constexpr std::size_t num_cells = 10;
 
+using Field = std::vector<std::vector<double>>;
+
+// the two cell templates of the barite test script used by most tests
+PhreeqcMatrix makeRunnerMatrix() {
+  PhreeqcMatrix pqc_mat(test_database, test_script);
+  return pqc_mat.subset({2, 3});
+}
+
+// num_cells cells of the two templates of `matrix`; every `period`-th cell,
+// starting with the first, is a copy of the first template
+Field makeRunnerField(const PhreeqcMatrix &matrix, std::size_t period = 2) {
+  const auto stl_mat = matrix.get();
+  const auto num_columns = stl_mat.names.size();
+
+  Field field;
+
+  for (std::size_t index = 0; index < num_cells; ++index) {
+    const auto row_begin =
+        stl_mat.values.begin() + (index % period == 0 ? 0 : num_columns);
+    field.push_back(std::vector<double>(row_begin, row_begin + num_columns));
+  }
+
+  return field;
+}
+
+// bitwise equality, where NaN marks a column unused by the cell template
+void expectValueEqual(double expected, double actual) {
+  if (std::isnan(expected)) {
+    EXPECT_TRUE(std::isnan(actual));
+  } else {
+    EXPECT_EQ(actual, expected);
+  }
+}
+
+void expectFieldsEqual(const Field &expected, const Field &actual) {
+  ASSERT_EQ(actual.size(), expected.size());
+
+  for (std::size_t cell_index = 0; cell_index < expected.size();
+       ++cell_index) {
+    ASSERT_EQ(actual[cell_index].size(), expected[cell_index].size());
+
+    for (std::size_t i = 0; i < expected[cell_index].size(); ++i) {
+      SCOPED_TRACE("cell " + std::to_string(cell_index) + ", column " +
+                   std::to_string(i));
+      expectValueEqual(expected[cell_index][i], actual[cell_index][i]);
+    }
+  }
+}
+
 POET_TEST(PhreeqcRunnerConstructor) {
   PhreeqcMatrix pqc_mat(test_database, test_script);
   EXPECT_NO_THROW(PhreeqcRunner tmp(pqc_mat));
 }
 
 POET_TEST(PhreeqcRunnerSimulation) {
-  PhreeqcMatrix pqc_mat(test_database, test_script);
-  const auto subsetted_pqc_mat = pqc_mat.subset({2, 3});
+  const auto subsetted_pqc_mat = makeRunnerMatrix();
   PhreeqcRunner runner(subsetted_pqc_mat);
 
   const auto stl_mat = subsetted_pqc_mat.get();
@@ -88,8 +137,7 @@ POET_TEST(PhreeqcRunnerUnknownID) {
 }
 
 POET_TEST(PhreeqcRunnerSimulationWithIgnoredCells) {
-  PhreeqcMatrix pqc_mat(test_database, test_script);
-  const auto subsetted_pqc_mat = pqc_mat.subset({2, 3});
+  const auto subsetted_pqc_mat = makeRunnerMatrix();
   PhreeqcRunner runner(subsetted_pqc_mat);
 
   const auto stl_mat = subsetted_pqc_mat.get();
@@ -108,3 +156,234 @@ POET_TEST(PhreeqcRunnerSimulationWithIgnoredCells) {
     EXPECT_DOUBLE_EQ(simulationInOut[0][i], second_line[i]);
   }
 }
+
+POET_TEST(PhreeqcRunnerParallelIdenticalToSerial) {
+  const auto subsetted_pqc_mat = makeRunnerMatrix();
+
+  auto serialInOut = makeRunnerField(subsetted_pqc_mat);
+  auto parallelInOut = serialInOut;
+
+  PhreeqcRunner serial_runner(subsetted_pqc_mat);
+  PhreeqcRunner parallel_runner(subsetted_pqc_mat, 3);
+
+  // a serial runner starts each cell from the previous one unless asked not to
+  EXPECT_FALSE(serial_runner.resetStartValues());
+  EXPECT_TRUE(parallel_runner.resetStartValues());
+  serial_runner.setResetStartValues(true);
+
+  EXPECT_EQ(parallel_runner.numThreads(), 3);
+  EXPECT_EQ(parallel_runner.numEngines(), 2);
+  EXPECT_EQ(parallel_runner.totalEngines(), 6);
+
+  EXPECT_NO_THROW(serial_runner.run(serialInOut, 100));
+  EXPECT_NO_THROW(parallel_runner.run(parallelInOut, 100));
+
+  expectFieldsEqual(serialInOut, parallelInOut);
+
+  const auto stats = parallel_runner.getThreadStats();
+  ASSERT_EQ(stats.size(), 3);
+
+  std::size_t simulated_cells = 0;
+  for (const auto &thread_stats : stats) {
+    EXPECT_GE(thread_stats.busy_seconds, 0);
+    simulated_cells += thread_stats.cells;
+  }
+  EXPECT_EQ(simulated_cells, num_cells);
+}
+
+POET_TEST(PhreeqcRunnerParallelUnknownID) {
+  PhreeqcMatrix pqc_mat(test_database, test_script);
+  PhreeqcRunner runner(pqc_mat, 2);
+
+  std::vector<std::vector<double>> simulationInOut;
+
+  for (std::size_t index = 0; index < num_cells; ++index) {
+    simulationInOut.push_back(std::vector<double>(pqc_mat.get().names.size()));
+  }
+
+  simulationInOut[num_cells - 1][0] = 1000;
+
+  EXPECT_THROW(runner.run(simulationInOut, 100), std::out_of_range);
+  EXPECT_THROW(PhreeqcRunner(pqc_mat, 0), std::invalid_argument);
+}
+
+POET_TEST(PhreeqcRunnerEnginePool) {
+  const auto subsetted_pqc_mat = makeRunnerMatrix();
+
+  auto templateInOut = makeRunnerField(subsetted_pqc_mat, 3);
+  auto poolInOut = templateInOut;
+
+  PhreeqcRunner template_runner(subsetted_pqc_mat);
+  PhreeqcRunner pool_runner(subsetted_pqc_mat, 2,
+                            PhreeqcRunner::EngineMode::POOL);
+  template_runner.setResetStartValues(true);
+
+  EXPECT_EQ(template_runner.numEngines(), 2);
+  EXPECT_EQ(pool_runner.numEngines(), 1);
+  EXPECT_EQ(pool_runner.totalEngines(), 2);
+
+  for (int step = 0; step < 2; ++step) {
+    EXPECT_NO_THROW(template_runner.run(templateInOut, 100));
+    EXPECT_NO_THROW(pool_runner.run(poolInOut, 100));
+  }
+
+  expectFieldsEqual(templateInOut, poolInOut);
+}
+
+POET_TEST(PhreeqcRunnerWarmStart) {
+  const auto subsetted_pqc_mat = makeRunnerMatrix();
+  const auto names = subsetted_pqc_mat.get().names;
+
+  auto coldInOut = makeRunnerField(subsetted_pqc_mat);
+
+  auto serialInOut = coldInOut;
+  auto parallelInOut = coldInOut;
+
+  PhreeqcRunner cold_runner(subsetted_pqc_mat);
+  PhreeqcRunner serial_runner(subsetted_pqc_mat);
+  PhreeqcRunner parallel_runner(subsetted_pqc_mat, 3);
+  serial_runner.setResetStartValues(true);
+
+  EXPECT_FALSE(serial_runner.warmStart());
+  serial_runner.setWarmStart(true);
+  parallel_runner.setWarmStart(true);
+  EXPECT_TRUE(serial_runner.warmStart());
+
+  for (int step = 0; step < 3; ++step) {
+    EXPECT_NO_THROW(cold_runner.run(coldInOut, 100));
+    EXPECT_NO_THROW(serial_runner.run(serialInOut, 100));
+    EXPECT_NO_THROW(parallel_runner.run(parallelInOut, 100));
+  }
+
+  // the state is kept per row, thus independent of the thread
+  expectFieldsEqual(serialInOut, parallelInOut);
+
+  for (std::size_t cell_index = 0; cell_index < num_cells; ++cell_index) {
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      const double cold = coldInOut[cell_index][i];
+      if (std::isnan(cold)) {
+        EXPECT_TRUE(std::isnan(serialInOut[cell_index][i]));
+        continue;
+      }
+
+      // different start values only change the result within the tolerance
+      // of the solver; pe and the charge are too sensitive to compare
+      if (names[i] == "pe" || names[i] == "Charge") {
+        continue;
+      }
+      EXPECT_NEAR(serialInOut[cell_index][i], cold,
+                  std::abs(cold) * 1e-6 + 1e-12);
+    }
+  }
+}
+
+POET_TEST(PhreeqcRunnerContiguousField) {
+  const auto subsetted_pqc_mat = makeRunnerMatrix();
+  const auto num_columns = subsetted_pqc_mat.get().names.size();
+
+  auto simulationInOut = makeRunnerField(subsetted_pqc_mat);
+
+  std::vector<double> row_major(num_cells * num_columns);
+  std::vector<double> column_major(num_cells * num_columns);
+
+  for (std::size_t cell_index = 0; cell_index < num_cells; ++cell_index) {
+    for (std::size_t i = 0; i < num_columns; ++i) {
+      row_major[cell_index * num_columns + i] = simulationInOut[cell_index][i];
+      column_major[i * num_cells + cell_index] = simulationInOut[cell_index][i];
+    }
+  }
+
+  PhreeqcRunner runner(subsetted_pqc_mat, 2);
+
+  EXPECT_NO_THROW(runner.run(simulationInOut, 100));
+  EXPECT_NO_THROW(runner.run(row_major, num_columns, 100));
+  EXPECT_NO_THROW(runner.run(column_major, num_columns, 100,
+                             PhreeqcRunner::Layout::COLUMN_MAJOR));
+
+  for (std::size_t cell_index = 0; cell_index < num_cells; ++cell_index) {
+    for (std::size_t i = 0; i < num_columns; ++i) {
+      const double expected = simulationInOut[cell_index][i];
+
+      expectValueEqual(expected, row_major[cell_index * num_columns + i]);
+      expectValueEqual(expected, column_major[i * num_cells + cell_index]);
+    }
+  }
+
+  EXPECT_THROW(runner.run(row_major, num_columns - 1, 100),
+               std::invalid_argument);
+  EXPECT_THROW(
+      runner.run(std::span<double>(row_major).first(num_columns + 1),
+                 num_columns, 100),
+      std::invalid_argument);
+}
+
+POET_TEST(PhreeqcRunnerResultCache) {
+  const auto subsetted_pqc_mat = makeRunnerMatrix();
+
+  auto uncachedInOut = makeRunnerField(subsetted_pqc_mat);
+  auto cachedInOut = uncachedInOut;
+
+  PhreeqcRunner uncached_runner(subsetted_pqc_mat);
+  PhreeqcRunner cached_runner(subsetted_pqc_mat, 2);
+  uncached_runner.setResetStartValues(true);
+
+  EXPECT_FALSE(cached_runner.resultCache());
+  EXPECT_THROW(cached_runner.setResultCache(1 << 20, -1),
+               std::invalid_argument);
+  cached_runner.setResultCache(1 << 20);
+  EXPECT_TRUE(cached_runner.resultCache());
+
+  EXPECT_NO_THROW(uncached_runner.run(uncachedInOut, 100));
+  EXPECT_NO_THROW(cached_runner.run(cachedInOut, 100));
+
+  // only two distinct cells are simulated, all others are copies
+  auto stats = cached_runner.getCacheStats();
+  EXPECT_EQ(stats.misses + stats.hits, num_cells);
+  EXPECT_GE(stats.misses, 2);
+  EXPECT_EQ(stats.entries, 2);
+  EXPECT_EQ(stats.evictions, 0);
+  EXPECT_GT(stats.bytes, 0);
+
+  expectFieldsEqual(uncachedInOut, cachedInOut);
+
+  // a different time step is a different key
+  EXPECT_NO_THROW(cached_runner.run(cachedInOut, 200));
+  EXPECT_EQ(cached_runner.getCacheStats().entries, 4);
+
+  // a budget too small for both entries evicts the least recently used one
+  const std::size_t budget = stats.bytes - 1;
+  cached_runner.setResultCache(budget);
+  EXPECT_NO_THROW(cached_runner.run(cachedInOut, 100));
+  stats = cached_runner.getCacheStats();
+  EXPECT_EQ(stats.entries, 1);
+  EXPECT_GT(stats.evictions, 0);
+  EXPECT_LE(stats.bytes, budget);
+
+  cached_runner.clearResultCache();
+  EXPECT_EQ(cached_runner.getCacheStats().entries, 0);
+
+  cached_runner.setResultCache(0);
+  EXPECT_FALSE(cached_runner.resultCache());
+  EXPECT_EQ(cached_runner.getCacheStats().hits, 0);
+}
+
+POET_TEST(PhreeqcRunnerLogKCache) {
+  const auto subsetted_pqc_mat = makeRunnerMatrix();
+
+  auto simulationInOut = makeRunnerField(subsetted_pqc_mat);
+
+  PhreeqcRunner runner(subsetted_pqc_mat, 3);
+
+  EXPECT_NO_THROW(runner.run(simulationInOut, 100));
+  const auto first = runner.getLogKCacheStats();
+  EXPECT_GT(first.hits, 0);
+  EXPECT_GT(first.entries, 0);
+
+  // all cells stay at the same temperature and pressure, thus every engine
+  // keeps the log K's of its model without looking up the shared cache
+  EXPECT_NO_THROW(runner.run(simulationInOut, 100));
+  const auto second = runner.getLogKCacheStats();
+  EXPECT_EQ(second.hits, first.hits);
+  EXPECT_EQ(second.misses, first.misses);
+  EXPECT_EQ(second.entries, first.entries);
+}
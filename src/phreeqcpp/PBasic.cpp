@@ -6024,80 +6024,84 @@ void PBasic::exec(void) {
       }
     } while (stmtline != NULL);
   } catch (const PBasicStop &) {
-    //_Ltry1:
-    if (P_escapecode == -20)
-      PhreeqcPtr->warning_msg("Break");
-    /* printf("Break"); */
-    else if (P_escapecode != 42) {
-      switch (P_escapecode) {
-
-      case -4: {
-        char *error_string =
-            PhreeqcPtr->sformatf("Integer overflow in BASIC line\n %ld %s",
-                                 stmtline->num, stmtline->inbuf);
-        PhreeqcPtr->warning_msg(error_string);
-      } break;
+    exec_error();
+  } // end catch
+} /*exec */
 
-      case -5: {
-        char *error_string =
-            PhreeqcPtr->sformatf("Divide by zero in BASIC line\n %ld %s",
-                                 stmtline->num, stmtline->inbuf);
-        PhreeqcPtr->warning_msg(error_string);
-      } break;
+void PBasic::exec_error(void) {
+  //_Ltry1:
+  if (P_escapecode == -20)
+    PhreeqcPtr->warning_msg("Break");
+  /* printf("Break"); */
+  else if (P_escapecode != 42) {
+    switch (P_escapecode) {
+
+    case -4: {
+      char *error_string =
+          PhreeqcPtr->sformatf("Integer overflow in BASIC line\n %ld %s",
+                               stmtline->num, stmtline->inbuf);
+      PhreeqcPtr->warning_msg(error_string);
+    } break;
 
-      case -6: {
-        char *error_string =
-            PhreeqcPtr->sformatf("Real math overflow in BASIC line\n %ld %s",
-                                 stmtline->num, stmtline->inbuf);
-        PhreeqcPtr->warning_msg(error_string);
-      } break;
+    case -5: {
+      char *error_string =
+          PhreeqcPtr->sformatf("Divide by zero in BASIC line\n %ld %s",
+                               stmtline->num, stmtline->inbuf);
+      PhreeqcPtr->warning_msg(error_string);
+    } break;
 
-      case -7: {
-        char *error_string =
-            PhreeqcPtr->sformatf("Real math underflow in BASIC line\n %ld %s",
-                                 stmtline->num, stmtline->inbuf);
-        PhreeqcPtr->warning_msg(error_string);
-      } break;
-
-      case -8:
-      case -19:
-      case -18:
-      case -17:
-      case -16:
-      case -15: {
-        char *error_string =
-            PhreeqcPtr->sformatf("Value range error in BASIC line\n %ld %s",
-                                 stmtline->num, stmtline->inbuf);
-        PhreeqcPtr->warning_msg(error_string);
-      } break;
+    case -6: {
+      char *error_string =
+          PhreeqcPtr->sformatf("Real math overflow in BASIC line\n %ld %s",
+                               stmtline->num, stmtline->inbuf);
+      PhreeqcPtr->warning_msg(error_string);
+    } break;
 
-      case -10: {
-        char *error_string =
-            PhreeqcPtr->sformatf("I/O Error %d", (int)P_ioresult);
-        PhreeqcPtr->warning_msg(error_string);
-      } break;
+    case -7: {
+      char *error_string =
+          PhreeqcPtr->sformatf("Real math underflow in BASIC line\n %ld %s",
+                               stmtline->num, stmtline->inbuf);
+      PhreeqcPtr->warning_msg(error_string);
+    } break;
 
-      default:
-        if (EXCP_LINE != -1) {
-          char *error_string = PhreeqcPtr->sformatf("%12ld\n", EXCP_LINE);
-          PhreeqcPtr->warning_msg(error_string);
-        }
-        _Escape(P_escapecode);
-        break;
+    case -8:
+    case -19:
+    case -18:
+    case -17:
+    case -16:
+    case -15: {
+      char *error_string =
+          PhreeqcPtr->sformatf("Value range error in BASIC line\n %ld %s",
+                               stmtline->num, stmtline->inbuf);
+      PhreeqcPtr->warning_msg(error_string);
+    } break;
+
+    case -10: {
+      char *error_string =
+          PhreeqcPtr->sformatf("I/O Error %d", (int)P_ioresult);
+      PhreeqcPtr->warning_msg(error_string);
+    } break;
+
+    default:
+      if (EXCP_LINE != -1) {
+        char *error_string = PhreeqcPtr->sformatf("%12ld\n", EXCP_LINE);
+        PhreeqcPtr->warning_msg(error_string);
       }
+      _Escape(P_escapecode);
+      break;
     }
-    if (stmtline != NULL) {
-      if (phreeqci_gui) {
-        _ASSERTE(nErrLineNumber == 0);
-        nErrLineNumber = stmtline->num;
-      } else {
-        char *error_string = PhreeqcPtr->sformatf(
-            " in BASIC line\n %ld %s", stmtline->num, stmtline->inbuf);
-        error_msg(error_string, CONTINUE);
-      }
+  }
+  if (stmtline != NULL) {
+    if (phreeqci_gui) {
+      _ASSERTE(nErrLineNumber == 0);
+      nErrLineNumber = stmtline->num;
+    } else {
+      char *error_string = PhreeqcPtr->sformatf(
+          " in BASIC line\n %ld %s", stmtline->num, stmtline->inbuf);
+      error_msg(error_string, CONTINUE);
     }
-  } // end catch
-} /*exec */
+  }
+}
 
 int PBasic::free_dim_stringvar(varrec *l_varbase) {
   int i, k;
@@ -6115,6 +6119,1115 @@ int PBasic::free_dim_stringvar(varrec *l_varbase) {
   return (OK);
 }
 
+/* ---------------------------------------------------------------------- */
+/*   Compiled rate programs                                               */
+/* ---------------------------------------------------------------------- */
+/*
+ *   A rate is run for every evaluation of the kinetic integrator. The
+ *   lines of the rate are compiled once into basic_program, a stack code
+ *   in which variables and line numbers are resolved and constant
+ *   subexpressions are folded. Factors, conditions and statements without
+ *   compiled form are handed to the interpreter; programs with loops,
+ *   subroutines or computed jumps are run by the interpreter entirely.
+ */
+static LDBLE basic_operator(int op, LDBLE n, LDBLE n2) {
+  LDBLE r;
+
+  switch (op) {
+  case basic_program::OP_ADD:
+    return n + n2;
+  case basic_program::OP_SUB:
+    return n - n2;
+  case basic_program::OP_MUL:
+    return n * n2;
+  case basic_program::OP_DIV:
+    return n / n2;
+  case basic_program::OP_MOD:
+    if (n != 0)
+      return fabs(n) / n * fmod(fabs(n) + 1e-14, n2);
+    return 0;
+  case basic_program::OP_POW:
+    if (n >= 0)
+      return (n > 0) ? exp(n2 * log(n)) : n;
+    r = exp(n2 * log(-n));
+    if (((long)n2) & 1)
+      r = -r;
+    return r;
+  case basic_program::OP_EQ:
+    return (bool)(n == n2);
+  case basic_program::OP_NE:
+    return (bool)(n < n2 || n > n2);
+  case basic_program::OP_LT:
+    return (bool)(n < n2);
+  case basic_program::OP_GT:
+    return (bool)(n > n2);
+  case basic_program::OP_LE:
+    return (bool)(n == n2 || n < n2);
+  case basic_program::OP_GE:
+    return (bool)(n == n2 || n > n2);
+  case basic_program::OP_AND:
+    return ((long)n) & ((long)n2);
+  case basic_program::OP_OR:
+    return ((long)n) | ((long)n2);
+  case basic_program::OP_XOR:
+    return ((long)n) ^ ((long)n2);
+  case basic_program::OP_NEG:
+    return -n;
+  case basic_program::OP_NOT:
+    return ~((long)floor(n + 0.5));
+  case basic_program::OP_SQR:
+    return n * n;
+  case basic_program::OP_SQRT:
+    return sqrt(n);
+  case basic_program::OP_SIN:
+    return sin(n);
+  case basic_program::OP_COS:
+    return cos(n);
+  case basic_program::OP_TAN:
+    return sin(n) / cos(n);
+  case basic_program::OP_ARCTAN:
+    return atan(n);
+  case basic_program::OP_LOG:
+    return log(n);
+  case basic_program::OP_LOG10:
+    return log10(n);
+  case basic_program::OP_EXP:
+    return exp(n);
+  case basic_program::OP_ABS:
+    return fabs(n);
+  case basic_program::OP_SGN:
+    return (double)(n > 0) - (double)(n < 0);
+  }
+  return 0;
+}
+
+/* functions of factor() that read no argument */
+static bool basic_function_no_arg(int kind) {
+  switch (kind) {
+  case PBasic::tokalk:
+  case PBasic::tokaphi:
+  case PBasic::tokcell_no:
+  case PBasic::tokcell_pore_volume:
+  case PBasic::tokporevolume:
+  case PBasic::tokcell_porosity:
+  case PBasic::tokcell_saturation:
+  case PBasic::tokcell_volume:
+  case PBasic::tokcharge_balance:
+  case PBasic::tokcurrent_a:
+  case PBasic::tokdebye_length:
+  case PBasic::tokdh_a:
+  case PBasic::tokdh_av:
+  case PBasic::tokdh_b:
+  case PBasic::tokdist:
+  case PBasic::tokeps_r:
+  case PBasic::tokgas_p:
+  case PBasic::tokgas_vm:
+  case PBasic::tokiterations:
+  case PBasic::tokkappa:
+  case PBasic::tokkin_time:
+  case PBasic::tokmu:
+  case PBasic::tokosmotic:
+  case PBasic::tokpercent_error:
+  case PBasic::tokpot_v:
+  case PBasic::tokpressure:
+  case PBasic::tokqbrn:
+  case PBasic::tokrho:
+  case PBasic::tokrho_0:
+  case PBasic::tokrxn:
+  case PBasic::toksc:
+  case PBasic::toksim_no:
+  case PBasic::toksim_time:
+  case PBasic::toksoln_vol:
+  case PBasic::tokstep_no:
+  case PBasic::toktotal_time:
+  case PBasic::toktransport_cell_no:
+  case PBasic::tokvelocity_x:
+  case PBasic::tokvelocity_y:
+  case PBasic::tokvelocity_z:
+  case PBasic::tokviscos:
+  case PBasic::tokviscos_0:
+    return true;
+  }
+  return false;
+}
+
+/* functions of factor() that may return a string */
+static bool basic_function_string(int kind) {
+  switch (kind) {
+  case PBasic::tokstr:
+  case PBasic::tokstr_:
+  case PBasic::tokchr_:
+  case PBasic::tokmid_:
+  case PBasic::tokltrim:
+  case PBasic::tokrtrim:
+  case PBasic::toktrim:
+  case PBasic::tokpad:
+  case PBasic::tokpad_:
+  case PBasic::tokeol_:
+  case PBasic::tokeol_notab_:
+  case PBasic::tokno_newline_:
+  case PBasic::tokdescription:
+  case PBasic::toktitle:
+  case PBasic::tokiso_unit:
+  case PBasic::tokget_:
+  case PBasic::tokstr_e_:
+  case PBasic::tokstr_f_:
+  case PBasic::tokkinetics_formula:
+  case PBasic::tokkinetics_formula_:
+  case PBasic::tokphase_formula:
+  case PBasic::tokphase_formula_:
+  case PBasic::tokspecies_formula:
+  case PBasic::tokspecies_formula_:
+  case PBasic::tokphase_equation:
+  case PBasic::tokphase_equation_:
+  case PBasic::tokspecies_equation:
+  case PBasic::tokspecies_equation_:
+    return true;
+  }
+  return false;
+}
+
+static bool basic_eos(const tokenrec *t) {
+  return (t == NULL || t->kind == PBasic::tokelse ||
+          t->kind == PBasic::tokcolon);
+}
+
+static tokenrec *basic_skip_eos(tokenrec *t) {
+  while (!basic_eos(t))
+    t = t->next;
+  return t;
+}
+
+/* token after the parentheses starting at t, false if they are not closed */
+static bool basic_skip_paren(tokenrec *t, tokenrec **end) {
+  long depth = 0;
+
+  while (t != NULL) {
+    if (t->kind == PBasic::toklp) {
+      depth++;
+    } else if (t->kind == PBasic::tokrp && --depth == 0) {
+      *end = t->next;
+      return true;
+    }
+    t = t->next;
+  }
+  return false;
+}
+
+int PBasic::basic_run_program(void **program, void *lnbase, void *vbase,
+                              void *lpbase) {
+  char l_command[] = "run";
+  basic_program *program_ptr;
+
+  if (*program == NULL) {
+    linebase = (linerec *)lnbase;
+    *program = (void *)compile_program((linerec *)lnbase);
+  }
+  program_ptr = (basic_program *)*program;
+  if (program_ptr->interpret || parse_all || phreeqci_gui)
+    return basic_run(l_command, lnbase, vbase, lpbase);
+  if (program_ptr->serial != PhreeqcPtr->definitions_serial)
+    bind_program(program_ptr);
+
+  P_escapecode = 0;
+  P_ioresult = 0;
+  inbuf = l_command;
+  linebase = (linerec *)lnbase;
+  varbase = (varrec *)vbase;
+  loopbase = (looprec *)lpbase;
+  exitflag = false;
+  clearvars();
+  clearloops();
+  restoredata();
+  try {
+    run_program(program_ptr);
+  } catch (const PBasicStop &) {
+    exec_error();
+  }
+  inbuf = NULL;
+
+  // Cleanup after run
+  clearvars();
+  clearloops();
+  restoredata();
+
+  return (P_escapecode);
+}
+
+void PBasic::basic_free_program(void **program) {
+  delete (basic_program *)*program;
+  *program = NULL;
+}
+
+bool PBasic::basic_program_compiled(const void *program) {
+  return (program != NULL && !((const basic_program *)program)->interpret);
+}
+
+basic_program *PBasic::compile_program(linerec *lines) {
+  struct LOC_compile C;
+  std::map<linerec *, size_t> starts;
+  linerec *l;
+  tokenrec *t;
+  bool ok;
+
+  basic_program *program = new basic_program;
+  program->interpret = false;
+  program->serial = 0;
+  C.program = program;
+  C.line = NULL;
+  C.depth = 0;
+  C.max_depth = 0;
+  /* subscripted variables are left to findvar */
+  for (l = lines; l != NULL; l = l->next) {
+    for (t = l->txt; t != NULL; t = t->next) {
+      if (t->kind == tokvar && t->next != NULL && t->next->kind == toklp)
+        C.arrays.insert(t->UU.vp);
+    }
+  }
+  ok = true;
+  for (l = lines; l != NULL && ok; l = l->next) {
+    starts[l] = program->code.size();
+    C.line = l;
+    program->code[emit(basic_program::OP_LINE, &C)].line = l;
+    ok = compile_sequence(l->txt, true, &C);
+    ok = ok && program->code.size() < basic_program::max_code;
+  }
+  starts[NULL] = emit(basic_program::OP_END, &C);
+  if (!ok || C.max_depth > basic_program::max_depth) {
+    program->code.clear();
+    program->interpret = true;
+    return program;
+  }
+  for (size_t i = 0; i < C.jumps.size(); i++) {
+    program->code[C.jumps[i].first].target = starts[C.jumps[i].second];
+  }
+  return program;
+}
+
+bool PBasic::compile_sequence(tokenrec *t, bool tail,
+                              struct LOC_compile *LINK) {
+  size_t i;
+
+  for (;;) {
+    while (t != NULL && t->kind == tokcolon)
+      t = t->next;
+    if (t == NULL)
+      break;
+    switch (t->kind) {
+
+    case tokrem:
+      t = t->next;
+      break;
+
+    case tokdata:
+      t = basic_skip_eos(t->next);
+      break;
+
+    case tokelse:
+      /* rest of the line belongs to an IF that is not taken */
+      t = NULL;
+      continue;
+
+    case tokend:
+      emit(basic_program::OP_END, LINK);
+      return true;
+
+    case tokgoto:
+      return compile_goto(t->next, LINK);
+
+    case tokif:
+      return compile_if(t, tail, LINK);
+
+    case toksave:
+      if (!compile_save(&t, LINK))
+        return false;
+      break;
+
+    case toklet:
+    case tokvar:
+      if (!compile_let(&t, LINK))
+        return false;
+      break;
+
+    case tokprint:
+    case tokpunch:
+    case tokput:
+    case tokput_:
+    case tokchange_por:
+    case tokchange_surf:
+    case tokread:
+    case tokrestore:
+    case tokpoke:
+      LINK->program->code[emit(basic_program::OP_STMT, LINK)].tok = t;
+      t = basic_skip_eos(t->next);
+      break;
+
+    default:
+      return false;
+    }
+    if (!basic_eos(t))
+      return false;
+  }
+  if (!tail) {
+    i = emit(basic_program::OP_JUMP, LINK);
+    LINK->jumps.push_back(std::make_pair(i, LINK->line->next));
+  }
+  return true;
+}
+
+bool PBasic::compile_if(tokenrec *t, bool tail, struct LOC_compile *LINK) {
+  tokenrec *then_tok, *e;
+  size_t mark, depth, jz, k;
+  long i;
+
+  then_tok = t->next;
+  while (then_tok != NULL && then_tok->kind != tokthen)
+    then_tok = then_tok->next;
+  if (then_tok == NULL)
+    return false;
+  mark = LINK->program->code.size();
+  depth = LINK->depth;
+  e = t->next;
+  if (!compile_expr(&e, LINK) || e != then_tok) {
+    compile_truncate(mark, depth, LINK);
+    k = emit(basic_program::OP_EXPR, LINK);
+    LINK->program->code[k].tok = t->next;
+    LINK->program->code[k].end = then_tok;
+  }
+  jz = emit(basic_program::OP_JUMPZ, LINK);
+
+  /* condition true */
+  e = then_tok->next;
+  if (e != NULL && e->kind == toknum) {
+    if (!compile_goto(e, LINK))
+      return false;
+  } else if (!compile_sequence(e, false, LINK)) {
+    return false;
+  }
+
+  /* condition false, skip to the matching ELSE like cmdif */
+  LINK->program->code[jz].target = LINK->program->code.size();
+  e = then_tok->next;
+  i = 0;
+  do {
+    if (e != NULL) {
+      if (e->kind == tokif)
+        i++;
+      if (e->kind == tokelse)
+        i--;
+      e = e->next;
+    }
+  } while (e != NULL && i >= 0);
+  if (e != NULL && e->kind == toknum)
+    return compile_goto(e, LINK);
+  return compile_sequence(e, tail, LINK);
+}
+
+bool PBasic::compile_goto(tokenrec *t, struct LOC_compile *LINK) {
+  linerec *l;
+  size_t i;
+
+  /* only constant line numbers, other targets are left to the interpreter */
+  if (t == NULL || t->kind != toknum || !basic_eos(t->next))
+    return false;
+  l = findline((long)floor(t->UU.num + 0.5));
+  if (l == NULL)
+    return false;
+  i = emit(basic_program::OP_JUMP, LINK);
+  LINK->jumps.push_back(std::make_pair(i, l));
+  return true;
+}
+
+bool PBasic::compile_let(tokenrec **t, struct LOC_compile *LINK) {
+  tokenrec *v, *e;
+  size_t mark, depth;
+
+  v = ((*t)->kind == toklet) ? (*t)->next : *t;
+  if (v != NULL && v->kind == tokvar && !v->UU.vp->stringvar &&
+      LINK->arrays.count(v->UU.vp) == 0 && v->next != NULL &&
+      v->next->kind == tokeq) {
+    mark = LINK->program->code.size();
+    depth = LINK->depth;
+    e = v->next->next;
+    if (compile_expr(&e, LINK) && basic_eos(e)) {
+      LINK->program->code[emit(basic_program::OP_LET, LINK)].vp = v->UU.vp;
+      *t = e;
+      return true;
+    }
+    compile_truncate(mark, depth, LINK);
+  }
+  LINK->program->code[emit(basic_program::OP_STMT, LINK)].tok = *t;
+  *t = basic_skip_eos((*t)->next);
+  return true;
+}
+
+bool PBasic::compile_save(tokenrec **t, struct LOC_compile *LINK) {
+  tokenrec *e;
+  size_t mark, depth;
+
+  mark = LINK->program->code.size();
+  depth = LINK->depth;
+  e = (*t)->next;
+  while (!basic_eos(e)) {
+    if (e->kind == toksemi || e->kind == tokcomma) {
+      e = e->next;
+      continue;
+    }
+    if (!compile_expr(&e, LINK)) {
+      compile_truncate(mark, depth, LINK);
+      LINK->program->code[emit(basic_program::OP_STMT, LINK)].tok = *t;
+      *t = basic_skip_eos((*t)->next);
+      return true;
+    }
+    emit(basic_program::OP_SAVE, LINK);
+  }
+  *t = e;
+  return true;
+}
+
+bool PBasic::compile_factor(tokenrec **t, struct LOC_compile *LINK) {
+  tokenrec *f, *s;
+  size_t i;
+  int op;
+
+  f = *t;
+  if (f == NULL)
+    return false;
+  *t = f->next;
+  switch (f->kind) {
+
+  case toknum:
+    LINK->program->code[emit(basic_program::OP_NUM, LINK)].num = f->UU.num;
+    return true;
+
+  case tokvar:
+    if (f->UU.vp->stringvar)
+      return false;
+    if (LINK->arrays.count(f->UU.vp) == 0) {
+      LINK->program->code[emit(basic_program::OP_VAR, LINK)].vp = f->UU.vp;
+      return true;
+    }
+    return compile_fallback(f, t, LINK);
+
+  case toklp:
+    if (!compile_expr(t, LINK) || *t == NULL || (*t)->kind != tokrp)
+      return false;
+    *t = (*t)->next;
+    return true;
+
+  case tokplus:
+    return compile_factor(t, LINK);
+
+  case tokminus:
+  case toknot:
+  case toksqr:
+  case toksqrt:
+  case toksin:
+  case tokcos:
+  case toktan:
+  case tokarctan:
+  case toklog:
+  case toklog10:
+  case tokexp:
+  case tokabs:
+  case toksgn:
+  case tokparm:
+    if (!compile_factor(t, LINK))
+      return false;
+    switch (f->kind) {
+    case tokminus:
+      op = basic_program::OP_NEG;
+      break;
+    case toknot:
+      op = basic_program::OP_NOT;
+      break;
+    case toksqr:
+      op = basic_program::OP_SQR;
+      break;
+    case toksqrt:
+      op = basic_program::OP_SQRT;
+      break;
+    case toksin:
+      op = basic_program::OP_SIN;
+      break;
+    case tokcos:
+      op = basic_program::OP_COS;
+      break;
+    case toktan:
+      op = basic_program::OP_TAN;
+      break;
+    case tokarctan:
+      op = basic_program::OP_ARCTAN;
+      break;
+    case toklog:
+      op = basic_program::OP_LOG;
+      break;
+    case toklog10:
+      op = basic_program::OP_LOG10;
+      break;
+    case tokexp:
+      op = basic_program::OP_EXP;
+      break;
+    case tokabs:
+      op = basic_program::OP_ABS;
+      break;
+    case toksgn:
+      op = basic_program::OP_SGN;
+      break;
+    default:
+      op = basic_program::OP_PARM;
+      break;
+    }
+    emit_operator(op, LINK);
+    return true;
+
+  case tokm:
+    emit(basic_program::OP_M, LINK);
+    return true;
+
+  case tokm0:
+    emit(basic_program::OP_M0, LINK);
+    return true;
+
+  case toktime:
+    emit(basic_program::OP_TIME, LINK);
+    return true;
+
+  case toktk:
+    emit(basic_program::OP_TK, LINK);
+    return true;
+
+  case toktc:
+    emit(basic_program::OP_TC, LINK);
+    return true;
+
+  case tokact:
+  case tokla:
+  case toklm:
+  case tokmol:
+  case toksr:
+  case toksi:
+  case toktot:
+    /* quoted names are resolved now, other arguments by the interpreter */
+    s = f->next;
+    if (s != NULL && s->kind == toklp && s->next != NULL &&
+        s->next->kind == tokstr && s->next->next != NULL &&
+        s->next->next->kind == tokrp) {
+      s = s->next;
+      *t = s->next->next;
+    } else if (s != NULL && s->kind == tokstr) {
+      *t = s->next;
+    } else {
+      return compile_fallback(f, t, LINK);
+    }
+    switch (f->kind) {
+    case tokact:
+      op = basic_program::OP_ACT;
+      break;
+    case tokla:
+      op = basic_program::OP_LA;
+      break;
+    case toklm:
+      op = basic_program::OP_LM;
+      break;
+    case tokmol:
+      op = basic_program::OP_MOL;
+      break;
+    case toksr:
+      op = basic_program::OP_SR;
+      break;
+    case toksi:
+      op = basic_program::OP_SI;
+      break;
+    default:
+      op = basic_program::OP_TOT;
+      break;
+    }
+    i = emit(op, LINK);
+    LINK->program->code[i].name = s->UU.sp;
+    return true;
+
+  default:
+    return compile_fallback(f, t, LINK);
+  }
+}
+
+bool PBasic::compile_fallback(tokenrec *f, tokenrec **t,
+                              struct LOC_compile *LINK) {
+  tokenrec *end;
+  size_t i;
+
+  if (basic_function_string(f->kind))
+    return false;
+  if (f->kind != tokvar && basic_function_no_arg(f->kind)) {
+    end = f->next;
+  } else if (f->next == NULL || f->next->kind != toklp ||
+             !basic_skip_paren(f->next, &end)) {
+    return false;
+  }
+  i = emit(basic_program::OP_FACTOR, LINK);
+  LINK->program->code[i].tok = f;
+  LINK->program->code[i].end = end;
+  *t = end;
+  return true;
+}
+
+bool PBasic::compile_upexpr(tokenrec **t, struct LOC_compile *LINK) {
+  if (!compile_factor(t, LINK))
+    return false;
+  if (*t != NULL && (*t)->kind == tokup) {
+    *t = (*t)->next;
+    if (!compile_upexpr(t, LINK))
+      return false;
+    emit_operator(basic_program::OP_POW, LINK);
+  }
+  return true;
+}
+
+bool PBasic::compile_term(tokenrec **t, struct LOC_compile *LINK) {
+  int k;
+
+  if (!compile_upexpr(t, LINK))
+    return false;
+  while (*t != NULL && ((*t)->kind == toktimes || (*t)->kind == tokdiv ||
+                        (*t)->kind == tokmod)) {
+    k = (*t)->kind;
+    *t = (*t)->next;
+    if (!compile_upexpr(t, LINK))
+      return false;
+    emit_operator((k == toktimes) ? basic_program::OP_MUL
+                  : (k == tokdiv) ? basic_program::OP_DIV
+                                  : basic_program::OP_MOD,
+                  LINK);
+  }
+  return true;
+}
+
+bool PBasic::compile_sexpr(tokenrec **t, struct LOC_compile *LINK) {
+  int k;
+
+  if (!compile_term(t, LINK))
+    return false;
+  while (*t != NULL && ((*t)->kind == tokplus || (*t)->kind == tokminus)) {
+    k = (*t)->kind;
+    *t = (*t)->next;
+    if (!compile_term(t, LINK))
+      return false;
+    emit_operator((k == tokplus) ? basic_program::OP_ADD
+                                 : basic_program::OP_SUB,
+                  LINK);
+  }
+  return true;
+}
+
+bool PBasic::compile_relexpr(tokenrec **t, struct LOC_compile *LINK) {
+  int k;
+
+  if (!compile_sexpr(t, LINK))
+    return false;
+  while (*t != NULL && (*t)->kind >= tokeq && (*t)->kind <= tokne) {
+    k = (*t)->kind;
+    *t = (*t)->next;
+    if (!compile_sexpr(t, LINK))
+      return false;
+    emit_operator(basic_program::OP_EQ + (k - tokeq), LINK);
+  }
+  return true;
+}
+
+bool PBasic::compile_andexpr(tokenrec **t, struct LOC_compile *LINK) {
+  if (!compile_relexpr(t, LINK))
+    return false;
+  while (*t != NULL && (*t)->kind == tokand) {
+    *t = (*t)->next;
+    if (!compile_relexpr(t, LINK))
+      return false;
+    emit_operator(basic_program::OP_AND, LINK);
+  }
+  return true;
+}
+
+bool PBasic::compile_expr(tokenrec **t, struct LOC_compile *LINK) {
+  int k;
+
+  if (!compile_andexpr(t, LINK))
+    return false;
+  while (*t != NULL && ((*t)->kind == tokor || (*t)->kind == tokxor)) {
+    k = (*t)->kind;
+    *t = (*t)->next;
+    if (!compile_andexpr(t, LINK))
+      return false;
+    emit_operator((k == tokor) ? basic_program::OP_OR : basic_program::OP_XOR,
+                  LINK);
+  }
+  return true;
+}
+
+size_t PBasic::emit(int op, struct LOC_compile *LINK) {
+  basic_program::instr in;
+
+  in.op = op;
+  switch (op) {
+  case basic_program::OP_NUM:
+  case basic_program::OP_VAR:
+  case basic_program::OP_FACTOR:
+  case basic_program::OP_EXPR:
+  case basic_program::OP_M:
+  case basic_program::OP_M0:
+  case basic_program::OP_TIME:
+  case basic_program::OP_TK:
+  case basic_program::OP_TC:
+  case basic_program::OP_ACT:
+  case basic_program::OP_LA:
+  case basic_program::OP_LM:
+  case basic_program::OP_MOL:
+  case basic_program::OP_SR:
+  case basic_program::OP_SI:
+  case basic_program::OP_TOT:
+    LINK->depth++;
+    break;
+  case basic_program::OP_JUMPZ:
+  case basic_program::OP_LET:
+  case basic_program::OP_SAVE:
+    LINK->depth--;
+    break;
+  default:
+    if (op >= basic_program::OP_ADD && op <= basic_program::OP_XOR)
+      LINK->depth--;
+    break;
+  }
+  if (LINK->depth > LINK->max_depth)
+    LINK->max_depth = LINK->depth;
+  LINK->program->code.push_back(in);
+  return LINK->program->code.size() - 1;
+}
+
+void PBasic::emit_operator(int op, struct LOC_compile *LINK) {
+  std::vector<basic_program::instr> &code = LINK->program->code;
+  size_t n = code.size();
+  LDBLE a, b;
+
+  /* fold constants unless the operator warns or fails at run time */
+  if (op >= basic_program::OP_ADD && op <= basic_program::OP_XOR) {
+    if (n >= 2 && code[n - 2].op == basic_program::OP_NUM &&
+        code[n - 1].op == basic_program::OP_NUM) {
+      a = code[n - 2].num;
+      b = code[n - 1].num;
+      if (!(op == basic_program::OP_DIV && b == 0) &&
+          !(op == basic_program::OP_POW && a < 0 && b != (long)b)) {
+        code[n - 2].num = basic_operator(op, a, b);
+        code.pop_back();
+        LINK->depth--;
+        return;
+      }
+    }
+  } else if (op != basic_program::OP_PARM && n >= 1 &&
+             code[n - 1].op == basic_program::OP_NUM) {
+    code[n - 1].num = basic_operator(op, code[n - 1].num, 0);
+    return;
+  }
+  emit(op, LINK);
+}
+
+void PBasic::compile_truncate(size_t mark, size_t depth,
+                              struct LOC_compile *LINK) {
+  LINK->program->code.resize(mark);
+  LINK->depth = depth;
+}
+
+/* resolve the quoted names of the program in the current species, phases and
+   master species; unresolved names are left to the name based functions */
+void PBasic::bind_program(basic_program *program) {
+  int l;
+
+  for (size_t i = 0; i < program->code.size(); i++) {
+    basic_program::instr &in = program->code[i];
+    switch (in.op) {
+    case basic_program::OP_ACT:
+    case basic_program::OP_LA:
+    case basic_program::OP_LM:
+    case basic_program::OP_MOL:
+      in.s = PhreeqcPtr->s_search(in.name);
+      break;
+    case basic_program::OP_SR:
+    case basic_program::OP_SI:
+      in.phase = PhreeqcPtr->phase_bsearch(in.name, &l, FALSE);
+      break;
+    case basic_program::OP_TOT:
+      in.master = NULL;
+      if (strcmp(in.name, "H") != 0 && strcmp(in.name, "O") != 0) {
+        std::string noplus = in.name;
+        PhreeqcPtr->replace(noplus, "(+", "(");
+        in.master = PhreeqcPtr->master_bsearch(noplus.c_str());
+      }
+      break;
+    }
+  }
+  program->serial = PhreeqcPtr->definitions_serial;
+}
+
+void PBasic::run_program(const basic_program *program) {
+  LDBLE stack[basic_program::max_depth];
+  LDBLE *sp = stack;
+  const basic_program::instr *code = &program->code[0];
+  const basic_program::instr *in;
+  struct LOC_exec V;
+  valrec n;
+  LDBLE l_dummy;
+  size_t pc = 0;
+  int i_rate;
+
+  stmtline = linebase;
+  for (;;) {
+    in = &code[pc++];
+    switch (in->op) {
+
+    case basic_program::OP_LINE:
+      stmtline = in->line;
+      break;
+
+    case basic_program::OP_END:
+      stmtline = NULL;
+      return;
+
+    case basic_program::OP_JUMP:
+      pc = in->target;
+      break;
+
+    case basic_program::OP_JUMPZ:
+      if (*--sp == 0)
+        pc = in->target;
+      break;
+
+    case basic_program::OP_STMT:
+      exec_statement(in->tok);
+      break;
+
+    case basic_program::OP_LET:
+      *in->vp->UU.U0.val = *--sp;
+      break;
+
+    case basic_program::OP_SAVE:
+      PhreeqcPtr->rate_moles = *--sp;
+      break;
+
+    case basic_program::OP_NUM:
+      *sp++ = in->num;
+      break;
+
+    case basic_program::OP_VAR:
+      *sp++ = *in->vp->UU.U0.val;
+      break;
+
+    case basic_program::OP_FACTOR:
+      V.gotoflag = false;
+      V.elseflag = false;
+      V.t = in->tok;
+      n = factor(&V);
+      if (n.stringval)
+        tmerr(": found characters, not a number");
+      if (V.t != in->end)
+        snerr("");
+      *sp++ = n.UU.val;
+      break;
+
+    case basic_program::OP_EXPR:
+      V.gotoflag = false;
+      V.elseflag = false;
+      V.t = in->tok;
+      *sp = realexpr(&V);
+      if (V.t != in->end)
+        require(tokthen, &V);
+      sp++;
+      break;
+
+    case basic_program::OP_DIV:
+      if (sp[-1] == 0) {
+        char *error_string = PhreeqcPtr->sformatf(
+            "Zero divide in BASIC line\n %ld %s.\nValue set to zero.",
+            stmtline->num, stmtline->inbuf);
+        PhreeqcPtr->warning_msg(error_string);
+        sp[-2] = 0;
+      } else {
+        sp[-2] /= sp[-1];
+      }
+      sp--;
+      break;
+
+    case basic_program::OP_POW:
+      if (sp[-2] < 0 && sp[-1] != (long)sp[-1])
+        tmerr(": negative number cannot be raised to a fractional power.");
+      sp[-2] = basic_operator(in->op, sp[-2], sp[-1]);
+      sp--;
+      break;
+
+    case basic_program::OP_ADD:
+    case basic_program::OP_SUB:
+    case basic_program::OP_MUL:
+    case basic_program::OP_MOD:
+    case basic_program::OP_EQ:
+    case basic_program::OP_NE:
+    case basic_program::OP_LT:
+    case basic_program::OP_GT:
+    case basic_program::OP_LE:
+    case basic_program::OP_GE:
+    case basic_program::OP_AND:
+    case basic_program::OP_OR:
+    case basic_program::OP_XOR:
+      sp[-2] = basic_operator(in->op, sp[-2], sp[-1]);
+      sp--;
+      break;
+
+    case basic_program::OP_NEG:
+    case basic_program::OP_NOT:
+    case basic_program::OP_SQR:
+    case basic_program::OP_SQRT:
+    case basic_program::OP_SIN:
+    case basic_program::OP_COS:
+    case basic_program::OP_TAN:
+    case basic_program::OP_ARCTAN:
+    case basic_program::OP_LOG:
+    case basic_program::OP_LOG10:
+    case basic_program::OP_EXP:
+    case basic_program::OP_ABS:
+    case basic_program::OP_SGN:
+      sp[-1] = basic_operator(in->op, sp[-1], 0);
+      break;
+
+    case basic_program::OP_M:
+      *sp++ = PhreeqcPtr->rate_m;
+      break;
+
+    case basic_program::OP_M0:
+      *sp++ = PhreeqcPtr->rate_m0;
+      break;
+
+    case basic_program::OP_TIME:
+      *sp++ = PhreeqcPtr->rate_time;
+      break;
+
+    case basic_program::OP_TK:
+      *sp++ = PhreeqcPtr->tc_x + 273.15;
+      break;
+
+    case basic_program::OP_TC:
+      *sp++ = PhreeqcPtr->tc_x;
+      break;
+
+    case basic_program::OP_PARM:
+      i_rate = (int)(long)floor(sp[-1] + 0.5);
+      if (i_rate > PhreeqcPtr->count_rate_p || i_rate == 0) {
+        errormsg("Parameter subscript out of range.");
+      }
+      sp[-1] = PhreeqcPtr->rate_p[(size_t)i_rate - 1];
+      break;
+
+    case basic_program::OP_ACT:
+      *sp++ = PhreeqcPtr->activity(in->s);
+      break;
+
+    case basic_program::OP_LA:
+      *sp++ = PhreeqcPtr->log_activity(in->s);
+      break;
+
+    case basic_program::OP_LM:
+      *sp++ = PhreeqcPtr->log_molality(in->s);
+      break;
+
+    case basic_program::OP_MOL:
+      *sp++ = PhreeqcPtr->molality(in->s);
+      break;
+
+    case basic_program::OP_SR:
+      if (in->phase != NULL) {
+        *sp++ = PhreeqcPtr->saturation_ratio(in->phase);
+      } else {
+        *sp++ = PhreeqcPtr->saturation_ratio(in->name);
+      }
+      break;
+
+    case basic_program::OP_SI:
+      if (in->phase != NULL) {
+        PhreeqcPtr->saturation_index(in->phase, &l_dummy, sp);
+      } else {
+        PhreeqcPtr->saturation_index(in->name, &l_dummy, sp);
+      }
+      sp++;
+      break;
+
+    case basic_program::OP_TOT:
+      if (in->master != NULL) {
+        *sp++ = PhreeqcPtr->total(in->master);
+      } else {
+        *sp++ = PhreeqcPtr->total(in->name);
+      }
+      break;
+    }
+  }
+}
+
+/* one statement of a compiled program, as exec runs it */
+void PBasic::exec_statement(tokenrec *tok) {
+  struct LOC_exec V;
+
+  V.gotoflag = false;
+  V.elseflag = false;
+  stmttok = tok;
+  V.t = tok->next;
+  switch (tok->kind) {
+
+  case toksave:
+    cmdsave(&V);
+    break;
+
+  case toklet:
+    cmdlet(false, &V);
+    break;
+
+  case tokvar:
+    cmdlet(true, &V);
+    break;
+
+  case tokprint:
+    cmdprint(&V);
+    break;
+
+  case tokpunch:
+    cmdpunch(&V);
+    break;
+
+  case tokput:
+    cmdput(&V);
+    break;
+
+  case tokput_:
+    cmdput_(&V);
+    break;
+
+  case tokchange_por:
+    cmdchange_por(&V);
+    break;
+
+  case tokchange_surf:
+    cmdchange_surf(&V);
+    break;
+
+  case tokread:
+    cmdread(&V);
+    break;
+
+  case tokrestore:
+    cmdrestore(&V);
+    break;
+
+  case tokpoke:
+    cmdpoke(&V);
+    break;
+  }
+  if (!V.elseflag && !iseos(&V))
+    checkextra(&V);
+}
+
 #if defined MULTICHART
 void PBasic::cmdplot_xy(struct LOC_exec *LINK) {
   bool semiflag;
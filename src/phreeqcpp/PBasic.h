@@ -4,6 +4,8 @@
 #include <windows.h>
 #endif
 #include <map>
+#include <set>
+#include <vector>
 #include <stdio.h>
 #include <limits.h>
 #include <ctype.h>
@@ -131,6 +133,75 @@ struct LOC_exec
 	tokenrec *t;
 };
 
+/*  program compiled from the lines of a rate, see PBasic::basic_run_program */
+class basic_program
+{
+public:
+	enum OPCODE
+	{
+		OP_LINE,	/* start of line */
+		OP_END,
+		OP_JUMP,
+		OP_JUMPZ,	/* jump if top of stack is zero */
+		OP_STMT,	/* one statement run by the interpreter */
+		OP_LET,
+		OP_SAVE,
+		OP_NUM,
+		OP_VAR,
+		OP_FACTOR,	/* one factor evaluated by the interpreter */
+		OP_EXPR,	/* condition of IF evaluated by the interpreter */
+		OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_POW,
+		OP_EQ, OP_LT, OP_GT, OP_LE, OP_GE, OP_NE,	/* in the order of tokeq..tokne */
+		OP_AND, OP_OR, OP_XOR,
+		OP_NEG, OP_NOT, OP_SQR, OP_SQRT, OP_SIN, OP_COS, OP_TAN, OP_ARCTAN,
+		OP_LOG, OP_LOG10, OP_EXP, OP_ABS, OP_SGN,
+		OP_M, OP_M0, OP_TIME, OP_TK, OP_TC, OP_PARM,
+		OP_ACT, OP_LA, OP_LM, OP_MOL, OP_SR, OP_SI, OP_TOT
+	};
+	static const size_t max_depth = 64;
+	static const size_t max_code = 65536;
+	class instr
+	{
+	public:
+		instr()
+		{
+			op = OP_END;
+			num = 0;
+			target = 0;
+			vp = NULL;
+			tok = end = NULL;
+			line = NULL;
+			name = NULL;
+			s = NULL;
+			phase = NULL;
+			master = NULL;
+		}
+		int op;
+		LDBLE num;
+		size_t target;
+		varrec *vp;
+		tokenrec *tok, *end;
+		linerec *line;
+		const char *name;
+		class species *s;	/* name bound by PBasic::bind_program */
+		class phase *phase;
+		class master *master;
+	};
+	std::vector<instr> code;
+	bool interpret;		/* program is run by the interpreter */
+	size_t serial;		/* Phreeqc::definitions_serial of the bound names */
+};
+
+/*  variables for the compiler of basic_program: */
+struct LOC_compile
+{
+	basic_program *program;
+	linerec *line;
+	size_t depth, max_depth;
+	std::set<varrec *> arrays;
+	std::vector<std::pair<size_t, linerec *> > jumps;
+};
+
 class PBasic: public PHRQ_base
 {
 public:
@@ -492,6 +563,30 @@ public:
 	int basic_compile(const char *commands, void **lnbase, void **vbase, void **lpbase);
 	int basic_run(char *commands, void *lnbase, void *vbase, void *lpbase);
 	int basic_init(void);
+	int basic_run_program(void **program, void *lnbase, void *vbase, void *lpbase);
+	static void basic_free_program(void **program);
+	static bool basic_program_compiled(const void *program);
+	basic_program *compile_program(linerec *lines);
+	bool compile_sequence(tokenrec *t, bool tail, struct LOC_compile *LINK);
+	bool compile_if(tokenrec *t, bool tail, struct LOC_compile *LINK);
+	bool compile_goto(tokenrec *t, struct LOC_compile *LINK);
+	bool compile_let(tokenrec **t, struct LOC_compile *LINK);
+	bool compile_save(tokenrec **t, struct LOC_compile *LINK);
+	bool compile_factor(tokenrec **t, struct LOC_compile *LINK);
+	bool compile_fallback(tokenrec *f, tokenrec **t, struct LOC_compile *LINK);
+	bool compile_upexpr(tokenrec **t, struct LOC_compile *LINK);
+	bool compile_term(tokenrec **t, struct LOC_compile *LINK);
+	bool compile_sexpr(tokenrec **t, struct LOC_compile *LINK);
+	bool compile_relexpr(tokenrec **t, struct LOC_compile *LINK);
+	bool compile_andexpr(tokenrec **t, struct LOC_compile *LINK);
+	bool compile_expr(tokenrec **t, struct LOC_compile *LINK);
+	size_t emit(int op, struct LOC_compile *LINK);
+	void emit_operator(int op, struct LOC_compile *LINK);
+	void compile_truncate(size_t mark, size_t depth, struct LOC_compile *LINK);
+	void bind_program(basic_program *program);
+	void run_program(const basic_program *program);
+	void exec_statement(tokenrec *tok);
+	void exec_error(void);
 	int sget_logical_line(const char **ptr, int *l, char *return_line);
 	long my_labs(long x);
 	void * my_memmove(void * d, Const void * s, size_t n);
@@ -462,10 +462,17 @@ Phreeqc::Phreeqc(PHRQ_io *io)
 void Phreeqc::init(void)
 {
 	same_model                      = FALSE;
+	count_same_model                = 0;
 	current_tc                      = NAN;
 	current_pa                      = NAN;
 	current_mu                      = NAN;
+	current_ah2o                    = NAN;
 	mu_terms_in_logk                = true;
+	logk_tp_cache                   = std::make_shared<class logk_cache>();
+	logk_tp_tc                      = NAN;
+	logk_tp_pa                      = NAN;
+	logk_model                      = -1;
+	logk_model_stale                = true;
 	current_A                       = 0.0;
 	current_x                       = 0.0;
 	fix_current                     = 0.0;
@@ -560,6 +567,8 @@ void Phreeqc::init(void)
 	/*----------------------------------------------------------------------
 	*   Jacobian and Mass balance lists
 	*---------------------------------------------------------------------- */
+	sum_jacob_stale = true;
+	species_kernel_stale = true;
 
 	/*----------------------------------------------------------------------
 	*   Solution
@@ -786,6 +795,7 @@ void Phreeqc::init(void)
 	initial_total_time		= 0;
 	// auto rate_p
 	count_rate_p            = 0;
+	definitions_serial      = 1;
 	/* ----------------------------------------------------------------------
 	*   USER PRINT COMMANDS
 	* ---------------------------------------------------------------------- */
@@ -870,6 +880,12 @@ void Phreeqc::init(void)
 	negative_concentrations = FALSE;
 	calculating_deriv		= FALSE;
 	numerical_deriv			= FALSE;
+	cl1_compensated_sum		= FALSE;
+	dense_linear_solver		= FALSE;
+	vectorized_gammas		= TRUE;
+	compiled_rates			= TRUE;
+	cvode_jacobian_threads	= 1;
+	cvode_jacobian_reuse	= 0.0;
 	count_total_steps       = 0;
 	phast                   = FALSE;
 	output_newline          = true;
@@ -907,6 +923,9 @@ void Phreeqc::init(void)
 	DH_Av                   = 0.0;
 	QBrn                    = 0.0;
 	ZBrn                    = 0.0;
+	rho_0_tc                = NAN;
+	dielectrics_tc          = NAN;
+	dielectrics_pa          = NAN;
 	dgdP                    = 0.0;
 
 	need_temp_msg           = 0;
@@ -1023,12 +1042,25 @@ void Phreeqc::init(void)
 	kinetics_y              = NULL;
 	kinetics_abstol         = NULL;
 	kinetics_cvode_mem      = NULL;
+	cvode_workspace_n       = 0;
+	cvode_workspace_maxord  = 0;
 	cvode_pp_assemblage_save= NULL;
 	cvode_ss_assemblage_save= NULL;
+	cvode_jacobian_workers_serial = 0;
+	cvode_jacobian_threads_pool = NULL;
+	cvode_jacobian_synced   = 0;
+	cvode_jacobian_reused   = false;
+	cvode_jacobian_evaluations = 0;
+	cvode_jacobian_reuses   = 0;
+	rk_equilibrations       = 0;
 	set_and_run_attempt     = 0;
 	/* model.cpp ------------------------------- */
 	gas_in                  = FALSE;
 	min_value               = 1e-10;
+	ineq_space_unknowns     = 0;
+	count_ineq_dense        = 0;
+	count_ineq_cl1          = 0;
+	count_analytic_columns  = 0;
 
 	/* phrq_io_output.cpp ------------------------------- */
 	forward_output_to_log   = 0;
@@ -1170,10 +1202,16 @@ Phreeqc::InternalCopy(const Phreeqc* pSrc)
 	// phrq_io
 	//this->phrq_io = new PHRQ_io;
 	same_model = FALSE;
+	count_same_model = 0;
 	current_tc = pSrc->current_tc;
 	current_pa = pSrc->current_pa;
 	current_mu = pSrc->current_mu;
+	current_ah2o = pSrc->current_ah2o;
 	mu_terms_in_logk = pSrc->mu_terms_in_logk;
+	// the log k cache is keyed on the model, copies share it
+	logk_tp_cache = pSrc->logk_tp_cache;
+	logk_tp_x.reset();
+	logk_model_stale = true;
 
 	/* ----------------------------------------------------------------------
 	*   STRUCTURES
@@ -1609,6 +1647,12 @@ Phreeqc::InternalCopy(const Phreeqc* pSrc)
 	negative_concentrations = pSrc->negative_concentrations;
 	calculating_deriv = pSrc->calculating_deriv;
 	numerical_deriv = pSrc->numerical_deriv;
+	cl1_compensated_sum = pSrc->cl1_compensated_sum;
+	dense_linear_solver = pSrc->dense_linear_solver;
+	vectorized_gammas = pSrc->vectorized_gammas;
+	compiled_rates = pSrc->compiled_rates;
+	cvode_jacobian_threads = pSrc->cvode_jacobian_threads;
+	cvode_jacobian_reuse = pSrc->cvode_jacobian_reuse;
 	count_total_steps = 0;
 	phast = FALSE;
 	output_newline = true;
@@ -1742,6 +1786,9 @@ Phreeqc::InternalCopy(const Phreeqc* pSrc)
 	DH_Av = pSrc->DH_Av;
 	QBrn = pSrc->QBrn;
 	ZBrn = pSrc->ZBrn;
+	rho_0_tc = NAN;
+	dielectrics_tc = NAN;
+	dielectrics_pa = NAN;
 	dgdP = pSrc->dgdP;
 	//
 	need_temp_msg = pSrc->need_temp_msg;
@@ -1842,15 +1889,28 @@ Phreeqc::InternalCopy(const Phreeqc* pSrc)
 	kinetics_y = NULL;
 	kinetics_abstol = NULL;
 	kinetics_cvode_mem = NULL;
+	cvode_workspace_n = 0;
+	cvode_workspace_maxord = 0;
 	cvode_pp_assemblage_save = NULL;
 	cvode_ss_assemblage_save = NULL;
+	cvode_jacobian_workers_serial = 0;
+	cvode_jacobian_threads_pool = NULL;
+	cvode_jacobian_synced = 0;
+	cvode_jacobian_reused = false;
+	cvode_jacobian_evaluations = 0;
+	cvode_jacobian_reuses = 0;
 	//std::vector<double> m_temp, m_original, rk_moles, x0_moles;
+	rk_equilibrations = 0;
 	set_and_run_attempt = 0;
 	/* model.cpp ------------------------------- */
 	gas_in = FALSE;
 	min_value = 1e-10;
 	//std::vector<double> normal, ineq_array, res, cu, zero, delta1;
 	//std::vector<int> iu, is, back_eq;									 
+	ineq_space_unknowns = 0;
+	count_ineq_dense = 0;
+	count_ineq_cl1 = 0;
+	count_analytic_columns = 0;
 	/* phrq_io_output.cpp ------------------------------- */
 	forward_output_to_log = pSrc->forward_output_to_log;
 	/* phreeqc_files.cpp ------------------------------- */
@@ -1947,12 +2007,18 @@ Phreeqc::InternalCopy(const Phreeqc* pSrc)
 	sit_IPRSNT = pSrc->sit_IPRSNT;
 	sit_M = pSrc->sit_M;
 	sit_LGAMMA = pSrc->sit_LGAMMA;
+	sit_epsilons = pSrc->sit_epsilons;
 	s_list = pSrc->s_list;
 	cation_list = pSrc->cation_list;
 	neutral_list = pSrc->neutral_list;
 	anion_list = pSrc->anion_list;
 	ion_list = pSrc->ion_list;
 	param_list = pSrc->param_list;
+	pitz_terms = pSrc->pitz_terms;
+	pitz_alphas = pSrc->pitz_alphas;
+	pitz_alpha_g = pSrc->pitz_alpha_g;
+	pitz_alpha_gp = pSrc->pitz_alpha_gp;
+	pitz_alpha_exp = pSrc->pitz_alpha_exp;
 
 	/* tidy.cpp ------------------------------- */
 	//a0                      = 0;
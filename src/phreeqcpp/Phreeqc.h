@@ -43,7 +43,9 @@ typedef unsigned char boolean;
 #include "ChartHandler.h"
 #endif
 #include "Keywords.h"
+#include "PPassemblage.h"
 #include "Pressure.h"
+#include "SSassemblage.h"
 #include "Surface.h"
 #include "Use.h"
 #include "cxxMix.h"
@@ -91,6 +93,9 @@ public:
   int basic_compile(const char *commands, void **lnbase, void **vbase,
                     void **lpbase);
   int basic_run(char *commands, void *lnbase, void *vbase, void *lpbase);
+  int basic_run_program(void **program, void *lnbase, void *vbase,
+                        void *lpbase);
+  void basic_free_program(void **program);
   void basic_free(void);
 #ifdef IPHREEQC_NO_FORTRAN_MODULE
   double basic_callback(double x1, double x2, const char *str);
@@ -110,6 +115,7 @@ public:
 #endif
 
   LDBLE activity(const char *species_name);
+  LDBLE activity(class species *s_ptr);
   LDBLE activity_coefficient(const char *species_name);
   LDBLE log_activity_coefficient(const char *species_name);
   LDBLE aqueous_vm(const char *species_name);
@@ -151,13 +157,18 @@ public:
   LDBLE kinetics_moles(const char *kinetics_name);
   LDBLE kinetics_moles_delta(const char *kinetics_name);
   LDBLE log_activity(const char *species_name);
+  LDBLE log_activity(class species *s_ptr);
   LDBLE log_molality(const char *species_name);
+  LDBLE log_molality(class species *s_ptr);
   LDBLE molality(const char *species_name);
+  LDBLE molality(class species *s_ptr);
   LDBLE pressure(void);
   LDBLE pr_pressure(const char *phase_name);
   LDBLE pr_phi(const char *phase_name);
   LDBLE saturation_ratio(const char *phase_name);
+  LDBLE saturation_ratio(class phase *phase_ptr);
   int saturation_index(const char *phase_name, LDBLE *iap, LDBLE *si);
+  int saturation_index(class phase *phase_ptr, LDBLE *iap, LDBLE *si);
   int solution_number(void);
   LDBLE solution_sum_secondary(const char *total_name);
   LDBLE sum_match_gases(const char *stemplate, const char *name);
@@ -196,6 +207,7 @@ public:
   int system_total_elt(const char *total_name);
   int system_total_elt_secondary(const char *total_name);
   LDBLE total(const char *total_name);
+  LDBLE total(class master *master_ptr);
   LDBLE total_mole(const char *total_name);
   int system_total_solids(cxxExchange *exchange_ptr,
                           cxxPPassemblage *pp_assemblage_ptr,
@@ -404,6 +416,18 @@ public:
                           LDBLE step_fraction);
   int set_advection(int i, int use_mix, int use_kinetics, int nsaver);
   int free_cvode(void);
+  int cvode_workspace(int n_reactions);
+  int cvode_start(realtype *reltol, long int *iopt, realtype *ropt);
+  void cvode_save_assemblages(const cxxPPassemblage *pp_assemblage_ptr,
+                              const cxxSSassemblage *ss_assemblage_ptr);
+  int cvode_jacobian_column(N_Vector y, size_t i, bool decoupled,
+                            const std::vector<double> &initial_rates,
+                            std::vector<double> &column);
+  bool cvode_jacobian_columns(DenseMat J, N_Vector y,
+                              const std::vector<double> &initial_rates);
+  bool cvode_jacobian_decoupled(cxxKinetics *kinetics_ptr, size_t i);
+  void cvode_jacobian_sync(Phreeqc *worker, bool reactants);
+  void cvode_jacobian_free(void);
 
 public:
   static void f(integertype N, realtype t, N_Vector y, N_Vector ydot,
@@ -418,6 +442,22 @@ public:
   bool limit_rates(cxxKinetics *kinetics_ptr);
   int rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
                   LDBLE step_fraction);
+  int rk_embedded_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
+                           LDBLE step_fraction);
+  int rk_stage(int i, cxxKinetics *kinetics_ptr,
+               const std::vector<LDBLE> &moles, LDBLE h, LDBLE t,
+               const cxxPPassemblage *pp_assemblage_save,
+               const cxxSSassemblage *ss_assemblage_save,
+               std::vector<LDBLE> &k);
+  cxxKinetics *rk_begin(int i, int use_mix, int nsaver, LDBLE step_fraction,
+                        int &save_old);
+  void rk_finish(int i, LDBLE kin_time, int use_mix, int nsaver, int save_old);
+  void rk_set_pointers(int i);
+  void rk_check_bad_steps(const cxxKinetics *kinetics_ptr, int step_bad);
+  void rk_restore_assemblages(const cxxPPassemblage *pp_assemblage_save,
+                              const cxxSSassemblage *ss_assemblage_save);
+  int rk_equilibrate(int i);
+  void rk_warm_start(int n_user);
   int set_reaction(int i, int use_mix, int use_kinetics);
   int set_transport(int i, int use_mix, int use_kinetics, int nsaver);
   int store_get_equi_reactants(int k, int kin_end);
@@ -456,8 +496,12 @@ public:
   int check_residuals(void);
   int free_model_allocs(void);
   int ineq(int kode);
+  int ineq_dense(int rows, int n, int n2d);
+  void ineq_space(void);
   int model(void);
   int jacobian_sums(void);
+  int compile_jacobian_sums(void);
+  int compile_species_kernel(void);
   int mb_gases(void);
   int mb_ss(void);
   int mb_sums(void);
@@ -473,6 +517,7 @@ public:
   LDBLE ss_f(LDBLE xb, LDBLE a0, LDBLE a1, LDBLE kc, LDBLE kb, LDBLE xcaq,
              LDBLE xbaq);
   int numerical_jacobian(void);
+  int jacobian_cd_music_ddl(const std::vector<bool> &perturb);
   void set_inert_moles(void);
   void unset_inert_moles(void);
 #ifdef SLNQ
@@ -565,7 +610,7 @@ public:
   LDBLE calc_PR(std::vector<class phase *> phase_ptrs, LDBLE P, LDBLE TK,
                 LDBLE V_m);
   LDBLE calc_PR();
-  int calc_vm(LDBLE tc, LDBLE pa);
+  int calc_vm(LDBLE tc, const class logk_tp &tp);
   LDBLE calc_vm0(const char *species_name, LDBLE tc, LDBLE pa, LDBLE mu);
   int clear(void);
   int convert_units(cxxSolution *solution_ptr);
@@ -580,6 +625,8 @@ public:
   int quick_setup(void);
   int resetup_master(void);
   int save_model(void);
+  void save_model_signature(void);
+  bool check_model_signature(void);
   int setup_exchange(void);
   int setup_gas_phase(void);
   int setup_fixed_volume_gas(void);
@@ -609,6 +656,10 @@ public:
   int check_same_model(void);
   int k_temp(LDBLE tc, LDBLE pa);
   LDBLE k_calc(LDBLE *logk, LDBLE tempk, LDBLE presPa);
+  LDBLE k_calc_tempk(LDBLE *logk, LDBLE tempk);
+  LDBLE k_calc_pressure(LDBLE lk, LDBLE l_delta_v, LDBLE tempk, LDBLE presPa);
+  int logk_cache_model(void);
+  const class logk_tp *logk_tp_find(LDBLE tc, LDBLE pa);
   int prep(void);
   int reprep(void);
   int rewrite_master_to_secondary(class master *master_ptr1,
@@ -1134,6 +1185,28 @@ public:
   std::map<int, cxxPressure> &Get_Rxn_pressure_map() {
     return this->Rxn_pressure_map;
   }
+  size_t Get_count_ineq_dense(void) const { return this->count_ineq_dense; }
+  size_t Get_count_ineq_cl1(void) const { return this->count_ineq_cl1; }
+  size_t Get_count_analytic_columns(void) const {
+    return this->count_analytic_columns;
+  }
+  size_t Get_count_same_model(void) const { return this->count_same_model; }
+  size_t Get_logk_cache_hits(void) const { return this->logk_tp_cache->hits; }
+  size_t Get_logk_cache_misses(void) const {
+    return this->logk_tp_cache->misses;
+  }
+  size_t Get_logk_cache_entries(void) const {
+    std::shared_lock<std::shared_mutex> guard(this->logk_tp_cache->mutex);
+    return this->logk_tp_cache->entries.size();
+  }
+  size_t Get_rates_compiled(void) const;
+  size_t Get_cvode_jacobian_evaluations(void) const {
+    return this->cvode_jacobian_evaluations;
+  }
+  size_t Get_cvode_jacobian_reuses(void) const {
+    return this->cvode_jacobian_reuses;
+  }
+  size_t Get_rk_equilibrations(void) const { return this->rk_equilibrations; }
 
 protected:
   void init(void);
@@ -1145,10 +1218,21 @@ protected:
   PHRQ_io *phrq_io;
   PHRQ_io ioInstance;
   int same_model;
+  size_t count_same_model; /* prep() calls reusing the last model */
 
   LDBLE current_tc;
   LDBLE current_pa;
   LDBLE current_mu;
+  LDBLE current_ah2o;
+  std::shared_ptr<class logk_cache> logk_tp_cache; /* shared with copies of
+                                                       this instance */
+  std::shared_ptr<const class logk_tp> logk_tp_x;  /* entry of tc_x, pa_x */
+  LDBLE logk_tp_tc, logk_tp_pa;                    /* key of logk_tp_x */
+  int logk_model;                                  /* id of the model in
+                                                      logk_tp_cache, -1 if
+                                                      not cached */
+  bool logk_model_stale;                           /* model needs to be
+                                                      looked up again */
   bool mu_terms_in_logk;
 
   /* ----------------------------------------------------------------------
@@ -1312,6 +1396,15 @@ protected:
   std::vector<class list2> sum_delta;  /* array of pointers to sources, targets
                                           and coefficients for  summing deltas for
                                           mass balance equations */
+  class jacob_program sum_jacob;       /* sum_jacob0, sum_jacob1 and sum_jacob2
+                                          sorted by target */
+  bool sum_jacob_stale;                /* sum_jacob needs to be compiled again */
+  class species_program s_x_kernel;    /* s_x and mass-action terms for
+                                          molalities */
+  class mb_program sum_mb;             /* sum_mb1 and sum_mb2 sorted by target */
+  class gammas_program gammas_groups;  /* s_x grouped by activity model */
+  bool species_kernel_stale;           /* s_x_kernel and sum_mb need to be
+                                          compiled again */
   /*----------------------------------------------------------------------
    *   Solution
    *---------------------------------------------------------------------- */
@@ -1522,6 +1615,9 @@ protected:
       rate_sim_time_end, rate_sim_time, rate_moles, initial_total_time;
   std::vector<LDBLE> rate_p;
   int count_rate_p;
+  /* incremented when species, phases or master species are (re)defined,
+     names bound in compiled rates are resolved again */
+  size_t definitions_serial;
 
   /* ----------------------------------------------------------------------
    *   USER PRINT COMMANDS
@@ -1614,6 +1710,12 @@ protected:
   int negative_concentrations;
   int calculating_deriv;
   int numerical_deriv;
+  int cl1_compensated_sum;
+  int dense_linear_solver;
+  int vectorized_gammas;
+  int compiled_rates;
+  int cvode_jacobian_threads;
+  LDBLE cvode_jacobian_reuse;
 
   int count_total_steps;
   int phast;
@@ -1703,6 +1805,9 @@ protected:
               // molal volume
   LDBLE dgdP; // dg / dP, pressure derivative of g-function, for supcrt calc'n
               // of molal volume
+  /* terms of calc_rho_0 and calc_dielectrics at the last tc and pa */
+  LDBLE rho_0_tc, rho_0_sat_tc, rho_0_p[4];
+  LDBLE dielectrics_tc, dielectrics_pa, dielectrics_eps_r, dielectrics_c_b;
 
   int need_temp_msg;
   LDBLE solution_mass, solution_volume;
@@ -1787,11 +1892,26 @@ public:
   M_Env kinetics_machEnv;
   N_Vector kinetics_y, kinetics_abstol;
   void *kinetics_cvode_mem;
+  int cvode_workspace_n;           /* number of reactions of the vectors */
+  long int cvode_workspace_maxord; /* iopt[MAXORD] of kinetics_cvode_mem */
   cxxSSassemblage *cvode_ss_assemblage_save;
   cxxPPassemblage *cvode_pp_assemblage_save;
+  cxxSSassemblage cvode_ss_assemblage_snapshot;
+  cxxPPassemblage cvode_pp_assemblage_snapshot;
+  std::vector<Phreeqc *> cvode_jacobian_workers; /* clones calculating columns */
+  size_t cvode_jacobian_workers_serial; /* definitions_serial of the clones */
+  class cvode_jacobian_pool *cvode_jacobian_threads_pool; /* runs clones */
+  size_t cvode_jacobian_synced; /* clones with the reactants of the cell */
+  std::vector<double> cvode_jacobian_saved; /* last Jacobian, column major */
+  std::vector<double> cvode_jacobian_saved_rates; /* rates it was taken at */
+  std::vector<std::string> cvode_jacobian_saved_names;
+  bool cvode_jacobian_reused; /* saved Jacobian given in this integration */
+  size_t cvode_jacobian_evaluations;
+  size_t cvode_jacobian_reuses;
 
 protected:
   std::vector<double> m_temp, m_original, rk_moles, x0_moles;
+  size_t rk_equilibrations; /* stages of the Runge-Kutta methods */
   int set_and_run_attempt;
 
   /* model.cpp ------------------------------- */
@@ -1799,6 +1919,15 @@ protected:
   LDBLE min_value;
   std::vector<double> normal, ineq_array, res, cu, zero, delta1;
   std::vector<int> iu, is, back_eq;
+  size_t ineq_space_unknowns;          /* count_unknowns the ineq arrays were sized for */
+  std::vector<double> dense_lu;        /* column major matrix for ineq_dense */
+  std::vector<double *> dense_lu_columns;
+  std::vector<double> dense_column_norms; /* max |coefficient| per column */
+  std::vector<long int> dense_pivots;
+  std::vector<int> dense_rows, dense_columns;
+  size_t count_ineq_dense;             /* Newton steps solved by ineq_dense */
+  size_t count_ineq_cl1;               /* Newton steps solved by cl1 */
+  size_t count_analytic_columns;       /* numerical_jacobian columns not perturbed */
 
   /* phrq_io_output.cpp ------------------------------- */
   int forward_output_to_log;
@@ -1855,8 +1984,12 @@ protected:
   int sit_MAXCATIONS, sit_FIRSTANION, sit_MAXNEUTRAL;
   std::vector<int> sit_IPRSNT;
   std::vector<double> sit_M, sit_LGAMMA;
+  class sit_epsilon_matrix sit_epsilons;
   std::vector<int> s_list, cation_list, neutral_list, anion_list, ion_list,
       param_list;
+  std::vector<class pitz_term> pitz_terms; /* param_list compiled */
+  std::vector<LDBLE> pitz_alphas;          /* distinct alphas of B1 and B2 */
+  std::vector<LDBLE> pitz_alpha_g, pitz_alpha_gp, pitz_alpha_exp;
 
   /* tidy.cpp ------------------------------- */
   LDBLE a0, a1, kc, kb;
@@ -1915,6 +2048,8 @@ public:
   std::vector<std::string>
   find_all_valence_states(const std::vector<std::string> &solution_names);
 
+  int run_cell_step(int cell, LDBLE time_step);
+
   static const class const_iso iso_defaults[];
   static const int count_iso_defaults;
 };
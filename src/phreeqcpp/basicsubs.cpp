@@ -35,10 +35,15 @@ static char THIS_FILE[] = __FILE__;
 LDBLE Phreeqc::activity(const char *species_name)
 /* ---------------------------------------------------------------------- */
 {
-  class species *s_ptr;
+  return (activity(s_search(species_name)));
+}
+
+/* ---------------------------------------------------------------------- */
+LDBLE Phreeqc::activity(class species *s_ptr)
+/* ---------------------------------------------------------------------- */
+{
   LDBLE a;
 
-  s_ptr = s_search(species_name);
   if (s_ptr == s_h2o) {
     a = pow((LDBLE)10., s_h2o->la);
   } else if (s_ptr == s_eminus) {
@@ -1511,10 +1516,14 @@ LDBLE Phreeqc::kinetics_moles_delta(const char *kinetics_name)
 LDBLE Phreeqc::log_activity(const char *species_name)
 /* ---------------------------------------------------------------------- */
 {
-  class species *s_ptr;
-  LDBLE la;
+  return (log_activity(s_search(species_name)));
+}
 
-  s_ptr = s_search(species_name);
+/* ---------------------------------------------------------------------- */
+LDBLE Phreeqc::log_activity(class species *s_ptr)
+/* ---------------------------------------------------------------------- */
+{
+  LDBLE la;
 
   if (s_ptr == s_eminus) {
     la = s_eminus->la;
@@ -1532,10 +1541,14 @@ LDBLE Phreeqc::log_activity(const char *species_name)
 LDBLE Phreeqc::log_molality(const char *species_name)
 /* ---------------------------------------------------------------------- */
 {
-  class species *s_ptr;
-  LDBLE lm;
+  return (log_molality(s_search(species_name)));
+}
 
-  s_ptr = s_search(species_name);
+/* ---------------------------------------------------------------------- */
+LDBLE Phreeqc::log_molality(class species *s_ptr)
+/* ---------------------------------------------------------------------- */
+{
+  LDBLE lm;
 
   if (s_ptr == s_eminus) {
     lm = -99.99;
@@ -1553,10 +1566,15 @@ LDBLE Phreeqc::log_molality(const char *species_name)
 LDBLE Phreeqc::molality(const char *species_name)
 /* ---------------------------------------------------------------------- */
 {
-  class species *s_ptr;
+  return (molality(s_search(species_name)));
+}
+
+/* ---------------------------------------------------------------------- */
+LDBLE Phreeqc::molality(class species *s_ptr)
+/* ---------------------------------------------------------------------- */
+{
   LDBLE m;
 
-  s_ptr = s_search(species_name);
   if (s_ptr == NULL || s_ptr == s_eminus || s_ptr->in == FALSE) {
     m = 1e-99;
   } else {
@@ -1637,18 +1655,27 @@ LDBLE Phreeqc::pr_phi(const char *phase_name)
 LDBLE Phreeqc::saturation_ratio(const char *phase_name)
 /* ---------------------------------------------------------------------- */
 {
-  class rxn_token *rxn_ptr;
   class phase *phase_ptr;
   int l;
-  LDBLE si, iap;
 
-  iap = 0.0;
   phase_ptr = phase_bsearch(phase_name, &l, FALSE);
   if (phase_ptr == NULL) {
     error_string = sformatf("Mineral %s, not found.", phase_name);
     warning_msg(error_string);
     return (1e-99);
-  } else if (phase_ptr->in != FALSE) {
+  }
+  return (saturation_ratio(phase_ptr));
+}
+
+/* ---------------------------------------------------------------------- */
+LDBLE Phreeqc::saturation_ratio(class phase *phase_ptr)
+/* ---------------------------------------------------------------------- */
+{
+  class rxn_token *rxn_ptr;
+  LDBLE si, iap;
+
+  iap = 0.0;
+  if (phase_ptr->in != FALSE) {
     for (rxn_ptr = &phase_ptr->rxn_x.token[0] + 1; rxn_ptr->s != NULL;
          rxn_ptr++) {
       iap += rxn_ptr->s->la * rxn_ptr->coef;
@@ -1663,18 +1690,29 @@ LDBLE Phreeqc::saturation_ratio(const char *phase_name)
 int Phreeqc::saturation_index(const char *phase_name, LDBLE *iap, LDBLE *si)
 /* ---------------------------------------------------------------------- */
 {
-  class rxn_token *rxn_ptr;
   class phase *phase_ptr;
   int l;
 
-  *si = -99.99;
-  *iap = 0.0;
   phase_ptr = phase_bsearch(phase_name, &l, FALSE);
   if (phase_ptr == NULL) {
     error_string = sformatf("Mineral %s, not found.", phase_name);
     warning_msg(error_string);
     *si = -99;
-  } else if (phase_ptr->in != FALSE) {
+    *iap = 0.0;
+    return (OK);
+  }
+  return (saturation_index(phase_ptr, iap, si));
+}
+
+/* ---------------------------------------------------------------------- */
+int Phreeqc::saturation_index(class phase *phase_ptr, LDBLE *iap, LDBLE *si)
+/* ---------------------------------------------------------------------- */
+{
+  class rxn_token *rxn_ptr;
+
+  *si = -99.99;
+  *iap = 0.0;
+  if (phase_ptr->in != FALSE) {
     for (rxn_ptr = &phase_ptr->rxn_x.token[0] + 1; rxn_ptr->s != NULL;
          rxn_ptr++) {
       *iap += rxn_ptr->s->la * rxn_ptr->coef;
@@ -2250,7 +2288,6 @@ LDBLE Phreeqc::total(const char *total_name)
 /* ---------------------------------------------------------------------- */
 {
   class master *master_ptr;
-  LDBLE t;
 
   if (strcmp(total_name, "H") == 0) {
     return (total_h_x / mass_water_aq_x);
@@ -2261,7 +2298,6 @@ LDBLE Phreeqc::total(const char *total_name)
   std::string noplus = total_name;
   replace(noplus, "(+", "(");
   master_ptr = master_bsearch(noplus.c_str());
-  t = 0.0;
   if (master_ptr == NULL) {
     if (strcmp_nocase(total_name, "water") == 0) {
       return (mass_water_aq_x);
@@ -2272,11 +2308,20 @@ LDBLE Phreeqc::total(const char *total_name)
                     sprintf (error_string, "Cannot find definition for master
        species, %s.", total_name); warning_msg (error_string);
     */
+    return (0.0);
   }
+  return (total(master_ptr));
+}
+/* ---------------------------------------------------------------------- */
+LDBLE Phreeqc::total(class master *master_ptr)
+/* ---------------------------------------------------------------------- */
+{
+  LDBLE t;
+
   /*
    *  Primary master species
    */
-  else if (master_ptr->primary == TRUE) {
+  if (master_ptr->primary == TRUE) {
     /*
      *  Not a redox element
      */
@@ -3679,6 +3724,25 @@ int Phreeqc::basic_run(char *commands, void *lnbase, void *vbase,
   return this->basic_interpreter->basic_run(commands, lnbase, vbase, lpbase);
 }
 
+int Phreeqc::basic_run_program(void **program, void *lnbase, void *vbase,
+                               void *lpbase) {
+  return this->basic_interpreter->basic_run_program(program, lnbase, vbase,
+                                                    lpbase);
+}
+
+void Phreeqc::basic_free_program(void **program) {
+  PBasic::basic_free_program(program);
+}
+
+size_t Phreeqc::Get_rates_compiled(void) const {
+  size_t count = 0;
+  for (size_t i = 0; i < rates.size(); i++) {
+    if (PBasic::basic_program_compiled(rates[i].program))
+      count++;
+  }
+  return count;
+}
+
 void Phreeqc::basic_free(void) {
   delete this->basic_interpreter;
   this->basic_interpreter = NULL;
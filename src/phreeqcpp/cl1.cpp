@@ -51,6 +51,7 @@ cl1(int k, int l, int m, int n,
 	int klm, jmn, nkl, jpn;
 	LDBLE cuv;
 	long double sum;
+	double dsum, dcomp, dterm, dnext;
 	int klm1;
 	int q_dim, cu_dim;
 	int kode_arg;
@@ -302,6 +303,33 @@ cl1(int k, int l, int m, int n,
 #endif
 	for (j = js; j < n1; ++j)
 	{
+		if (cl1_compensated_sum)
+		{
+			/* double accumulation with Neumaier compensation */
+			dsum = 0.;
+			dcomp = 0.;
+			for (i = 0; i < klm; ++i)
+			{
+				ii = q2[i * q_dim + n1].ival;
+				if (ii < 0)
+				{
+					l_z = l_cu[cu_dim - ii - 1];
+				}
+				else
+				{
+					l_z = l_cu[ii - 1];
+				}
+				dterm = q2[i * q_dim + j].dval * l_z;
+				dnext = dsum + dterm;
+				if (fabs(dsum) >= fabs(dterm))
+					dcomp += (dsum - dnext) + dterm;
+				else
+					dcomp += (dterm - dnext) + dsum;
+				dsum = dnext;
+			}
+			q2[klm * q_dim + j].dval = dsum + dcomp;
+			continue;
+		}
 	sum = 0.;
 		for (i = 0; i < klm; ++i)
 		{
@@ -697,6 +725,8 @@ cl1(int k, int l, int m, int n,
 	output_msg(sformatf( "L590\n"));
 #endif
 	sum = 0.;
+	dsum = 0.;
+	dcomp = 0.;
 	for (j = 0; j < n; ++j)
 	{
 		l_x[j] = 0.;
@@ -728,7 +758,20 @@ cl1(int k, int l, int m, int n,
 			if (ii >= n1 && ii <= nk)
 			{
 /*     *    DBLE(Q(I,N1)) */
-			  sum += (long double) q2[i * q_dim + n].dval;
+			  if (cl1_compensated_sum)
+			  {
+				  dterm = q2[i * q_dim + n].dval;
+				  dnext = dsum + dterm;
+				  if (fabs(dsum) >= fabs(dterm))
+					  dcomp += (dsum - dnext) + dterm;
+				  else
+					  dcomp += (dterm - dnext) + dsum;
+				  dsum = dnext;
+			  }
+			  else
+			  {
+				  sum += (long double) q2[i * q_dim + n].dval;
+			  }
 			}
 		}
 	}
@@ -736,7 +779,7 @@ cl1(int k, int l, int m, int n,
 #ifdef DEBUG_CL1
 	output_msg(sformatf( "L640\n"));
 #endif
-	*l_error = (double)sum;
+	*l_error = cl1_compensated_sum ? dsum + dcomp : (double)sum;
 	/*
 	 *  Check calculation
 	 */
@@ -35,6 +35,7 @@ cxxKinetics::cxxKinetics(PHRQ_io *io)
 {
 	step_divide = 1.0;
 	rk = 3;
+	rk_method = cxxKinetics::RK_CASH_KARP;
 	bad_step_max = 500;
 	use_cvode = false;
 	cvode_steps = 100;
@@ -50,6 +51,7 @@ cxxNumKeyword(io)
 	this->n_user = this->n_user_end = l_n_user;
 	step_divide = 1.0;
 	rk = 3;
+	rk_method = cxxKinetics::RK_CASH_KARP;
 	bad_step_max = 500;
 	use_cvode = false;
 	cvode_steps = 100;
@@ -103,6 +105,9 @@ cxxKinetics::dump_raw(std::ostream & s_oss, unsigned int indent, int * n_out) co
 	s_oss << indent1;
 	s_oss << "-rk                        " << this->rk << "\n";
 
+	s_oss << indent1;
+	s_oss << "-rk_method                 " << this->rk_method << "\n";
+
 	s_oss << indent1;
 	s_oss << "-bad_step_max              " << this->bad_step_max << "\n";
 
@@ -164,6 +169,7 @@ cxxKinetics::read_raw(CParser & parser, bool check)
 {
 
 	LDBLE d;
+	int i;
 
 
 	std::istream::pos_type ptr;
@@ -371,6 +377,21 @@ cxxKinetics::read_raw(CParser & parser, bool check)
 			}
 			break;
 
+		case 12:			// rk_method
+			if (!(parser.get_iss() >> i) || i < cxxKinetics::RK_CASH_KARP ||
+				i > cxxKinetics::RK_ROSENBROCK)
+			{
+				this->rk_method = cxxKinetics::RK_CASH_KARP;
+				parser.incr_input_error();
+				parser.error_msg("Expected enum for rk_method.",
+								 PHRQ_io::OT_CONTINUE);
+			}
+			else
+			{
+				this->rk_method = (cxxKinetics::RK_METHOD) i;
+			}
+			break;
+
 		}
 		if (opt == CParser::OPT_EOF || opt == CParser::OPT_KEYWORD)
 			break;
@@ -454,6 +475,7 @@ cxxKinetics::add(const cxxKinetics & addee, LDBLE extensive)
 	this->steps = addee.steps;
 	this->step_divide = addee.step_divide;
 	this->rk = addee.rk;
+	this->rk_method = addee.rk_method;
 	this->bad_step_max = addee.bad_step_max;
 	this->use_cvode = addee.use_cvode;
 	this->cvode_steps = addee.cvode_steps;
@@ -560,6 +582,7 @@ cxxKinetics::Serialize(Dictionary & dictionary, std::vector < int >&ints,
 	ints.push_back(this->equalIncrements ? 1 : 0);
 	doubles.push_back(this->step_divide);
 	ints.push_back(this->rk);
+	ints.push_back((int) this->rk_method);
 	ints.push_back(this->bad_step_max);
 	ints.push_back(this->use_cvode ? 1 : 0);
 	ints.push_back(this->cvode_steps);
@@ -593,6 +616,7 @@ cxxKinetics::Deserialize(Dictionary & dictionary, std::vector < int >&ints,
 	this->equalIncrements = (ints[ii++] != 0);
 	this->step_divide = doubles[dd++];
 	this->rk = ints[ii++];
+	this->rk_method = (cxxKinetics::RK_METHOD) ints[ii++];
 	this->bad_step_max = ints[ii++];
 	this->use_cvode = (ints[ii++] != 0);
 	this->cvode_steps = ints[ii++];
@@ -613,6 +637,7 @@ const std::vector< std::string >::value_type temp_vopts[] = {
 	std::vector< std::string >::value_type("cvode_order"),             // 8 
 	std::vector< std::string >::value_type("equalincrements"),         // 9 
 	std::vector< std::string >::value_type("count"),                   // 10
-	std::vector< std::string >::value_type("equal_increments")         // 11
+	std::vector< std::string >::value_type("equal_increments"),        // 11
+	std::vector< std::string >::value_type("rk_method")                // 12
 };
 const std::vector< std::string > cxxKinetics::vopts(temp_vopts, temp_vopts + sizeof temp_vopts / sizeof temp_vopts[0]);
@@ -16,6 +16,14 @@ class cxxKinetics:public cxxNumKeyword
 {
 
   public:
+	// integrator of rk_kinetics, KINETICS -runge_kutta
+	enum RK_METHOD
+	{
+		RK_CASH_KARP = 0,
+		RK_DORMAND_PRINCE = 1,
+		RK_ROSENBROCK = 2
+	};
+
 	cxxKinetics(PHRQ_io *io=NULL);
 	cxxKinetics(const std::map < int, cxxKinetics > &entity_map, cxxMix & mx,
 				int n_user, PHRQ_io *io=NULL);
@@ -33,6 +41,8 @@ class cxxKinetics:public cxxNumKeyword
 	void Set_step_divide(LDBLE t) {step_divide = t;}
 	int Get_rk(void) const {return rk;};
 	void Set_rk(int t) {rk = t;}
+	RK_METHOD Get_rk_method(void) const {return rk_method;}
+	void Set_rk_method(RK_METHOD t) {rk_method = t;}
 	int Get_bad_step_max(void) const {return bad_step_max;}
 	void Set_bad_step_max(int t) {bad_step_max = t;}
 	bool Get_use_cvode(void) const {return use_cvode;}
@@ -66,6 +76,7 @@ class cxxKinetics:public cxxNumKeyword
 	bool equalIncrements;
 	LDBLE step_divide;
 	int rk;
+	RK_METHOD rk_method;
 	int bad_step_max;
 	bool use_cvode;
 	int cvode_steps;
@@ -2,6 +2,16 @@
 #define _INC_GLOBAL_STRUCTURES_H
 #include "GasPhase.h"
 #include "Surface.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <tuple>
 /* ----------------------------------------------------------------------
  *   #define DEFINITIONS
  * ---------------------------------------------------------------------- */
@@ -487,6 +497,8 @@ public:
     numerical_fixed_volume = false;
     dl_type = cxxSurface::NO_DL;
     surface_type = cxxSurface::UNKNOWN_DL;
+    only_counter_ions = false;
+    solution_redox = false;
   };
   ~Model(){};
   bool force_prep;
@@ -501,6 +513,12 @@ public:
   cxxSurface::SURFACE_TYPE surface_type;
   std::vector<const char *> surface_comp;
   std::vector<const char *> surface_charge;
+  bool only_counter_ions;
+  // litephreeqc: additional parts of the model signature
+  std::vector<std::string> solution_totals;
+  bool solution_redox;
+  std::vector<std::string> exchange_comp;
+  std::vector<std::string> exchange_phase;
 };
 class name_coef {
 public:
@@ -562,6 +580,75 @@ public:
   LDBLE *target;
   LDBLE coef;
 };
+/*
+ *   sum_jacob0, sum_jacob1 and sum_jacob2 merged into one list of terms per
+ *   element of the jacobian array, built by compile_jacobian_sums
+ */
+class jacob_program {
+public:
+  ~jacob_program(){};
+  jacob_program() {}
+  std::vector<size_t> targets;        /* offsets into my_array, ascending */
+  std::vector<size_t> first;          /* terms of targets[i] are first[i] to
+                                         first[i + 1] - 1 */
+  std::vector<const LDBLE *> sources; /* factors of the terms */
+  std::vector<LDBLE> coefs;
+};
+/*
+ *   Species of s_x that get molalities, stored as parallel arrays with the
+ *   terms of the mass-action equations, built by compile_species_kernel
+ */
+class species_program {
+public:
+  ~species_program(){};
+  species_program() {}
+  std::vector<class species *> species; /* aqueous, EX and SURF species */
+  std::vector<int> types;               /* copy of species[i]->type */
+  std::vector<size_t> first;            /* terms of species[i] are first[i] to
+                                           first[i + 1] - 1 */
+  std::vector<const LDBLE *> la;        /* la of the master species */
+  std::vector<LDBLE> coefs;
+};
+/*
+ *   sum_mb1 and sum_mb2 merged into one list of terms per target, built by
+ *   compile_species_kernel
+ */
+class mb_program {
+public:
+  ~mb_program(){};
+  mb_program() {}
+  std::vector<LDBLE *> targets;
+  std::vector<size_t> first;          /* terms of targets[i] are first[i] to
+                                         first[i + 1] - 1 */
+  std::vector<const LDBLE *> sources;
+  std::vector<LDBLE> coefs;
+};
+/*
+ *   Species of s_x with a Debye-Hueckel type activity model, grouped by gflag
+ *   so that each group is evaluated by one loop over contiguous arrays
+ */
+class gamma_group {
+public:
+  ~gamma_group(){};
+  gamma_group() {}
+  std::vector<class species *> species;
+  std::vector<LDBLE> z;   /* copies of the species parameters */
+  std::vector<LDBLE> dha;
+  std::vector<LDBLE> dhb;
+  std::vector<LDBLE> moles; /* work arrays */
+  std::vector<LDBLE> lg;
+  std::vector<LDBLE> dg;
+};
+class gammas_program {
+public:
+  ~gammas_program(){};
+  gammas_program() {}
+  class gamma_group uncharged; /* gflag 0 */
+  class gamma_group davies;    /* gflag 1 */
+  class gamma_group wateq_dh;  /* gflag 2 */
+  class gamma_group llnl_dh;   /* gflag 7, z != 0 */
+  std::vector<int> others;     /* s_x index of all other species */
+};
 class iso {
 public:
   ~iso(){};
@@ -1230,6 +1317,7 @@ public:
     linebase = NULL;
     varbase = NULL;
     loopbase = NULL;
+    program = NULL;
   }
   const char *name;
   std::string commands;
@@ -1237,6 +1325,7 @@ public:
   void *linebase;
   void *varbase;
   void *loopbase;
+  void *program; /* compiled form of linebase */
 };
 /* ----------------------------------------------------------------------
  *   GLOBAL DECLARATIONS
@@ -1601,6 +1690,104 @@ public:
   LDBLE etheta;
   LDBLE ethetap;
 };
+/*
+ *   Entry of param_list with the constant data pitzer() needs, built by
+ *   pitzer_make_lists
+ */
+class pitz_term {
+public:
+  ~pitz_term(){};
+  pitz_term() {
+    type = TYPE_Other;
+    param = -1;
+    i0 = i1 = i2 = -1;
+    alpha = -1;
+    c0_div = 0;
+    os_coef = 0;
+    for (size_t i = 0; i < 3; i++) ln_coef[i] = 0;
+  }
+  pitz_param_type type;
+  int param;       /* index in pitz_params */
+  int i0, i1, i2;  /* ispec of the parameter */
+  int alpha;       /* index in pitz_alphas, TYPE_B1 and TYPE_B2 */
+  LDBLE c0_div;    /* 2 sqrt(|z0 z1|), TYPE_C0 */
+  LDBLE os_coef;
+  LDBLE ln_coef[3];
+};
+/*
+ *   sit_params of param_list as a sparse matrix over the species of s_list,
+ *   built by sit_make_lists. Each parameter gives two entries, one in the
+ *   row of each of its species; rows keep the order of param_list.
+ */
+class sit_epsilon_matrix {
+public:
+  ~sit_epsilon_matrix(){};
+  sit_epsilon_matrix() {}
+  /* one element per parameter of param_list */
+  std::vector<int> i0, i1;
+  std::vector<int> kinds;       /* 0 epsilon, 1 epsilon * mu,
+                                   2 epsilon * log10(mu) */
+  std::vector<LDBLE> osmot_div; /* 2 if both species are neutral, else 1 */
+  std::vector<LDBLE> eps;       /* p at the T and P of PTEMP_SIT */
+  /* rows */
+  std::vector<int> targets;     /* spec index of each row */
+  std::vector<size_t> first;    /* entries of targets[i] are first[i] to
+                                   first[i + 1] - 1 */
+  std::vector<int> columns;     /* spec index of the other species */
+  std::vector<size_t> params;   /* parameter of the entry */
+};
+class logk_tp {
+public:
+  ~logk_tp(){};
+  logk_tp() {}
+  /* one element per species of s_x */
+  std::vector<LDBLE> s_lk;  /* log k without the pressure term */
+  std::vector<LDBLE> s_vm0; /* molar volume at I = 0 */
+  std::vector<LDBLE> s_bi;  /* coefficient of the volume term * I */
+  /* one element per phase in the model, in the order of phases */
+  std::vector<LDBLE> p_lk;  /* log k without the pressure term */
+};
+class logk_cache {
+public:
+  ~logk_cache(){};
+  logk_cache() {
+    hits = 0;
+    misses = 0;
+  }
+  static const size_t max_entries = 4096;
+  std::shared_mutex mutex;
+  /* log k and molar volume parameters of a model -> model id */
+  std::map<std::vector<LDBLE>, int> models;
+  /* (model id, tc, pa) -> log k's */
+  std::map<std::tuple<int, LDBLE, LDBLE>, std::shared_ptr<const logk_tp>>
+      entries;
+  /* keys of entries, oldest first */
+  std::deque<std::tuple<int, LDBLE, LDBLE>> order;
+  std::atomic<size_t> hits;   /* lookups finding an entry */
+  std::atomic<size_t> misses; /* lookups calculating an entry */
+};
+/* threads kept by an instance for the columns of the CVODE Jacobian */
+class cvode_jacobian_pool {
+public:
+  ~cvode_jacobian_pool();
+  cvode_jacobian_pool(size_t count);
+  size_t size(void) const { return threads.size(); }
+  /* runs task(0) on the calling thread and task(w + 1) on thread w,
+     returns when all are done; exceptions of the threads are dropped */
+  void run(const std::function<void(size_t)> &task);
+
+private:
+  void loop(size_t w);
+  void wait(void);
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable start; /* a new round, or stop */
+  std::condition_variable done;  /* all threads finished the round */
+  const std::function<void(size_t)> *task;
+  size_t round;   /* number of rounds started */
+  size_t pending; /* threads still running the current round */
+  bool stop;
+};
 class const_iso {
 public:
   ~const_iso(){};
@@ -16,9 +16,12 @@
 #include "cxxKinetics.h"
 #include "cxxMix.h"
 #include "nvector_serial.h" /* definitions of type N_Vector and macro          */
+#include <algorithm>
 #include <fstream>
 #include <map>
 #include <memory>
+#include <set>
+#include <thread>
 /* NV_Ith_S, prototypes for N_VNew, N_VFree      */
 /* These macros are defined in order to write code which exactly matches
    the mathematical problem description given above.
@@ -98,10 +101,14 @@ int Phreeqc::calc_kinetic_reaction(cxxKinetics *kinetics_ptr, LDBLE time_step)
           error_msg(error_string, STOP);
         }
 
+        basic_free_program(&rates[j].program);
         rate_ptr->new_def = FALSE;
       }
-      if (basic_run(l_command, rates[j].linebase, rates[j].varbase,
-                    rates[j].loopbase) != 0) {
+      if ((compiled_rates
+               ? basic_run_program(&rates[j].program, rates[j].linebase,
+                                   rates[j].varbase, rates[j].loopbase)
+               : basic_run(l_command, rates[j].linebase, rates[j].varbase,
+                           rates[j].loopbase)) != 0) {
         error_string = sformatf("Fatal Basic error in rate %s.",
                                 kinetics_comp_ptr->Get_rate_name().c_str());
         error_msg(error_string, STOP);
@@ -291,38 +298,15 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
         dc5 = -277. / 14336.;
   LDBLE dc1 = c1 - 2825. / 27648., dc3 = c3 - 18575. / 48384.,
         dc4 = c4 - 13525. / 55296., dc6 = c6 - 0.25;
-  /*
-   *  Save kinetics i and solution i, if necessary
-   */
-  save_old = -2 - (count_cells * (1 + stag_data.count_stag) + 2);
-  Utilities::Rxn_copy(Rxn_kinetics_map, i, save_old);
-  if (nsaver != i) {
-    Utilities::Rxn_copy(Rxn_solution_map, i, save_old);
-  }
-
+  kinetics_ptr = rk_begin(i, use_mix, nsaver, step_fraction, save_old);
+  if (kinetics_ptr == NULL)
+    return (OK);
   /*
    *   Malloc some space
    */
-  kinetics_ptr = Utilities::Rxn_find(Rxn_kinetics_map, i);
-  if (kinetics_ptr == NULL)
-    return (OK);
   n_reactions = (int)kinetics_ptr->Get_kinetics_comps().size();
   rk_moles.resize(6 * (size_t)n_reactions);
 
-  /*if (use_mix != NOMIX) last_model.force_prep = TRUE; */
-  set_and_run_wrapper(i, use_mix, FALSE, i, step_fraction);
-  run_reactions_iterations += iterations;
-
-  saver();
-  if (state == TRANSPORT || state == PHAST) {
-    set_transport(i, NOMIX, TRUE, i);
-  } else if (state == ADVECTION) {
-    set_advection(i, NOMIX, TRUE, i);
-  } else if (state == REACTION) {
-    set_reaction(i, NOMIX, TRUE);
-  }
-  kinetics_ptr = Utilities::Rxn_find(Rxn_kinetics_map, i);
-
   step_bad = step_ok = 0;
   l_bad = FALSE;
   h_sum = 0.;
@@ -354,12 +338,7 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
   status(0, NULL);
   while (h_sum < kin_time) {
 
-    if (step_bad > kinetics_ptr->Get_bad_step_max()) {
-      error_string = sformatf("Bad RK steps > %d in cell %d. Please decrease "
-                              "(time)step or increase -bad_step_max.",
-                              kinetics_ptr->Get_bad_step_max(), cell_no);
-      error_msg(error_string, STOP);
-    }
+    rk_check_bad_steps(kinetics_ptr, step_bad);
 
   MOLES_TOO_LARGE:
     if (moles_reduction > 1.0) {
@@ -382,16 +361,7 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
       }
       l_bad = FALSE;
     } else {
-      /*
-       *   define pointers for calc_kinetic_, they are lost after saver()...
-       */
-      if (state == TRANSPORT || state == PHAST) {
-        set_transport(i, NOMIX, TRUE, i);
-      } else if (state == ADVECTION) {
-        set_advection(i, NOMIX, TRUE, i);
-      } else if (state == REACTION) {
-        set_reaction(i, NOMIX, TRUE);
-      }
+      rk_set_pointers(i);
       /*
        *   Moles of minerals and solid solutions may change to make positive
        *   concentrations. Reactions may take out more than is present in
@@ -457,12 +427,10 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
             kinetics_comp_ptr->Set_m(0);
           kinetics_comp_ptr->Set_moles(0.);
         }
-        if (set_and_run_wrapper(i, NOMIX, TRUE, i, 0.) == MASS_BALANCE) {
-          run_reactions_iterations += iterations;
+        if (rk_equilibrate(i) == MASS_BALANCE) {
           moles_reduction = 9;
           goto MOLES_TOO_LARGE;
         }
-        run_reactions_iterations += iterations;
         calc_kinetic_reaction(kinetics_ptr, h);
         for (size_t j = 0; j < kinetics_ptr->Get_kinetics_comps().size(); j++) {
           cxxKineticsComp *kinetics_comp_ptr =
@@ -503,12 +471,10 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
      * Continue with rk ...
      */
     calc_final_kinetic_reaction(kinetics_ptr);
-    if (set_and_run_wrapper(i, NOMIX, TRUE, i, 0.) == MASS_BALANCE) {
-      run_reactions_iterations += iterations;
+    if (rk_equilibrate(i) == MASS_BALANCE) {
       moles_reduction = 9;
       goto MOLES_TOO_LARGE;
     }
-    run_reactions_iterations += iterations;
 
     /*
      *   find k2
@@ -523,18 +489,7 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
     calc_kinetic_reaction(kinetics_ptr, h);
 
     /*   Reset to values of last saver() */
-    if (pp_assemblage_save != NULL) {
-      Rxn_pp_assemblage_map[pp_assemblage_save->Get_n_user()] =
-          *pp_assemblage_save;
-      use.Set_pp_assemblage_ptr(Utilities::Rxn_find(
-          Rxn_pp_assemblage_map, pp_assemblage_save->Get_n_user()));
-    }
-    if (ss_assemblage_save != NULL) {
-      Rxn_ss_assemblage_map[ss_assemblage_save->Get_n_user()] =
-          *ss_assemblage_save;
-      use.Set_ss_assemblage_ptr(Utilities::Rxn_find(
-          Rxn_ss_assemblage_map, ss_assemblage_save->Get_n_user()));
-    }
+    rk_restore_assemblages(pp_assemblage_save, ss_assemblage_save);
 
     /* store k2 in rk_moles */
     k = n_reactions;
@@ -576,12 +531,10 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
           kinetics_comp_ptr->Set_m(0);
         kinetics_comp_ptr->Set_moles(0.);
       }
-      if (set_and_run_wrapper(i, NOMIX, TRUE, i, 0.) == MASS_BALANCE) {
-        run_reactions_iterations += iterations;
+      if (rk_equilibrate(i) == MASS_BALANCE) {
         moles_reduction = 9;
         goto MOLES_TOO_LARGE;
       }
-      run_reactions_iterations += iterations;
       /*
        * Move next calc'n to rk = 1 when initial rate equals final rate ...
        */
@@ -606,24 +559,17 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
         delete pp_assemblage_save;
         pp_assemblage_save = NULL;
       }
-      if (ss_assemblage_save != NULL) {
-        Rxn_ss_assemblage_map[ss_assemblage_save->Get_n_user()] =
-            *ss_assemblage_save;
-        use.Set_ss_assemblage_ptr(Utilities::Rxn_find(
-            Rxn_ss_assemblage_map, ss_assemblage_save->Get_n_user()));
-      }
+      rk_restore_assemblages(NULL, ss_assemblage_save);
       goto EQUAL_RATE_OUT;
     }
     /*
      * Continue runge_kutta..
      */
     calc_final_kinetic_reaction(kinetics_ptr);
-    if (set_and_run_wrapper(i, NOMIX, TRUE, i, 0.) == MASS_BALANCE) {
-      run_reactions_iterations += iterations;
+    if (rk_equilibrate(i) == MASS_BALANCE) {
       moles_reduction = 9;
       goto MOLES_TOO_LARGE;
     }
-    run_reactions_iterations += iterations;
     /*
      *   find k3
      */
@@ -638,18 +584,7 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
     calc_kinetic_reaction(kinetics_ptr, h);
 
     /*   Reset to values of last saver() */
-    if (pp_assemblage_save != NULL) {
-      Rxn_pp_assemblage_map[pp_assemblage_save->Get_n_user()] =
-          *pp_assemblage_save;
-      use.Set_pp_assemblage_ptr(Utilities::Rxn_find(
-          Rxn_pp_assemblage_map, pp_assemblage_save->Get_n_user()));
-    }
-    if (ss_assemblage_save != NULL) {
-      Rxn_ss_assemblage_map[ss_assemblage_save->Get_n_user()] =
-          *ss_assemblage_save;
-      use.Set_ss_assemblage_ptr(Utilities::Rxn_find(
-          Rxn_ss_assemblage_map, ss_assemblage_save->Get_n_user()));
-    }
+    rk_restore_assemblages(pp_assemblage_save, ss_assemblage_save);
 
     /* store k3 in rk_moles */
     k = 2 * n_reactions;
@@ -695,12 +630,10 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
         kinetics_comp_ptr->Set_moles(0.);
       }
 
-      if (set_and_run_wrapper(i, NOMIX, TRUE, i, 0.) == MASS_BALANCE) {
-        run_reactions_iterations += iterations;
+      if (rk_equilibrate(i) == MASS_BALANCE) {
         moles_reduction = 9;
         goto MOLES_TOO_LARGE;
       }
-      run_reactions_iterations += iterations;
       /*
        * Move next calc'n to rk = 1 when initial rate equals final rate ...
        */
@@ -736,12 +669,10 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
      */
 
     calc_final_kinetic_reaction(kinetics_ptr);
-    if (set_and_run_wrapper(i, NOMIX, TRUE, i, 0.) == MASS_BALANCE) {
-      run_reactions_iterations += iterations;
+    if (rk_equilibrate(i) == MASS_BALANCE) {
       moles_reduction = 9;
       goto MOLES_TOO_LARGE;
     }
-    run_reactions_iterations += iterations;
     /*
      *   find k4
      */
@@ -755,18 +686,7 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
     calc_kinetic_reaction(kinetics_ptr, h);
 
     /*   Reset to values of last saver() */
-    if (pp_assemblage_save != NULL) {
-      Rxn_pp_assemblage_map[pp_assemblage_save->Get_n_user()] =
-          *pp_assemblage_save;
-      use.Set_pp_assemblage_ptr(Utilities::Rxn_find(
-          Rxn_pp_assemblage_map, pp_assemblage_save->Get_n_user()));
-    }
-    if (ss_assemblage_save != NULL) {
-      Rxn_ss_assemblage_map[ss_assemblage_save->Get_n_user()] =
-          *ss_assemblage_save;
-      use.Set_ss_assemblage_ptr(Utilities::Rxn_find(
-          Rxn_ss_assemblage_map, ss_assemblage_save->Get_n_user()));
-    }
+    rk_restore_assemblages(pp_assemblage_save, ss_assemblage_save);
 
     /* store k4 in rk_moles */
     k = 3 * n_reactions;
@@ -787,12 +707,10 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
     if (moles_reduction > 1.0)
       goto MOLES_TOO_LARGE;
     calc_final_kinetic_reaction(kinetics_ptr);
-    if (set_and_run_wrapper(i, NOMIX, TRUE, i, 0.) == MASS_BALANCE) {
-      run_reactions_iterations += iterations;
+    if (rk_equilibrate(i) == MASS_BALANCE) {
       moles_reduction = 9;
       goto MOLES_TOO_LARGE;
     }
-    run_reactions_iterations += iterations;
     /*
      *   find k5
      */
@@ -806,18 +724,7 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
     calc_kinetic_reaction(kinetics_ptr, h);
 
     /*   Reset to values of last saver() */
-    if (pp_assemblage_save != NULL) {
-      Rxn_pp_assemblage_map[pp_assemblage_save->Get_n_user()] =
-          *pp_assemblage_save;
-      use.Set_pp_assemblage_ptr(Utilities::Rxn_find(
-          Rxn_pp_assemblage_map, pp_assemblage_save->Get_n_user()));
-    }
-    if (ss_assemblage_save != NULL) {
-      Rxn_ss_assemblage_map[ss_assemblage_save->Get_n_user()] =
-          *ss_assemblage_save;
-      use.Set_ss_assemblage_ptr(Utilities::Rxn_find(
-          Rxn_ss_assemblage_map, ss_assemblage_save->Get_n_user()));
-    }
+    rk_restore_assemblages(pp_assemblage_save, ss_assemblage_save);
 
     /* store k5 in rk_moles */
     k = 4 * n_reactions;
@@ -839,12 +746,10 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
     if (moles_reduction > 1.0)
       goto MOLES_TOO_LARGE;
     calc_final_kinetic_reaction(kinetics_ptr);
-    if (set_and_run_wrapper(i, NOMIX, TRUE, i, 0.) == MASS_BALANCE) {
-      run_reactions_iterations += iterations;
+    if (rk_equilibrate(i) == MASS_BALANCE) {
       moles_reduction = 9;
       goto MOLES_TOO_LARGE;
     }
-    run_reactions_iterations += iterations;
     /*
      *   find k6
      */
@@ -858,18 +763,7 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
     calc_kinetic_reaction(kinetics_ptr, h);
 
     /*   Reset to values of last saver() */
-    if (pp_assemblage_save != NULL) {
-      Rxn_pp_assemblage_map[pp_assemblage_save->Get_n_user()] =
-          *pp_assemblage_save;
-      use.Set_pp_assemblage_ptr(Utilities::Rxn_find(
-          Rxn_pp_assemblage_map, pp_assemblage_save->Get_n_user()));
-    }
-    if (ss_assemblage_save != NULL) {
-      Rxn_ss_assemblage_map[ss_assemblage_save->Get_n_user()] =
-          *ss_assemblage_save;
-      use.Set_ss_assemblage_ptr(Utilities::Rxn_find(
-          Rxn_ss_assemblage_map, ss_assemblage_save->Get_n_user()));
-    }
+    rk_restore_assemblages(pp_assemblage_save, ss_assemblage_save);
 
     /* store k6 in rk_moles */
     k = 5 * n_reactions;
@@ -933,12 +827,10 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
         kinetics_comp_ptr->Set_moles(0.);
       }
 
-      if (set_and_run_wrapper(i, NOMIX, TRUE, i, 0.) == MASS_BALANCE) {
-        run_reactions_iterations += iterations;
+      if (rk_equilibrate(i) == MASS_BALANCE) {
         moles_reduction = 9;
         goto MOLES_TOO_LARGE;
       }
-      run_reactions_iterations += iterations;
       /*
        * Move next calc'n to rk = 1 when initial rate equals final rate ...
        */
@@ -992,6 +884,391 @@ int Phreeqc::rk_kinetics(int i, LDBLE kin_time, int use_mix, int nsaver,
 
 EQUAL_RATE_OUT:
 
+  rk_finish(i, kin_time, use_mix, nsaver, save_old);
+  rk_moles.clear();
+
+  /*  Free space */
+
+  if (pp_assemblage_save != NULL) {
+    delete pp_assemblage_save;
+    pp_assemblage_save = NULL;
+  }
+  if (ss_assemblage_save != NULL) {
+    delete ss_assemblage_save;
+    ss_assemblage_save = NULL;
+  }
+  return (OK);
+}
+
+/* ---------------------------------------------------------------------- */
+int Phreeqc::rk_embedded_kinetics(int i, LDBLE kin_time, int use_mix,
+                                  int nsaver, LDBLE step_fraction)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Embedded methods of KINETICS -runge_kutta; k are the moles of the
+   *   reactions in step h at the rates of a stage.
+   *
+   *   dormand_prince: 7 stages of order 5 with an error estimate of
+   *	order 4. The first stage takes the rates at the equilibrium of the
+   *	start of the step, the last one is taken at the result of the step,
+   *	so a step equilibrates 6 times, as Cash-Karp does.
+   *   rosenbrock: the linearly implicit ROS2 of order 2 with an error
+   *	estimate of order 1, for mildly stiff rates, with 2 equilibrations
+   *	per step. The Jacobian of the rates is taken by differences, n more
+   *	equilibrations, and kept over the steps; ROS2 keeps its order with
+   *	an approximate Jacobian. A rejected step takes a new Jacobian only
+   *	if the kept one is from an earlier step.
+   *
+   *   The equilibrium of each stage starts from the activities of the
+   *   stage before, see rk_warm_start.
+   */
+  static const LDBLE dp_c[7] = {0., 0.2, 0.3, 0.8, 8. / 9., 1., 1.};
+  static const LDBLE dp_a[7][6] = {
+      {0., 0., 0., 0., 0., 0.},
+      {0.2, 0., 0., 0., 0., 0.},
+      {3. / 40., 9. / 40., 0., 0., 0., 0.},
+      {44. / 45., -56. / 15., 32. / 9., 0., 0., 0.},
+      {19372. / 6561., -25360. / 2187., 64448. / 6561., -212. / 729., 0., 0.},
+      {9017. / 3168., -355. / 33., 46732. / 5247., 49. / 176.,
+       -5103. / 18656., 0.},
+      {35. / 384., 0., 500. / 1113., 125. / 192., -2187. / 6784.,
+       11. / 84.}};
+  static const LDBLE dp_e[7] = {71. / 57600.,  0.,
+                                -71. / 16695., 71. / 1920.,
+                                -17253. / 339200., 22. / 525.,
+                                -1. / 40.};
+  const LDBLE gamma = 1. + 1. / sqrt(2.);
+  int save_old, step_bad, step_ok;
+  LDBLE h, h_new, h_sum, l_error, error_max, exponent, safety, moles_max,
+      moles_reduction;
+  bool rosenbrock, new_step, have_jacobian, jacobian_current;
+  size_t n, count_stages;
+  cxxKinetics *kinetics_ptr;
+  std::unique_ptr<cxxPPassemblage> pp_assemblage_save;
+  std::unique_ptr<cxxSSassemblage> ss_assemblage_save;
+  kinetics_ptr = rk_begin(i, use_mix, nsaver, step_fraction, save_old);
+  if (kinetics_ptr == NULL)
+    return (OK);
+  n = kinetics_ptr->Get_kinetics_comps().size();
+  rosenbrock = kinetics_ptr->Get_rk_method() == cxxKinetics::RK_ROSENBROCK;
+  count_stages = rosenbrock ? 3 : 7;
+  /* step sizes scale with the error to 1 / (order of the estimate + 1) */
+  exponent = rosenbrock ? -0.5 : -0.2;
+  std::vector<std::vector<LDBLE>> k(count_stages, std::vector<LDBLE>(n));
+  std::vector<LDBLE> moles(n), jacobian(n * n), w(n * n);
+  std::vector<LDBLE *> w_columns(n);
+  std::vector<integertype> pivots(n);
+  for (size_t j = 0; j < n; j++) {
+    w_columns[j] = &w[j * n];
+  }
+
+  step_bad = step_ok = 0;
+  h_sum = 0.;
+  h = kin_time;
+  moles_max = 0.1;
+  moles_reduction = 1.0;
+  safety = 0.9;
+  if (kinetics_ptr->Get_step_divide() > 1.0) {
+    h = kin_time / kinetics_ptr->Get_step_divide();
+  } else if (kinetics_ptr->Get_step_divide() < 1.0) {
+    moles_max = kinetics_ptr->Get_step_divide();
+  }
+  new_step = true;
+  have_jacobian = jacobian_current = false;
+  rate_sim_time = rate_sim_time_start;
+
+  status(0, NULL);
+  while (h_sum < kin_time) {
+    rk_check_bad_steps(kinetics_ptr, step_bad);
+    rk_set_pointers(i);
+    if (new_step) {
+      /*
+       *   reactants at the start of the step, k1 at its equilibrium
+       */
+      if (use.Get_pp_assemblage_ptr() != NULL) {
+        pp_assemblage_save.reset(new cxxPPassemblage(*Utilities::Rxn_find(
+            Rxn_pp_assemblage_map, use.Get_pp_assemblage_ptr()->Get_n_user())));
+      }
+      if (use.Get_ss_assemblage_ptr() != NULL) {
+        ss_assemblage_save.reset(new cxxSSassemblage(*Utilities::Rxn_find(
+            Rxn_ss_assemblage_map, use.Get_ss_assemblage_ptr()->Get_n_user())));
+      }
+      for (size_t j = 0; j < n; j++) {
+        cxxKineticsComp *kinetics_comp_ptr =
+            &(kinetics_ptr->Get_kinetics_comps()[j]);
+        kinetics_comp_ptr->Set_moles(0.);
+        m_temp[j] = kinetics_comp_ptr->Get_m();
+      }
+      rate_sim_time = rate_sim_time_start + h_sum;
+      calc_kinetic_reaction(kinetics_ptr, h);
+      for (size_t j = 0; j < n; j++) {
+        k[0][j] = kinetics_ptr->Get_kinetics_comps()[j].Get_moles();
+      }
+      new_step = false;
+    }
+    for (size_t j = 0; j < n; j++) {
+      if (moles_reduction * moles_max < fabs(k[0][j])) {
+        moles_reduction = fabs(k[0][j]) / moles_max;
+      }
+    }
+    error_max = 0.;
+    if (moles_reduction > 1.0) {
+      goto MOLES_TOO_LARGE;
+    }
+
+    if (rosenbrock) {
+      /*
+       *   Jacobian of the rates, moles per time for moles of reaction
+       */
+      if (!have_jacobian) {
+        for (size_t c = 0; c < n; c++) {
+          LDBLE del = 1e-4 *
+                      std::max(fabs(k[0][c]),
+                               kinetics_ptr->Get_kinetics_comps()[c].Get_tol());
+          std::fill(moles.begin(), moles.end(), 0.);
+          moles[c] = del;
+          if (rk_stage(i, kinetics_ptr, moles, h, h_sum,
+                       pp_assemblage_save.get(), ss_assemblage_save.get(),
+                       k[1]) == MASS_BALANCE) {
+            std::copy(k[0].begin(), k[0].end(), k[1].begin());
+          }
+          for (size_t j = 0; j < n; j++) {
+            jacobian[c * n + j] = (k[1][j] - k[0][j]) / (del * h);
+          }
+        }
+        have_jacobian = jacobian_current = true;
+      }
+      /*
+       *   W = I - gamma h J, the identity if it is singular
+       */
+      for (size_t c = 0; c < n; c++) {
+        for (size_t j = 0; j < n; j++) {
+          w[c * n + j] = (c == j ? 1. : 0.) - gamma * h * jacobian[c * n + j];
+        }
+      }
+      if (n > 0 && gefa(&w_columns[0], (integertype)n, &pivots[0]) != 0) {
+        for (size_t c = 0; c < n; c++) {
+          for (size_t j = 0; j < n; j++) {
+            w[c * n + j] = (c == j ? 1. : 0.);
+            jacobian[c * n + j] = 0.;
+          }
+          pivots[c] = (integertype)c;
+        }
+      }
+      /*
+       *   W k1 = h f(y), W k2 = h f(y + k1) - 2 k1
+       */
+      std::copy(k[0].begin(), k[0].end(), k[1].begin());
+      if (n > 0) {
+        gesl(&w_columns[0], (integertype)n, &pivots[0], &k[1][0]);
+      }
+      for (size_t j = 0; j < n; j++) {
+        if (moles_reduction * moles_max < fabs(k[1][j])) {
+          moles_reduction = fabs(k[1][j]) / moles_max;
+        }
+      }
+      if (moles_reduction > 1.0) {
+        goto MOLES_TOO_LARGE;
+      }
+      if (rk_stage(i, kinetics_ptr, k[1], h, h_sum + h,
+                   pp_assemblage_save.get(), ss_assemblage_save.get(),
+                   k[2]) == MASS_BALANCE) {
+        moles_reduction = 9;
+        goto MOLES_TOO_LARGE;
+      }
+      for (size_t j = 0; j < n; j++) {
+        k[2][j] -= 2. * k[1][j];
+      }
+      if (n > 0) {
+        gesl(&w_columns[0], (integertype)n, &pivots[0], &k[2][0]);
+      }
+      /*
+       *   y = 1.5 k1 + 0.5 k2, the order 1 estimate is k1
+       */
+      for (size_t j = 0; j < n; j++) {
+        moles[j] = 1.5 * k[1][j] + 0.5 * k[2][j];
+        l_error = fabs(0.5 * k[1][j] + 0.5 * k[2][j]);
+        /* tol is in moles/l */
+        l_error /= kinetics_ptr->Get_kinetics_comps()[j].Get_tol();
+        if (l_error > error_max)
+          error_max = l_error;
+      }
+    } else {
+      for (size_t s = 1; s < count_stages; s++) {
+        for (size_t j = 0; j < n; j++) {
+          moles[j] = 0.;
+          for (size_t r = 0; r < s; r++) {
+            moles[j] += dp_a[s][r] * k[r][j];
+          }
+        }
+        if (rk_stage(i, kinetics_ptr, moles, h, h_sum + dp_c[s] * h,
+                     pp_assemblage_save.get(), ss_assemblage_save.get(),
+                     k[s]) == MASS_BALANCE) {
+          moles_reduction = 9;
+          goto MOLES_TOO_LARGE;
+        }
+        for (size_t j = 0; j < n; j++) {
+          if (moles_reduction * moles_max < fabs(k[s][j])) {
+            moles_reduction = fabs(k[s][j]) / moles_max;
+          }
+        }
+        if (moles_reduction > 1.0) {
+          goto MOLES_TOO_LARGE;
+        }
+      }
+      for (size_t j = 0; j < n; j++) {
+        l_error = 0.;
+        for (size_t s = 0; s < count_stages; s++) {
+          l_error += dp_e[s] * k[s][j];
+        }
+        /* tol is in moles/l */
+        l_error = fabs(l_error);
+        l_error /= kinetics_ptr->Get_kinetics_comps()[j].Get_tol();
+        if (l_error > error_max)
+          error_max = l_error;
+      }
+    }
+
+    /*
+     *   repeat with smaller step
+     */
+    if (error_max > 1) {
+      h_new = h * std::max((LDBLE)0.2, safety * pow(error_max, exponent));
+      for (size_t j = 0; j < n; j++) {
+        k[0][j] *= h_new / h;
+      }
+      h = h_new;
+      have_jacobian = jacobian_current;
+      step_bad++;
+      continue;
+    }
+    /*
+     *   OK, the last stage of Dormand-Prince is the result, Rosenbrock
+     *   calculates it
+     */
+    if (rosenbrock &&
+        rk_stage(i, kinetics_ptr, moles, h, h_sum + h, pp_assemblage_save.get(),
+                 ss_assemblage_save.get(), k[2]) == MASS_BALANCE) {
+      moles_reduction = 9;
+      goto MOLES_TOO_LARGE;
+    }
+    saver();
+    step_ok++;
+    h_sum += h;
+    new_step = true;
+    jacobian_current = false;
+    /*
+     *   and increase step size ...
+     */
+    h_new = h * 5.;
+    if (error_max > 0.) {
+      h_new = h * std::min((LDBLE)5.,
+                           std::max((LDBLE)0.2,
+                                    safety * pow(error_max, exponent)));
+    }
+    if (h_new > (kin_time - h_sum))
+      h_new = (kin_time - h_sum);
+    h = h_new;
+    {
+      char str[MAX_LENGTH];
+      snprintf(str, sizeof(str), "RK-steps: Bad%4d. OK%5d. Time %3d%%",
+               step_bad, step_ok, (int)(100 * h_sum / kin_time));
+      status(0, str, true);
+    }
+    continue;
+
+  MOLES_TOO_LARGE:
+    h_new = safety * h / (1.0 + moles_reduction);
+    moles_reduction = 1.0;
+    for (size_t j = 0; j < n; j++) {
+      k[0][j] *= h_new / h;
+    }
+    h = h_new;
+  }
+
+  rk_finish(i, kin_time, use_mix, nsaver, save_old);
+  return (OK);
+}
+
+/* ---------------------------------------------------------------------- */
+int Phreeqc::rk_stage(int i, cxxKinetics *kinetics_ptr,
+                      const std::vector<LDBLE> &moles, LDBLE h, LDBLE t,
+                      const cxxPPassemblage *pp_assemblage_save,
+                      const cxxSSassemblage *ss_assemblage_save,
+                      std::vector<LDBLE> &k)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Equilibrates solution i with the reactants at the start of the step
+   *   and moles of the kinetic reactions, and gives in k the moles of the
+   *   reactions in step h at the rates of that equilibrium, t after the
+   *   start of the kinetic time step. Returns MASS_BALANCE if the moles
+   *   take out more than is present.
+   */
+  std::vector<cxxKineticsComp> &comps = kinetics_ptr->Get_kinetics_comps();
+
+  for (size_t j = 0; j < comps.size(); j++) {
+    comps[j].Set_moles(moles[j]);
+    comps[j].Set_m(m_temp[j] - moles[j]);
+  }
+  calc_final_kinetic_reaction(kinetics_ptr);
+  /*   Reset to values of last saver() */
+  rk_restore_assemblages(pp_assemblage_save, ss_assemblage_save);
+  if (rk_equilibrate(i) == MASS_BALANCE)
+    return (MASS_BALANCE);
+  rk_warm_start(i);
+
+  for (size_t j = 0; j < comps.size(); j++) {
+    comps[j].Set_m(m_temp[j] - comps[j].Get_moles());
+    if (comps[j].Get_m() < 1.e-30)
+      comps[j].Set_m(0);
+    comps[j].Set_moles(0.);
+  }
+  rate_sim_time = rate_sim_time_start + t;
+  calc_kinetic_reaction(kinetics_ptr, h);
+  for (size_t j = 0; j < comps.size(); j++) {
+    k[j] = comps[j].Get_moles();
+  }
+  return (OK);
+}
+
+/* ---------------------------------------------------------------------- */
+cxxKinetics *Phreeqc::rk_begin(int i, int use_mix, int nsaver,
+                               LDBLE step_fraction, int &save_old)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Start of the Runge-Kutta methods: saves kinetics i and solution i,
+   *   if necessary, as save_old and equilibrates cell i at the start of the
+   *   kinetic time step. Returns kinetics i, NULL if there is none.
+   */
+  save_old = -2 - (count_cells * (1 + stag_data.count_stag) + 2);
+  Utilities::Rxn_copy(Rxn_kinetics_map, i, save_old);
+  if (nsaver != i) {
+    Utilities::Rxn_copy(Rxn_solution_map, i, save_old);
+  }
+  if (Utilities::Rxn_find(Rxn_kinetics_map, i) == NULL)
+    return (NULL);
+
+  /*if (use_mix != NOMIX) last_model.force_prep = TRUE; */
+  set_and_run_wrapper(i, use_mix, FALSE, i, step_fraction);
+  run_reactions_iterations += iterations;
+
+  saver();
+  rk_set_pointers(i);
+  return (Utilities::Rxn_find(Rxn_kinetics_map, i));
+}
+
+/* ---------------------------------------------------------------------- */
+void Phreeqc::rk_finish(int i, LDBLE kin_time, int use_mix, int nsaver,
+                        int save_old)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   End of the Runge-Kutta methods: distributes the species of cell i,
+   *   gives back its mix and restores solution i, if necessary.
+   */
   /*
    *   Run one more time to get distribution of species
    */
@@ -1017,22 +1294,115 @@ EQUAL_RATE_OUT:
   if (nsaver != i) {
     Utilities::Rxn_copy(Rxn_solution_map, save_old, i);
   }
-  rk_moles.clear();
-
-  rate_sim_time = rate_sim_time_start + kin_time;
-  use.Set_kinetics_in(true);
-
-  /*  Free space */
+  rate_sim_time = rate_sim_time_start + kin_time;
+  use.Set_kinetics_in(true);
+}
+
+/* ---------------------------------------------------------------------- */
+void Phreeqc::rk_set_pointers(int i)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   define pointers for calc_kinetic_, they are lost after saver()...
+   */
+  if (state == TRANSPORT || state == PHAST) {
+    set_transport(i, NOMIX, TRUE, i);
+  } else if (state == ADVECTION) {
+    set_advection(i, NOMIX, TRUE, i);
+  } else if (state == REACTION) {
+    set_reaction(i, NOMIX, TRUE);
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+void Phreeqc::rk_check_bad_steps(const cxxKinetics *kinetics_ptr,
+                                 int step_bad)
+/* ---------------------------------------------------------------------- */
+{
+  if (step_bad > kinetics_ptr->Get_bad_step_max()) {
+    error_string = sformatf("Bad RK steps > %d in cell %d. Please decrease "
+                            "(time)step or increase -bad_step_max.",
+                            kinetics_ptr->Get_bad_step_max(), cell_no);
+    error_msg(error_string, STOP);
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+void Phreeqc::rk_restore_assemblages(const cxxPPassemblage *pp_assemblage_save,
+                                     const cxxSSassemblage *ss_assemblage_save)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Resets the assemblages to the values of the last saver(), the
+   *   reactants at the start of the step
+   */
+  if (pp_assemblage_save != NULL) {
+    Rxn_pp_assemblage_map[pp_assemblage_save->Get_n_user()] =
+        *pp_assemblage_save;
+    use.Set_pp_assemblage_ptr(Utilities::Rxn_find(
+        Rxn_pp_assemblage_map, pp_assemblage_save->Get_n_user()));
+  }
+  if (ss_assemblage_save != NULL) {
+    Rxn_ss_assemblage_map[ss_assemblage_save->Get_n_user()] =
+        *ss_assemblage_save;
+    use.Set_ss_assemblage_ptr(Utilities::Rxn_find(
+        Rxn_ss_assemblage_map, ss_assemblage_save->Get_n_user()));
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+int Phreeqc::rk_equilibrate(int i)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Equilibrates cell i with the reaction of a stage, see
+   *   calc_final_kinetic_reaction, and counts the equilibrations of the
+   *   Runge-Kutta methods. Returns MASS_BALANCE if the reaction takes out
+   *   more than is present.
+   */
+  rk_equilibrations++;
+  if (set_and_run_wrapper(i, NOMIX, TRUE, i, 0.) == MASS_BALANCE) {
+    run_reactions_iterations += iterations;
+    return (MASS_BALANCE);
+  }
+  run_reactions_iterations += iterations;
+  return (OK);
+}
 
-  if (pp_assemblage_save != NULL) {
-    delete pp_assemblage_save;
-    pp_assemblage_save = NULL;
+/* ---------------------------------------------------------------------- */
+void Phreeqc::rk_warm_start(int n_user)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Copies the activities of the last equilibrium into solution n_user
+   *   as initial guesses for the next stage, the totals of the solution
+   *   are not changed.
+   */
+  cxxSolution *solution_ptr = Utilities::Rxn_find(Rxn_solution_map, n_user);
+  if (solution_ptr == NULL)
+    return;
+  solution_ptr->Set_ph(ph_x);
+  solution_ptr->Set_pe(solution_pe_x);
+  solution_ptr->Set_mu(mu_x);
+  solution_ptr->Set_ah2o(ah2o_x);
+  for (int j = 0; j < (int)master.size(); j++) {
+    if (master[j]->s->type == EX || master[j]->s->type == SURF ||
+        master[j]->s->type == SURF_PSI)
+      continue;
+    if (master[j]->s == s_hplus || master[j]->s == s_h2o)
+      continue;
+    if (master[j]->in != FALSE) {
+      solution_ptr->Get_master_activity()[master[j]->elt->name] =
+          master[j]->s->la;
+    }
   }
-  if (ss_assemblage_save != NULL) {
-    delete ss_assemblage_save;
-    ss_assemblage_save = NULL;
+  if (pitzer_model == TRUE || sit_model == TRUE) {
+    for (int j = 0; j < (int)this->s_x.size(); j++) {
+      if (s_x[j]->lg != 0.0) {
+        solution_ptr->Get_species_gamma()[s_x[j]->name] = s_x[j]->lg;
+      }
+    }
   }
-  return (OK);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -1841,7 +2211,11 @@ int Phreeqc::run_reactions(int i, LDBLE kin_time, int use_mix,
                                       rk_kinetics(i, kin_time, NOMIX, nsaver,
          step_fraction); else
        */
-      rk_kinetics(i, kin_time, use_mix, nsaver, step_fraction);
+      if (kinetics_ptr->Get_rk_method() == cxxKinetics::RK_CASH_KARP) {
+        rk_kinetics(i, kin_time, use_mix, nsaver, step_fraction);
+      } else {
+        rk_embedded_kinetics(i, kin_time, use_mix, nsaver, step_fraction);
+      }
     } else {
       save_old = -2 - (count_cells * (1 + stag_data.count_stag) + 2);
       if (nsaver != i) {
@@ -1875,30 +2249,9 @@ int Phreeqc::run_reactions(int i, LDBLE kin_time, int use_mix,
       saver();
       pp_assemblage_ptr = Utilities::Rxn_find(Rxn_pp_assemblage_map, i);
       ss_assemblage_ptr = Utilities::Rxn_find(Rxn_ss_assemblage_map, i);
-      if (pp_assemblage_ptr != NULL) {
-        cvode_pp_assemblage_save = new cxxPPassemblage(*pp_assemblage_ptr);
-      }
-      if (ss_assemblage_ptr != NULL) {
-        cvode_ss_assemblage_save = new cxxSSassemblage(*ss_assemblage_ptr);
-      }
-      /* allocate space for CVODE */
-      kinetics_machEnv = M_EnvInit_Serial(n_reactions);
-      kinetics_machEnv->phreeqc_ptr = this;
-      kinetics_y = N_VNew(n_reactions,
-                          kinetics_machEnv); /* Allocate y, abstol vectors */
-      if (kinetics_y == NULL)
-        malloc_error();
-      cvode_last_good_y = N_VNew(
-          n_reactions, kinetics_machEnv); /* Allocate y, abstol vectors */
-      if (cvode_last_good_y == NULL)
-        malloc_error();
-      cvode_prev_good_y = N_VNew(
-          n_reactions, kinetics_machEnv); /* Allocate y, abstol vectors */
-      if (cvode_prev_good_y == NULL)
-        malloc_error();
-      kinetics_abstol = N_VNew(n_reactions, kinetics_machEnv);
-      if (kinetics_abstol == NULL)
-        malloc_error();
+      /* allocate space for CVODE, kept for the next cell */
+      cvode_workspace(n_reactions);
+      cvode_save_assemblages(pp_assemblage_ptr, ss_assemblage_ptr);
       for (int j = 0; j < n_reactions; j++) {
         Ith(cvode_last_good_y, j + 1) = 0.0;
         Ith(cvode_prev_good_y, j + 1) = 0.0;
@@ -1947,18 +2300,7 @@ int Phreeqc::run_reactions(int i, LDBLE kin_time, int use_mix,
       // iopt[SLDET] = TRUE; // appt
       iopt[MXSTEP] = kinetics_ptr->Get_cvode_steps();
       iopt[MAXORD] = kinetics_ptr->Get_cvode_order();
-      kinetics_cvode_mem = CVodeMalloc(
-          n_reactions, f, 0.0, kinetics_y, BDF, NEWTON, SV, &reltol,
-          kinetics_abstol, this, NULL, TRUE, iopt, ropt, kinetics_machEnv);
-      if (kinetics_cvode_mem == NULL)
-        malloc_error();
-
-      /* Call CVDense to specify the CVODE dense linear solver with the
-         user-supplied Jacobian routine Jac. */
-      flag = CVDense(kinetics_cvode_mem, Jac, this);
-      if (flag != SUCCESS) {
-        error_msg("CVDense failed.", STOP);
-      }
+      cvode_start(&reltol, iopt, ropt);
       t = 0;
       tout = kin_time;
       /*ropt[HMAX] = tout/10.; */
@@ -2027,21 +2369,9 @@ int Phreeqc::run_reactions(int i, LDBLE kin_time, int use_mix,
           iopt[j] = 0;
           ropt[j] = 0;
         }
-        CVodeFree(kinetics_cvode_mem); /* Free the CVODE problem memory */
         iopt[MXSTEP] = kinetics_ptr->Get_cvode_steps();
         iopt[MAXORD] = kinetics_ptr->Get_cvode_order();
-        kinetics_cvode_mem = CVodeMalloc(
-            n_reactions, f, 0.0, kinetics_y, BDF, NEWTON, SV, &reltol,
-            kinetics_abstol, this, NULL, TRUE, iopt, ropt, kinetics_machEnv);
-        if (kinetics_cvode_mem == NULL)
-          malloc_error();
-
-        /* Call CVDense to specify the CVODE dense linear solver with the
-           user-supplied Jacobian routine Jac. */
-        flag = CVDense(kinetics_cvode_mem, Jac, this);
-        if (flag != SUCCESS) {
-          error_msg("CVDense failed.", STOP);
-        }
+        cvode_start(&reltol, iopt, ropt);
         flag = CVode(kinetics_cvode_mem, tout1, kinetics_y, &t, NORMAL);
         /*
            error_string = sformatf( "CVode failed, flag=%d.\n", flag);
@@ -2096,7 +2426,7 @@ int Phreeqc::run_reactions(int i, LDBLE kin_time, int use_mix,
       if (nsaver != i) {
         Utilities::Rxn_copy(Rxn_solution_map, save_old, i);
       }
-      free_cvode();
+      cvode_save_assemblages(NULL, NULL);
       use.Set_mix_in(use_save.Get_mix_in());
       use.Set_mix_ptr(use_save.Get_mix_ptr());
 
@@ -2123,14 +2453,7 @@ m_temp.clear();
 m_original.clear();
   }
   iterations = run_reactions_iterations;
-  if (cvode_pp_assemblage_save != NULL) {
-    delete cvode_pp_assemblage_save;
-    cvode_pp_assemblage_save = NULL;
-  }
-  if (cvode_ss_assemblage_save != NULL) {
-    delete cvode_ss_assemblage_save;
-    cvode_ss_assemblage_save = NULL;
-  }
+  cvode_save_assemblages(NULL, NULL);
   return (OK);
 }
 
@@ -2157,17 +2480,615 @@ int Phreeqc::free_cvode(void)
     M_EnvFree_Serial(
         kinetics_machEnv); /* Free the machine environment memory */
   kinetics_machEnv = NULL;
-  if (cvode_pp_assemblage_save != NULL) {
-    delete cvode_pp_assemblage_save;
-    cvode_pp_assemblage_save = NULL;
+  cvode_workspace_n = 0;
+  cvode_save_assemblages(NULL, NULL);
+  return (OK);
+}
+
+/* ---------------------------------------------------------------------- */
+int Phreeqc::cvode_workspace(int n_reactions)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Allocates the vectors of CVODE for n_reactions. The vectors and the
+   *   CVODE memory of the previous cell are reused if the number of
+   *   reactions is the same.
+   */
+  if (kinetics_machEnv != NULL && cvode_workspace_n == n_reactions) {
+    return (OK);
+  }
+  free_cvode();
+  kinetics_machEnv = M_EnvInit_Serial(n_reactions);
+  kinetics_machEnv->phreeqc_ptr = this;
+  kinetics_y = N_VNew(n_reactions,
+                      kinetics_machEnv); /* Allocate y, abstol vectors */
+  if (kinetics_y == NULL)
+    malloc_error();
+  cvode_last_good_y =
+      N_VNew(n_reactions, kinetics_machEnv); /* Allocate y, abstol vectors */
+  if (cvode_last_good_y == NULL)
+    malloc_error();
+  cvode_prev_good_y =
+      N_VNew(n_reactions, kinetics_machEnv); /* Allocate y, abstol vectors */
+  if (cvode_prev_good_y == NULL)
+    malloc_error();
+  kinetics_abstol = N_VNew(n_reactions, kinetics_machEnv);
+  if (kinetics_abstol == NULL)
+    malloc_error();
+  cvode_workspace_n = n_reactions;
+  return (OK);
+}
+
+/* ---------------------------------------------------------------------- */
+int Phreeqc::cvode_start(realtype *reltol, long int *iopt, realtype *ropt)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Initializes CVODE for an integration from t = 0 and y = kinetics_y.
+   *   Existing CVODE memory is reinitialized with CVReInit if it was made
+   *   for the same maximum order, otherwise it is allocated again.
+   */
+  cvode_jacobian_reused = false;
+  cvode_jacobian_synced = 0;
+  if (kinetics_cvode_mem != NULL && cvode_workspace_maxord == iopt[MAXORD]) {
+    if (CVReInit(kinetics_cvode_mem, f, 0.0, kinetics_y, BDF, NEWTON, SV,
+                 reltol, kinetics_abstol, this, NULL, TRUE, iopt, ropt,
+                 kinetics_machEnv) == SUCCESS) {
+      return (OK);
+    }
+  }
+  if (kinetics_cvode_mem != NULL) {
+    CVodeFree(kinetics_cvode_mem); /* Free the CVODE problem memory */
+  }
+  kinetics_cvode_mem =
+      CVodeMalloc(cvode_workspace_n, f, 0.0, kinetics_y, BDF, NEWTON, SV,
+                  reltol, kinetics_abstol, this, NULL, TRUE, iopt, ropt,
+                  kinetics_machEnv);
+  if (kinetics_cvode_mem == NULL)
+    malloc_error();
+  cvode_workspace_maxord = iopt[MAXORD];
+
+  /* Call CVDense to specify the CVODE dense linear solver with the
+     user-supplied Jacobian routine Jac. */
+  if (CVDense(kinetics_cvode_mem, Jac, this) != SUCCESS) {
+    error_msg("CVDense failed.", STOP);
+  }
+  return (OK);
+}
+
+/* ---------------------------------------------------------------------- */
+void Phreeqc::cvode_save_assemblages(const cxxPPassemblage *pp_assemblage_ptr,
+                                     const cxxSSassemblage *ss_assemblage_ptr)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Saves the assemblages that are restored before each evaluation of the
+   *   rates. The copies are assigned to members, which reuses their
+   *   components from the previous save. NULL clears the save.
+   */
+  cvode_pp_assemblage_save = NULL;
+  if (pp_assemblage_ptr != NULL) {
+    cvode_pp_assemblage_snapshot = *pp_assemblage_ptr;
+    cvode_pp_assemblage_save = &cvode_pp_assemblage_snapshot;
+  }
+  cvode_ss_assemblage_save = NULL;
+  if (ss_assemblage_ptr != NULL) {
+    cvode_ss_assemblage_snapshot = *ss_assemblage_ptr;
+    cvode_ss_assemblage_save = &cvode_ss_assemblage_snapshot;
   }
-  if (cvode_ss_assemblage_save != NULL) {
-    delete cvode_ss_assemblage_save;
-    cvode_ss_assemblage_save = NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+int Phreeqc::cvode_jacobian_column(N_Vector y, size_t i, bool decoupled,
+                                   const std::vector<double> &initial_rates,
+                                   std::vector<double> &column)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Calculates column i of the Jacobian on this instance, the change of
+   *   the rates for a small amount of reaction i. A decoupled reaction
+   *   does not change the solution, its rates are taken at the current
+   *   equilibrium. Returns ERROR if the equilibrium failed for all
+   *   amounts tried.
+   */
+  int count_cvode_errors;
+  LDBLE del;
+  cxxKinetics *kinetics_ptr = (cxxKinetics *)cvode_kinetics_ptr;
+  cxxKineticsComp *kinetics_comp_i_ptr = &(kinetics_ptr->Get_kinetics_comps()[i]);
+
+  /* calculate reaction up to current time */
+  del = 1e-12;
+  cvode_error = TRUE;
+  count_cvode_errors = 0;
+  while (cvode_error == TRUE) {
+    del /= 10.;
+    for (size_t j = 0; j < kinetics_ptr->Get_kinetics_comps().size(); j++) {
+      cxxKineticsComp *kinetics_comp_j_ptr =
+          &(kinetics_ptr->Get_kinetics_comps()[j]);
+      /*
+         kinetics_ptr->comps[j].moles = y[j + 1];
+         kinetics_ptr->comps[j].m = m_original[j] - y[j + 1];
+       */
+      kinetics_comp_j_ptr->Set_moles(Ith(y, j + 1));
+      kinetics_comp_j_ptr->Set_m(m_original[j] - Ith(y, j + 1));
+      if (kinetics_comp_i_ptr->Get_m() < 0) {
+        /*
+           NOTE: y is not correct if it is greater than m_original
+           However, it seems to work to let y wander off, but use
+           .moles as the correct integral.
+           It does not work to reset Y to m_original, presumably
+           because the rational extrapolation gets screwed up.
+         */
+
+        /*
+           Ith(y,i + 1) = m_original[i];
+         */
+        kinetics_comp_i_ptr->Set_moles(m_original[i]);
+        kinetics_comp_i_ptr->Set_m(0.0);
+      }
+    }
+
+    /* Add small amount of ith reaction */
+    kinetics_comp_i_ptr->Set_m(kinetics_comp_i_ptr->Get_m() - del);
+    if (kinetics_comp_i_ptr->Get_m() < 0) {
+      kinetics_comp_i_ptr->Set_m(0);
+    }
+    kinetics_comp_i_ptr->Set_moles(kinetics_comp_i_ptr->Get_moles() + del);
+    calc_final_kinetic_reaction(kinetics_ptr);
+    if (!decoupled) {
+      if (use.Get_pp_assemblage_ptr() != NULL) {
+        Rxn_pp_assemblage_map[cvode_pp_assemblage_save->Get_n_user()] =
+            *cvode_pp_assemblage_save;
+        use.Set_pp_assemblage_ptr(Utilities::Rxn_find(
+            Rxn_pp_assemblage_map, cvode_pp_assemblage_save->Get_n_user()));
+      }
+      if (set_and_run_wrapper(cvode_n_user, FALSE, TRUE, cvode_n_user,
+                              cvode_step_fraction) == MASS_BALANCE) {
+        count_cvode_errors++;
+        cvode_error = TRUE;
+        if (count_cvode_errors > 30) {
+          return (ERROR);
+        }
+        run_reactions_iterations += iterations;
+        continue;
+      }
+      run_reactions_iterations += iterations;
+    }
+    cvode_error = FALSE;
+    /*kinetics_ptr->comps[i].moles -= del; */
+    for (size_t j = 0; j < kinetics_ptr->Get_kinetics_comps().size(); j++) {
+      cxxKineticsComp *kinetics_comp_ptr =
+          &(kinetics_ptr->Get_kinetics_comps()[j]);
+      kinetics_comp_ptr->Set_moles(0.0);
+    }
+    calc_kinetic_reaction(kinetics_ptr, 1.0);
+    /* calculate new rates for df/dy[i] */
+    for (size_t j = 0; j < kinetics_ptr->Get_kinetics_comps().size(); j++) {
+      cxxKineticsComp *kinetics_comp_ptr =
+          &(kinetics_ptr->Get_kinetics_comps()[j]);
+      column[j] = (kinetics_comp_ptr->Get_moles() - initial_rates[j]) / del;
+    }
   }
   return (OK);
 }
 
+/* ---------------------------------------------------------------------- */
+bool Phreeqc::cvode_jacobian_columns(DenseMat J, N_Vector y,
+                                     const std::vector<double> &initial_rates)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Jacobian with KNOBS -cvode_jacobian_threads or -cvode_jacobian_reuse.
+   *
+   *   At the start of an integration, the Jacobian of the previous
+   *   integration is given again if no rate changed by more than the
+   *   relative tolerance -cvode_jacobian_reuse. Otherwise, the columns of
+   *   decoupled reactions are taken at the current equilibrium, and the
+   *   other columns are divided over this instance and the workers, which
+   *   are clones of this instance with the reactants of the cell.
+   *   Returns false if the equilibrium failed for a column.
+   */
+  cxxKinetics *kinetics_ptr = (cxxKinetics *)cvode_kinetics_ptr;
+  const std::vector<cxxKineticsComp> &comps = kinetics_ptr->Get_kinetics_comps();
+  const size_t n = comps.size();
+  CVodeMem cv_mem = (CVodeMem)kinetics_cvode_mem;
+
+  if (cvode_jacobian_reuse > 0 && !cvode_jacobian_reused && cv_mem != NULL &&
+      cv_mem->cv_nst == 0 && cvode_jacobian_saved_names.size() == n) {
+    bool fresh = true;
+    for (size_t j = 0; fresh && j < n; j++) {
+      fresh = comps[j].Get_rate_name() == cvode_jacobian_saved_names[j] &&
+              fabs(initial_rates[j] - cvode_jacobian_saved_rates[j]) <=
+                  cvode_jacobian_reuse *
+                      std::max(fabs(initial_rates[j]),
+                               fabs(cvode_jacobian_saved_rates[j]));
+    }
+    if (fresh) {
+      /* once per integration, CVODE asks again if Newton fails with it */
+      for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+          IJth(J, j + 1, i + 1) = cvode_jacobian_saved[i * n + j];
+        }
+      }
+      cvode_jacobian_reused = true;
+      cvode_jacobian_reuses++;
+      return true;
+    }
+  }
+  cvode_jacobian_evaluations++;
+
+  std::vector<std::vector<double>> columns(n, std::vector<double>(n));
+  std::vector<size_t> coupled;
+  for (size_t i = 0; i < n; i++) {
+    if (!cvode_jacobian_decoupled(kinetics_ptr, i)) {
+      coupled.push_back(i);
+    } else if (cvode_jacobian_column(y, i, true, initial_rates, columns[i]) ==
+               ERROR) {
+      return false;
+    }
+  }
+
+  size_t count_workers = 0;
+  if (cvode_jacobian_threads > 1 && coupled.size() > 1) {
+    count_workers =
+        std::min((size_t)cvode_jacobian_threads, coupled.size()) - 1;
+  }
+  if (cvode_jacobian_workers_serial != definitions_serial) {
+    cvode_jacobian_free();
+  }
+  while (cvode_jacobian_workers.size() < count_workers) {
+    cvode_jacobian_workers.push_back(new Phreeqc(*this));
+  }
+  cvode_jacobian_workers_serial = definitions_serial;
+  if (count_workers > 0 && (cvode_jacobian_threads_pool == NULL ||
+                            cvode_jacobian_threads_pool->size() <
+                                count_workers)) {
+    delete cvode_jacobian_threads_pool;
+    cvode_jacobian_threads_pool = new cvode_jacobian_pool(count_workers);
+  }
+  /* the reactants of the cell are copied once per integration */
+  for (size_t w = 0; w < count_workers; w++) {
+    cvode_jacobian_sync(cvode_jacobian_workers[w], w >= cvode_jacobian_synced);
+  }
+  cvode_jacobian_synced = std::max(cvode_jacobian_synced, count_workers);
+
+  /* column k of the coupled ones is done by executor k % (count_workers + 1),
+   * columns a worker failed on are done here again */
+  std::vector<int> done(coupled.size(), FALSE);
+  auto calculate = [&](size_t first) {
+    Phreeqc *executor =
+        first == 0 ? this : cvode_jacobian_workers[first - 1];
+    for (size_t k = first; k < coupled.size(); k += count_workers + 1) {
+      if (executor->cvode_jacobian_column(y, coupled[k], false, initial_rates,
+                                          columns[coupled[k]]) == ERROR) {
+        break;
+      }
+      done[k] = TRUE;
+    }
+  };
+  if (count_workers == 0) {
+    calculate(0);
+  } else {
+    cvode_jacobian_threads_pool->run([&](size_t first) {
+      if (first <= count_workers) {
+        calculate(first);
+      }
+    });
+    for (size_t w = 0; w < count_workers; w++) {
+      run_reactions_iterations +=
+          cvode_jacobian_workers[w]->run_reactions_iterations;
+    }
+  }
+  for (size_t k = 0; k < coupled.size(); k++) {
+    if (!done[k] && cvode_jacobian_column(y, coupled[k], false, initial_rates,
+                                          columns[coupled[k]]) == ERROR) {
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      IJth(J, j + 1, i + 1) = columns[i][j];
+    }
+  }
+  if (cvode_jacobian_reuse > 0) {
+    cvode_jacobian_saved.resize(n * n);
+    for (size_t i = 0; i < n; i++) {
+      std::copy(columns[i].begin(), columns[i].end(),
+                cvode_jacobian_saved.begin() + i * n);
+    }
+    cvode_jacobian_saved_rates = initial_rates;
+    cvode_jacobian_saved_names.resize(n);
+    for (size_t j = 0; j < n; j++) {
+      cvode_jacobian_saved_names[j] = comps[j].Get_rate_name();
+    }
+  }
+  return true;
+}
+
+/* ---------------------------------------------------------------------- */
+bool Phreeqc::cvode_jacobian_decoupled(cxxKinetics *kinetics_ptr, size_t i)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   A reaction with a zero formula that no exchanger or surface is
+   *   related to does not change the solution.
+   */
+  cxxKineticsComp *kinetics_comp_ptr = &(kinetics_ptr->Get_kinetics_comps()[i]);
+  cxxNameDouble::iterator it = kinetics_comp_ptr->Get_namecoef().begin();
+  for (; it != kinetics_comp_ptr->Get_namecoef().end(); it++) {
+    if (it->second != 0.0) {
+      return false;
+    }
+  }
+  if (use.Get_exchange_ptr() != NULL &&
+      use.Get_exchange_ptr()->Get_related_rate()) {
+    cxxExchange *exchange_ptr = use.Get_exchange_ptr();
+    for (size_t j = 0; j < exchange_ptr->Get_exchange_comps().size(); j++) {
+      if (strcmp_nocase(
+              kinetics_comp_ptr->Get_rate_name().c_str(),
+              exchange_ptr->Get_exchange_comps()[j].Get_rate_name().c_str()) ==
+          0) {
+        return false;
+      }
+    }
+  }
+  if (use.Get_surface_ptr() != NULL &&
+      use.Get_surface_ptr()->Get_related_rate()) {
+    cxxSurface *surface_ptr = use.Get_surface_ptr();
+    for (size_t j = 0; j < surface_ptr->Get_surface_comps().size(); j++) {
+      if (strcmp_nocase(
+              kinetics_comp_ptr->Get_rate_name().c_str(),
+              surface_ptr->Get_surface_comps()[j].Get_rate_name().c_str()) ==
+          0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* the copies of the entities numbered keys and of the entity ptr points at,
+   which is searched by address: the intermediate entities saved as -1 keep
+   the number n_user of the cell */
+template <typename T>
+static T *cvode_jacobian_copy(std::map<int, T> &to, const std::map<int, T> &from,
+                              int n_user, const std::set<int> &keys,
+                              const T *ptr) {
+  typename std::map<int, T>::const_iterator it;
+  for (std::set<int>::const_iterator k = keys.begin(); k != keys.end(); k++) {
+    it = from.find(*k);
+    if (it != from.end()) {
+      to[*k] = it->second;
+    }
+  }
+  if (ptr == NULL) {
+    return NULL;
+  }
+  for (it = from.begin(); it != from.end(); it++) {
+    if (&it->second == ptr) {
+      to[it->first] = it->second;
+      return &to[it->first];
+    }
+  }
+  to[n_user] = *ptr;
+  return &to[n_user];
+}
+
+/* ---------------------------------------------------------------------- */
+void Phreeqc::cvode_jacobian_sync(Phreeqc *worker, bool reactants)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Copies the state of the integration to a worker, which then
+   *   calculates columns as this instance does. The reactants of the cell
+   *   are copied if reactants is true, at the first Jacobian of an
+   *   integration, replacing the ones of the previous cell. Later, only
+   *   the solid solutions are copied, which step() changes in place.
+   */
+  const int n = cvode_n_user;
+
+  if (reactants) {
+    /* the cell and the entities of the simulation, which are also looked
+       up by the numbers in use */
+    std::set<int> keys;
+    keys.insert(n);
+    keys.insert(use.Get_n_solution_user());
+    keys.insert(use.Get_n_pp_assemblage_user());
+    keys.insert(use.Get_n_ss_assemblage_user());
+    keys.insert(use.Get_n_exchange_user());
+    keys.insert(use.Get_n_surface_user());
+    keys.insert(use.Get_n_gas_phase_user());
+    keys.insert(use.Get_n_kinetics_user());
+    keys.insert(use.Get_n_reaction_user());
+    keys.insert(use.Get_n_temperature_user());
+    keys.insert(use.Get_n_pressure_user());
+
+    worker->Rxn_solution_map.clear();
+    worker->Rxn_pp_assemblage_map.clear();
+    worker->Rxn_ss_assemblage_map.clear();
+    worker->Rxn_exchange_map.clear();
+    worker->Rxn_surface_map.clear();
+    worker->Rxn_gas_phase_map.clear();
+    worker->Rxn_kinetics_map.clear();
+    worker->Rxn_reaction_map.clear();
+    worker->Rxn_temperature_map.clear();
+    worker->Rxn_pressure_map.clear();
+
+    worker->use = use;
+    worker->use.Set_solution_ptr(
+        cvode_jacobian_copy(worker->Rxn_solution_map, Rxn_solution_map, n, keys,
+                            use.Get_solution_ptr()));
+    worker->use.Set_pp_assemblage_ptr(cvode_jacobian_copy(
+        worker->Rxn_pp_assemblage_map, Rxn_pp_assemblage_map, n, keys,
+        use.Get_pp_assemblage_ptr()));
+    worker->use.Set_ss_assemblage_ptr(cvode_jacobian_copy(
+        worker->Rxn_ss_assemblage_map, Rxn_ss_assemblage_map, n, keys,
+        use.Get_ss_assemblage_ptr()));
+    worker->use.Set_exchange_ptr(
+        cvode_jacobian_copy(worker->Rxn_exchange_map, Rxn_exchange_map, n, keys,
+                            use.Get_exchange_ptr()));
+    worker->use.Set_surface_ptr(
+        cvode_jacobian_copy(worker->Rxn_surface_map, Rxn_surface_map, n, keys,
+                            use.Get_surface_ptr()));
+    worker->use.Set_gas_phase_ptr(
+        cvode_jacobian_copy(worker->Rxn_gas_phase_map, Rxn_gas_phase_map,
+                            n, keys, use.Get_gas_phase_ptr()));
+    worker->use.Set_kinetics_ptr(
+        cvode_jacobian_copy(worker->Rxn_kinetics_map, Rxn_kinetics_map, n, keys,
+                            use.Get_kinetics_ptr()));
+    worker->use.Set_reaction_ptr(
+        cvode_jacobian_copy(worker->Rxn_reaction_map, Rxn_reaction_map, n, keys,
+                            use.Get_reaction_ptr()));
+    worker->use.Set_temperature_ptr(
+        cvode_jacobian_copy(worker->Rxn_temperature_map, Rxn_temperature_map,
+                            n, keys, use.Get_temperature_ptr()));
+    worker->use.Set_pressure_ptr(
+        cvode_jacobian_copy(worker->Rxn_pressure_map, Rxn_pressure_map, n, keys,
+                            use.Get_pressure_ptr()));
+    worker->use.Set_mix_ptr(NULL);
+    worker->use.Set_inverse_ptr(NULL);
+    worker->cvode_kinetics_ptr = Utilities::Rxn_find(
+        worker->Rxn_kinetics_map,
+        ((cxxKinetics *)cvode_kinetics_ptr)->Get_n_user());
+    worker->cvode_save_assemblages(cvode_pp_assemblage_save,
+                                   cvode_ss_assemblage_save);
+    if (cell >= 0 && (size_t)cell < cell_data.size()) {
+      worker->cell_data.resize(cell_data.size());
+      worker->cell_data[cell] = cell_data[cell];
+    }
+  } else {
+    std::map<int, cxxSSassemblage>::const_iterator it =
+        Rxn_ss_assemblage_map.find(n);
+    if (it != Rxn_ss_assemblage_map.end()) {
+      worker->Rxn_ss_assemblage_map[n] = it->second;
+    }
+  }
+
+  worker->state = state;
+  worker->cell = cell;
+  worker->cell_no = cell_no;
+  worker->transport_step = transport_step;
+  /* step() relaxes the temperature of a transport cell */
+  worker->count_cells = count_cells;
+  worker->tempr = tempr;
+  worker->reaction_step = reaction_step;
+  worker->count_total_steps = count_total_steps;
+  worker->incremental_reactions = incremental_reactions;
+  worker->initial_total_time = initial_total_time;
+  worker->kin_time_x = kin_time_x;
+  worker->rate_kin_time = rate_kin_time;
+  worker->rate_sim_time_start = rate_sim_time_start;
+  worker->rate_sim_time_end = rate_sim_time_end;
+  worker->rate_sim_time = cvode_rate_sim_time;
+  worker->save_values = save_values;
+  worker->m_original = m_original;
+  worker->m_temp = m_temp;
+  worker->cvode_n_user = cvode_n_user;
+  worker->cvode_n_reactions = cvode_n_reactions;
+  worker->cvode_step_fraction = cvode_step_fraction;
+  worker->cvode_rate_sim_time = cvode_rate_sim_time;
+  worker->run_reactions_iterations = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+void Phreeqc::cvode_jacobian_free(void)
+/* ---------------------------------------------------------------------- */
+{
+  delete cvode_jacobian_threads_pool;
+  cvode_jacobian_threads_pool = NULL;
+  for (size_t i = 0; i < cvode_jacobian_workers.size(); i++) {
+    delete cvode_jacobian_workers[i];
+  }
+  cvode_jacobian_workers.clear();
+  cvode_jacobian_synced = 0;
+  cvode_jacobian_saved.clear();
+  cvode_jacobian_saved_rates.clear();
+  cvode_jacobian_saved_names.clear();
+}
+
+/* ---------------------------------------------------------------------- */
+cvode_jacobian_pool::cvode_jacobian_pool(size_t count)
+    : task(NULL), round(0), pending(0), stop(false)
+/* ---------------------------------------------------------------------- */
+{
+  for (size_t w = 0; w < count; w++) {
+    threads.emplace_back(&cvode_jacobian_pool::loop, this, w);
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+cvode_jacobian_pool::~cvode_jacobian_pool()
+/* ---------------------------------------------------------------------- */
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  start.notify_all();
+  for (size_t w = 0; w < threads.size(); w++) {
+    threads[w].join();
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+void cvode_jacobian_pool::run(const std::function<void(size_t)> &task)
+/* ---------------------------------------------------------------------- */
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->task = &task;
+    pending = threads.size();
+    round++;
+  }
+  start.notify_all();
+  try {
+    task(0);
+  } catch (...) {
+    /* the threads use the task until the round is done */
+    wait();
+    throw;
+  }
+  wait();
+}
+
+/* ---------------------------------------------------------------------- */
+void cvode_jacobian_pool::wait(void)
+/* ---------------------------------------------------------------------- */
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [this]() { return pending == 0; });
+  task = NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+void cvode_jacobian_pool::loop(size_t w)
+/* ---------------------------------------------------------------------- */
+{
+  size_t seen = 0;
+  for (;;) {
+    const std::function<void(size_t)> *current;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      start.wait(lock, [this, seen]() { return stop || round != seen; });
+      if (stop) {
+        return;
+      }
+      seen = round;
+      current = task;
+    }
+    try {
+      (*current)(w + 1);
+    } catch (...) {
+      /* the caller of run() calculates the columns not done again */
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--pending == 0) {
+      done.notify_one();
+    }
+  }
+}
+
 /* ---------------------------------------------------------------------- */
 int Phreeqc::set_advection(int i, int use_mix, int use_kinetics, int nsaver)
 /* ---------------------------------------------------------------------- */
@@ -2553,12 +3474,9 @@ void Phreeqc::Jac(integertype N, DenseMat J, RhsFn f, void *f_data, realtype t,
                   N_Vector y, N_Vector fy, N_Vector ewt, realtype h,
                   realtype uround, void *jac_data, long int *nfePtr,
                   N_Vector vtemp1, N_Vector vtemp2, N_Vector vtemp3) {
-  int count_cvode_errors;
   int n_reactions, n_user;
-  LDBLE del;
   std::vector<double> initial_rates;
   cxxKinetics *kinetics_ptr;
-  LDBLE step_fraction;
 
   Phreeqc *pThis = (Phreeqc *)f_data;
 
@@ -2566,7 +3484,6 @@ void Phreeqc::Jac(integertype N, DenseMat J, RhsFn f, void *f_data, realtype t,
   n_reactions = pThis->cvode_n_reactions;
   n_user = pThis->cvode_n_user;
   kinetics_ptr = (cxxKinetics *)pThis->cvode_kinetics_ptr;
-  step_fraction = pThis->cvode_step_fraction;
   pThis->rate_sim_time = pThis->cvode_rate_sim_time;
 
   initial_rates.resize(n_reactions);
@@ -2629,84 +3546,22 @@ void Phreeqc::Jac(integertype N, DenseMat J, RhsFn f, void *f_data, realtype t,
         &(kinetics_ptr->Get_kinetics_comps()[i]);
     initial_rates[i] = kinetics_comp_ptr->Get_moles();
   }
-  for (size_t i = 0; i < kinetics_ptr->Get_kinetics_comps().size(); i++) {
-    cxxKineticsComp *kinetics_comp_i_ptr =
-        &(kinetics_ptr->Get_kinetics_comps()[i]);
-    /* calculate reaction up to current time */
-    del = 1e-12;
-    pThis->cvode_error = TRUE;
-    count_cvode_errors = 0;
-    while (pThis->cvode_error == TRUE) {
-      del /= 10.;
-      for (size_t j = 0; j < kinetics_ptr->Get_kinetics_comps().size(); j++) {
-        cxxKineticsComp *kinetics_comp_j_ptr =
-            &(kinetics_ptr->Get_kinetics_comps()[j]);
-        /*
-           kinetics_ptr->comps[j].moles = y[j + 1];
-           kinetics_ptr->comps[j].m = m_original[j] - y[j + 1];
-         */
-        kinetics_comp_j_ptr->Set_moles(Ith(y, j + 1));
-        kinetics_comp_j_ptr->Set_m(pThis->m_original[j] - Ith(y, j + 1));
-        if (kinetics_comp_i_ptr->Get_m() < 0) {
-          /*
-             NOTE: y is not correct if it is greater than m_original
-             However, it seems to work to let y wander off, but use
-             .moles as the correct integral.
-             It does not work to reset Y to m_original, presumably
-             because the rational extrapolation gets screwed up.
-           */
-
-          /*
-             Ith(y,i + 1) = m_original[i];
-           */
-          kinetics_comp_i_ptr->Set_moles(pThis->m_original[i]);
-          kinetics_comp_i_ptr->Set_m(0.0);
-        }
-      }
-
-      /* Add small amount of ith reaction */
-      kinetics_comp_i_ptr->Set_m(kinetics_comp_i_ptr->Get_m() - del);
-      if (kinetics_comp_i_ptr->Get_m() < 0) {
-        kinetics_comp_i_ptr->Set_m(0);
-      }
-      kinetics_comp_i_ptr->Set_moles(kinetics_comp_i_ptr->Get_moles() + del);
-      pThis->calc_final_kinetic_reaction(kinetics_ptr);
-      if (pThis->use.Get_pp_assemblage_ptr() != NULL) {
-        pThis->Rxn_pp_assemblage_map[pThis->cvode_pp_assemblage_save
-                                         ->Get_n_user()] =
-            *pThis->cvode_pp_assemblage_save;
-        pThis->use.Set_pp_assemblage_ptr(
-            Utilities::Rxn_find(pThis->Rxn_pp_assemblage_map,
-                                pThis->cvode_pp_assemblage_save->Get_n_user()));
-      }
-      if (pThis->set_and_run_wrapper(n_user, FALSE, TRUE, n_user,
-                                     step_fraction) == MASS_BALANCE) {
-        count_cvode_errors++;
-        pThis->cvode_error = TRUE;
-        if (count_cvode_errors > 30) {
-          initial_rates.clear();
-          return;
-        }
-        pThis->run_reactions_iterations += pThis->iterations;
-        continue;
-      }
-      pThis->cvode_error = FALSE;
-      pThis->run_reactions_iterations += pThis->iterations;
-      /*kinetics_ptr->comps[i].moles -= del; */
-      for (size_t j = 0; j < kinetics_ptr->Get_kinetics_comps().size(); j++) {
-        cxxKineticsComp *kinetics_comp_ptr =
-            &(kinetics_ptr->Get_kinetics_comps()[j]);
-        kinetics_comp_ptr->Set_moles(0.0);
+  if (pThis->cvode_jacobian_threads > 1 || pThis->cvode_jacobian_reuse > 0) {
+    if (!pThis->cvode_jacobian_columns(J, y, initial_rates)) {
+      initial_rates.clear();
+      return;
+    }
+  } else {
+    std::vector<double> column(n_reactions);
+    pThis->cvode_jacobian_evaluations++;
+    for (size_t i = 0; i < kinetics_ptr->Get_kinetics_comps().size(); i++) {
+      if (pThis->cvode_jacobian_column(y, i, false, initial_rates, column) ==
+          ERROR) {
+        initial_rates.clear();
+        return;
       }
-      pThis->calc_kinetic_reaction(kinetics_ptr, 1.0);
-
-      /* calculate new rates for df/dy[i] */
-      /* dfdx[i + 1] = 0.0; */
       for (size_t j = 0; j < kinetics_ptr->Get_kinetics_comps().size(); j++) {
-        cxxKineticsComp *kinetics_comp_ptr =
-            &(kinetics_ptr->Get_kinetics_comps()[j]);
-        IJth(J, j + 1, i + 1) =
-            (kinetics_comp_ptr->Get_moles() - initial_rates[j]) / del;
+        IJth(J, j + 1, i + 1) = column[j];
       }
     }
   }
@@ -2735,6 +3590,8 @@ void Phreeqc::cvode_init(void) {
   kinetics_machEnv = NULL;
   kinetics_y = kinetics_abstol = NULL;
   kinetics_cvode_mem = NULL;
+  cvode_workspace_n = 0;
+  cvode_workspace_maxord = 0;
   cvode_pp_assemblage_save = NULL;
   cvode_ss_assemblage_save = NULL;
   return;
@@ -2787,14 +3644,9 @@ bool Phreeqc::cvode_update_reactants(int i, int nsaver, bool save_it) {
         Utilities::Rxn_find(Rxn_pp_assemblage_map, nsaver);
     cxxSSassemblage *ss_assemblage_ptr =
         Utilities::Rxn_find(Rxn_ss_assemblage_map, nsaver);
-    if (cvode_pp_assemblage_save != NULL) {
-      delete cvode_pp_assemblage_save;
-      cvode_pp_assemblage_save = new cxxPPassemblage(*pp_assemblage_ptr);
-    }
-    if (cvode_ss_assemblage_save != NULL) {
-      delete cvode_ss_assemblage_save;
-      cvode_ss_assemblage_save = new cxxSSassemblage(*ss_assemblage_ptr);
-    }
+    cvode_save_assemblages(
+        cvode_pp_assemblage_save != NULL ? pp_assemblage_ptr : NULL,
+        cvode_ss_assemblage_save != NULL ? ss_assemblage_ptr : NULL);
 
     for (int j = 0; j < n_reactions; j++) {
       Ith(cvode_last_good_y, j + 1) = 0.0;
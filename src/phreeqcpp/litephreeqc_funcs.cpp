@@ -12,6 +12,13 @@
  */
 
 #include "Phreeqc.h"
+#include "Pressure.h"
+#include "Reaction.h"
+#include "Solution.h"
+#include "Temperature.h"
+#include "cxxKinetics.h"
+#include "cxxMix.h"
+#include <algorithm>
 #include <set>
 
 const std::set<std::string> to_ignore = {
@@ -100,3 +107,108 @@ std::vector<std::string> Phreeqc::find_all_valence_states(
 
   return solution_with_valences;
 }
+
+/* ---------------------------------------------------------------------- */
+int Phreeqc::run_cell_step(int i, LDBLE time_step)
+/* ---------------------------------------------------------------------- */
+{
+  /*
+   *   Equivalent of
+   *     RUN_CELLS
+   *      -cells i
+   *      -time_step time_step
+   *     END
+   *   without going through the input parser. Reactions are calculated by
+   *   set_advection and run_reactions directly, nothing is punched or printed.
+   *
+   *   Returns the number of input errors of this step. Fatal errors are
+   *   reported by error_msg(..., STOP), i.e. an exception is thrown, which
+   *   has to be handled by the caller.
+   */
+  LDBLE kin_time;
+  int count_steps;
+  int use_mix;
+
+  state = REACTION;
+  input_error = 0;
+
+  if (Utilities::Rxn_find(Rxn_solution_map, i) == NULL &&
+      Utilities::Rxn_find(Rxn_mix_map, i) == NULL) {
+    error_msg(sformatf("Solution %d not found.", i), STOP);
+  }
+
+  run_info.Set_run_cells(true);
+
+  const LDBLE initial_total_time_save = initial_total_time;
+  set_advection(i, TRUE, TRUE, i);
+
+  count_steps = 1;
+  if (!this->run_cells_one_step) {
+    if (use.Get_reaction_in() == TRUE && use.Get_reaction_ptr() != NULL) {
+      count_steps =
+          std::max(count_steps, use.Get_reaction_ptr()->Get_reaction_steps());
+    }
+    if (use.Get_kinetics_in() == TRUE && use.Get_kinetics_ptr() != NULL) {
+      count_steps =
+          std::max(count_steps, use.Get_kinetics_ptr()->Get_reaction_steps());
+    }
+    if (use.Get_temperature_in() == TRUE &&
+        use.Get_temperature_ptr() != NULL) {
+      count_steps =
+          std::max(count_steps, use.Get_temperature_ptr()->Get_countTemps());
+    }
+    if (use.Get_pressure_in() == TRUE && use.Get_pressure_ptr() != NULL) {
+      count_steps = std::max(count_steps, use.Get_pressure_ptr()->Get_count());
+    }
+  }
+  count_total_steps = count_steps;
+
+  class save save_data = save;
+
+  copy_use(-2);
+  rate_sim_time_start = 0;
+  rate_sim_time = 0;
+  for (reaction_step = 1; reaction_step <= count_steps; reaction_step++) {
+    if (reaction_step > 1 && incremental_reactions == FALSE) {
+      copy_use(-2);
+    }
+    set_initial_moles(-2);
+
+    kin_time = 0.0;
+    if (use.Get_kinetics_in() == TRUE) {
+      if (incremental_reactions == FALSE) {
+        kin_time = reaction_step * time_step / ((LDBLE)count_steps);
+      } else {
+        kin_time = time_step / ((LDBLE)count_steps);
+      }
+    }
+
+    use_mix = (incremental_reactions == FALSE || reaction_step == 1) ? TRUE
+                                                                      : FALSE;
+
+    run_reactions(-2, kin_time, use_mix, 1.0);
+    if (incremental_reactions == TRUE) {
+      rate_sim_time_start += kin_time;
+      rate_sim_time = rate_sim_time_start;
+    } else {
+      rate_sim_time = kin_time;
+    }
+
+    /* saves back into -2 */
+    if (reaction_step < count_steps) {
+      saver();
+    }
+  }
+
+  /* save end of reaction */
+  save = save_data;
+  if (use.Get_kinetics_in() == TRUE) {
+    Utilities::Rxn_copy(Rxn_kinetics_map, -2, use.Get_n_kinetics_user());
+  }
+  saver();
+
+  initial_total_time = initial_total_time_save + rate_sim_time;
+  run_info.Set_run_cells(false);
+
+  return (input_error);
+}
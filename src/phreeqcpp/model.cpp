@@ -8,6 +8,11 @@
 #include "SSassemblage.h"
 #include "Solution.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+
 #if defined(PHREEQCI_GUI)
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -16,6 +21,87 @@ static char THIS_FILE[] = __FILE__;
 #endif
 #endif
 
+/*
+ *   Activity-coefficient kernels for the groups of gammas_groups. They are
+ *   compiled for AVX2 and for the base instruction set and the loader picks
+ *   one at run time. Neither contracts to FMA, so both give the same
+ *   results as the expressions for single species in gammas.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define GAMMAS_KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#define GAMMAS_KERNEL
+#endif
+
+GAMMAS_KERNEL static void
+gammas_uncharged(size_t n, const LDBLE *dhb, const LDBLE *moles,
+				 LDBLE mu, LDBLE log_10, LDBLE *lg, LDBLE *dg)
+{
+	for (size_t k = 0; k < n; k++)
+	{
+		lg[k] = dhb[k] * mu;
+		dg[k] = dhb[k] * log_10 * moles[k];
+	}
+}
+
+GAMMAS_KERNEL static void
+gammas_davies(size_t n, const LDBLE *z, const LDBLE *moles, LDBLE a,
+			  LDBLE c1, LDBLE davies, LDBLE *lg, LDBLE *dg)
+{
+	for (size_t k = 0; k < n; k++)
+	{
+		lg[k] = -z[k] * z[k] * a * davies;
+		dg[k] = c1 * z[k] * z[k] * moles[k];
+	}
+}
+
+GAMMAS_KERNEL static void
+gammas_wateq_dh(size_t n, const LDBLE *z, const LDBLE *dha,
+				const LDBLE *dhb, const LDBLE *moles, LDBLE a_muhalf,
+				LDBLE b, LDBLE muhalf, LDBLE mu, LDBLE c2, LDBLE log_10,
+				LDBLE *lg, LDBLE *dg)
+{
+	for (size_t k = 0; k < n; k++)
+	{
+		LDBLE d = 1.0 + dha[k] * b * muhalf;
+		lg[k] = a_muhalf * z[k] * z[k] / d + dhb[k] * mu;
+		dg[k] = (c2 * z[k] * z[k] / (d * d) + dhb[k]) * log_10 * moles[k];
+	}
+}
+
+GAMMAS_KERNEL static void
+gammas_llnl_dh(size_t n, const LDBLE *z, const LDBLE *dha,
+			   const LDBLE *moles, LDBLE a_muhalf, LDBLE b, LDBLE muhalf,
+			   LDBLE mu, LDBLE c2, LDBLE bdot, LDBLE log_10,
+			   LDBLE *lg, LDBLE *dg)
+{
+	for (size_t k = 0; k < n; k++)
+	{
+		LDBLE d = 1.0 + dha[k] * b * muhalf;
+		lg[k] = a_muhalf * z[k] * z[k] / d + bdot * mu;
+		dg[k] = (c2 * z[k] * z[k] / (d * d) + bdot) * log_10 * moles[k];
+	}
+}
+
+static void
+gamma_group_gather(class gamma_group &group)
+{
+	for (size_t k = 0; k < group.species.size(); k++)
+	{
+		group.moles[k] = group.species[k]->moles;
+	}
+}
+
+static void
+gamma_group_scatter(class gamma_group &group)
+{
+	for (size_t k = 0; k < group.species.size(); k++)
+	{
+		group.species[k]->lg = group.lg[k];
+		group.species[k]->dg = group.dg[k];
+	}
+}
+
 /* ---------------------------------------------------------------------- */
 int Phreeqc::
 model(void)
@@ -643,10 +729,55 @@ gammas(LDBLE mu)
 	}
 
 /*
- *   Calculate activity coefficients
+ *   Calculate activity coefficients, the Debye-Hueckel groups of
+ *   gammas_groups first, then all other species one by one
  */
-	for (i = 0; i < (int)this->s_x.size(); i++)
+	int count_s = (int)this->s_x.size();
+	const int *s_index = NULL;
+	if (vectorized_gammas == TRUE)
 	{
+		if (species_kernel_stale)
+		{
+			compile_species_kernel();
+		}
+		class gamma_group &g0 = gammas_groups.uncharged;
+		gamma_group_gather(g0);
+		gammas_uncharged(g0.species.size(), g0.dhb.data(), g0.moles.data(),
+			mu, LOG_10, g0.lg.data(), g0.dg.data());
+		gamma_group_scatter(g0);
+
+		class gamma_group &g1 = gammas_groups.davies;
+		gamma_group_gather(g1);
+		gammas_davies(g1.species.size(), g1.z.data(), g1.moles.data(), a, c1,
+			muhalf / (1.0 + muhalf) - 0.3 * mu, g1.lg.data(), g1.dg.data());
+		gamma_group_scatter(g1);
+
+		class gamma_group &g2 = gammas_groups.wateq_dh;
+		gamma_group_gather(g2);
+		gammas_wateq_dh(g2.species.size(), g2.z.data(), g2.dha.data(),
+			g2.dhb.data(), g2.moles.data(), -a * muhalf, b, muhalf, mu, c2,
+			LOG_10, g2.lg.data(), g2.dg.data());
+		gamma_group_scatter(g2);
+
+		class gamma_group &g7 = gammas_groups.llnl_dh;
+		if (g7.species.size() > 0)
+		{
+			if (llnl_temp.size() == 0)
+			{
+				error_msg("LLNL_AQUEOUS_MODEL_PARAMETERS not defined.", STOP);
+			}
+			gamma_group_gather(g7);
+			gammas_llnl_dh(g7.species.size(), g7.z.data(), g7.dha.data(),
+				g7.moles.data(), -a_llnl * muhalf, b_llnl, muhalf, mu, c2_llnl,
+				bdot_llnl, LOG_10, g7.lg.data(), g7.dg.data());
+			gamma_group_scatter(g7);
+		}
+		count_s = (int)gammas_groups.others.size();
+		s_index = gammas_groups.others.data();
+	}
+	for (int k = 0; k < count_s; k++)
+	{
+		i = (s_index != NULL ? s_index[k] : k);
 		switch (s_x[i]->gflag)
 		{
 		case 0:				/* uncharged */
@@ -1117,17 +1248,12 @@ ineq(int in_kode)
 	}
 
 /*
- *   Allocate arrays for inequality solver
+ *   Arrays for inequality solver are kept between iterations
  */
 	max_row_count = 2 * count_unknowns + 2;
 	max_column_count = count_unknowns + 2;
-	ineq_array.resize(max_row_count * max_column_count);
-	back_eq.resize(max_row_count);
-	zero.resize(max_row_count);
-	memset(&zero[0], 0, max_row_count * sizeof(double));
-	res.resize(max_row_count);
+	ineq_space();
 	memset(&res[0], 0, max_row_count * sizeof(double));
-	delta1.resize(max_column_count);
 	memset(&delta1[0], 0,max_column_count * sizeof(double));
 /*
  *   Copy equations to optimize into ineq_array
@@ -1710,14 +1836,8 @@ ineq(int in_kode)
 		n = (int)count_unknowns - (int)s_list.size();
 		for (int i = 0; i < l_count_rows; i++)
 		{
-			for (int j = 0; j < n; j++)
-			{
-				ineq_array[(size_t)i*((size_t)n+2) + (size_t)j] = ineq_array[(size_t)i*(count_unknowns+2) + (size_t)j];
-			}
-			//if (i > 0)
-			//{
-			//	memcpy((void *) &ineq_array[i*(n+2)], (void *) &ineq_array[i*(count_unknowns+2)], (size_t) (n) * sizeof(LDBLE));
-			//}
+			/* rows only move towards the front, source and target may overlap */
+			memmove((void *) &ineq_array[(size_t)i*((size_t)n+2)], (void *) &ineq_array[(size_t)i*(count_unknowns+2)], (size_t) (n) * sizeof(LDBLE));
 			ineq_array[(size_t)i*((size_t)n+2) + (size_t)n] = ineq_array[(size_t)i*(count_unknowns+2) + count_unknowns];
 		}
 	}
@@ -1742,12 +1862,6 @@ ineq(int in_kode)
 		l_kode = 1;
 	}
 	l_iter = 2*(n + l_count_rows);
-/*
- *   Allocate space for arrays
- */
-	cu.resize(2 * (size_t)l_nklmd);
-	iu.resize(2 * (size_t)l_nklmd);
-	is.resize(l_klmd);
 
 #ifdef SLNQ
 	slnq_array =
@@ -1771,11 +1885,25 @@ ineq(int in_kode)
 		   (size_t) max_column_count * sizeof(LDBLE));
 #endif
 /*
- *   Call CL1
+ *   Without rows to optimize and without inequalities, the step is the
+ *   solution of a square system of equalities, try LU decomposition first.
+ *   Otherwise call CL1
  */
-	cl1(k, l, m, n, l_nklmd, l_n2d, &ineq_array[0],
-		&l_kode, ineq_tol, &l_iter, &delta1[0], &res[0],
-		&l_error, &cu[0], &iu[0], &is[0], FALSE);
+	if (dense_linear_solver == TRUE && k == 0 && m == 0 &&
+		ineq_dense(l, n, l_n2d) == OK)
+	{
+		l_kode = 0;
+		l_iter = 0;
+		l_error = 0.0;
+		count_ineq_dense++;
+	}
+	else
+	{
+		cl1(k, l, m, n, l_nklmd, l_n2d, &ineq_array[0],
+			&l_kode, ineq_tol, &l_iter, &delta1[0], &res[0],
+			&l_error, &cu[0], &iu[0], &is[0], FALSE);
+		count_ineq_cl1++;
+	}
 /*   Set return_kode */
 	if (l_kode == 1)
 	{
@@ -1919,16 +2047,337 @@ ineq(int in_kode)
 	return (return_code);
 }
 
+/* ---------------------------------------------------------------------- */
+int Phreeqc::
+ineq_dense(int rows, int n, int n2d)
+/* ---------------------------------------------------------------------- */
+{
+/*
+ *   Solves the equality rows of ineq_array for delta1 by LU decomposition.
+ *   Columns without any coefficient (phases not in the model, zeroed
+ *   unknowns) keep a zero step, rows without coefficients and right hand
+ *   side are dropped. Returns ERROR, leaving ineq_array untouched, if the
+ *   remaining system is not square, has sign constraints or a pivot is
+ *   small relative to the largest coefficient of its column; the caller
+ *   then uses cl1.
+ */
+	int i, j, count_rows, count_columns;
+	LDBLE *row, pivot_tol;
+
+	dense_rows.clear();
+	dense_columns.clear();
+	for (j = 0; j < n; j++)
+	{
+		for (i = 0; i < rows; i++)
+		{
+			if (ineq_array[(size_t)i * n2d + (size_t)j] != 0.0)
+				break;
+		}
+		if (i < rows)
+		{
+			if (delta1[j] != 0.0)
+				return (ERROR);
+			dense_columns.push_back(j);
+		}
+	}
+	for (i = 0; i < rows; i++)
+	{
+		row = &ineq_array[(size_t)i * n2d];
+		for (j = 0; j <= n; j++)
+		{
+			if (row[j] != 0.0)
+				break;
+		}
+		if (j <= n)
+		{
+			/* no coefficients but a right hand side, infeasible */
+			if (j == n)
+				return (ERROR);
+			dense_rows.push_back(i);
+		}
+	}
+	count_rows = (int)dense_rows.size();
+	count_columns = (int)dense_columns.size();
+	if (count_rows != count_columns || count_rows == 0)
+		return (ERROR);
+/*
+ *   gefa works on column major storage, the last column holds the right
+ *   hand side and the solution
+ */
+	dense_lu.resize((size_t)count_columns * ((size_t)count_columns + 1));
+	dense_lu_columns.resize((size_t)count_columns + 1);
+	dense_pivots.resize(count_columns);
+	dense_column_norms.assign(count_columns, 0.0);
+	for (j = 0; j <= count_columns; j++)
+	{
+		dense_lu_columns[j] = &dense_lu[(size_t)j * count_columns];
+	}
+	for (i = 0; i < count_rows; i++)
+	{
+		row = &ineq_array[(size_t)dense_rows[i] * n2d];
+		for (j = 0; j < count_columns; j++)
+		{
+			dense_lu_columns[j][i] = row[dense_columns[j]];
+			if (fabs(row[dense_columns[j]]) > dense_column_norms[j])
+				dense_column_norms[j] = fabs(row[dense_columns[j]]);
+		}
+		dense_lu_columns[count_columns][i] = row[n];
+	}
+	if (gefa(&dense_lu_columns[0], count_columns, &dense_pivots[0]) != 0)
+		return (ERROR);
+/*
+ *   Rounding leaves the pivots of a singular matrix at about
+ *   count_columns * DBL_EPSILON times the largest coefficient of the
+ *   column, the tolerance is relative to that and never below it
+ */
+	pivot_tol = count_columns * DBL_EPSILON;
+	if (pivot_tol < ineq_tol)
+		pivot_tol = ineq_tol;
+	for (j = 0; j < count_columns; j++)
+	{
+		if (fabs(dense_lu_columns[j][j]) <= pivot_tol * dense_column_norms[j])
+			return (ERROR);
+	}
+	gesl(&dense_lu_columns[0], count_columns, &dense_pivots[0],
+		dense_lu_columns[count_columns]);
+	for (j = 0; j < count_columns; j++)
+	{
+		if (!std::isfinite(dense_lu_columns[count_columns][j]))
+			return (ERROR);
+	}
+	for (j = 0; j < count_columns; j++)
+	{
+		delta1[dense_columns[j]] = dense_lu_columns[count_columns][j];
+	}
+	return (OK);
+}
+
+/* ---------------------------------------------------------------------- */
+void Phreeqc::
+ineq_space(void)
+/* ---------------------------------------------------------------------- */
+{
+/*
+ *   Sizes the work arrays of ineq and cl1 for the current number of
+ *   unknowns. The arrays are reused for all iterations of a model and
+ *   are only reallocated when count_unknowns changes.
+ */
+	size_t rows, columns, klmd, nklmd;
+
+	if (ineq_space_unknowns == count_unknowns && ineq_array.size() > 0)
+		return;
+	rows = 2 * count_unknowns + 2;
+	columns = count_unknowns + 2;
+	klmd = rows - 2;
+	nklmd = count_unknowns + klmd;
+
+	ineq_array.resize(rows * columns);
+	back_eq.resize(rows);
+	zero.assign(rows, 0.0);
+	res.resize(rows);
+	delta1.resize(columns);
+	cu.resize(2 * nklmd);
+	iu.resize(2 * nklmd);
+	is.resize(klmd);
+	ineq_space_unknowns = count_unknowns;
+}
+
+/* ---------------------------------------------------------------------- */
+int Phreeqc::
+compile_jacobian_sums(void)
+/* ---------------------------------------------------------------------- */
+{
+/*
+ *   Merges sum_jacob0, sum_jacob1, and sum_jacob2 into sum_jacob, a list
+ *   of terms source * coef for each target in ascending order of the
+ *   target. Constant terms use a source of 1.0. Terms of a target keep the
+ *   order of sum_jacob0, sum_jacob1, sum_jacob2, so sums are identical.
+ */
+	static const LDBLE one = 1.0;
+	class term
+	{
+	public:
+		size_t target;
+		const LDBLE *source;
+		LDBLE coef;
+	};
+	std::vector<term> terms;
+	terms.reserve(sum_jacob0.size() + sum_jacob1.size() + sum_jacob2.size());
+	LDBLE *base = my_array.data();
+	for (size_t k = 0; k < sum_jacob0.size(); k++)
+	{
+		terms.push_back({(size_t)(sum_jacob0[k].target - base), &one,
+			sum_jacob0[k].coef});
+	}
+	for (size_t k = 0; k < sum_jacob1.size(); k++)
+	{
+		terms.push_back({(size_t)(sum_jacob1[k].target - base),
+			sum_jacob1[k].source, 1.0});
+	}
+	for (size_t k = 0; k < sum_jacob2.size(); k++)
+	{
+		terms.push_back({(size_t)(sum_jacob2[k].target - base),
+			sum_jacob2[k].source, sum_jacob2[k].coef});
+	}
+	std::stable_sort(terms.begin(), terms.end(),
+		[](const term &a, const term &b) { return a.target < b.target; });
+
+	sum_jacob.targets.clear();
+	sum_jacob.first.clear();
+	sum_jacob.sources.resize(terms.size());
+	sum_jacob.coefs.resize(terms.size());
+	for (size_t k = 0; k < terms.size(); k++)
+	{
+		if (k == 0 || terms[k].target != terms[k - 1].target)
+		{
+			sum_jacob.targets.push_back(terms[k].target);
+			sum_jacob.first.push_back(k);
+		}
+		sum_jacob.sources[k] = terms[k].source;
+		sum_jacob.coefs[k] = terms[k].coef;
+	}
+	sum_jacob.first.push_back(terms.size());
+	sum_jacob_stale = false;
+	return (OK);
+}
+
+/* ---------------------------------------------------------------------- */
+int Phreeqc::
+compile_species_kernel(void)
+/* ---------------------------------------------------------------------- */
+{
+/*
+ *   Copies the species of s_x that get molalities and the terms of their
+ *   mass-action equations into s_x_kernel, groups s_x by activity model
+ *   into gammas_groups, and merges sum_mb1 and sum_mb2 into sum_mb, the
+ *   terms grouped by target. Terms keep their order, so sums are identical
+ *   to summing term by term.
+ */
+	int i;
+	class rxn_token *rxn_ptr;
+
+	s_x_kernel.species.clear();
+	s_x_kernel.types.clear();
+	s_x_kernel.first.clear();
+	s_x_kernel.la.clear();
+	s_x_kernel.coefs.clear();
+	for (i = 0; i < (int)s_x.size(); i++)
+	{
+		if (s_x[i]->type > HPLUS && s_x[i]->type != EX
+			&& s_x[i]->type != SURF)
+			continue;
+		s_x_kernel.species.push_back(s_x[i]);
+		s_x_kernel.types.push_back(s_x[i]->type);
+		s_x_kernel.first.push_back(s_x_kernel.la.size());
+		for (rxn_ptr = &s_x[i]->rxn_x.token[0] + 1; rxn_ptr->s != NULL;
+			 rxn_ptr++)
+		{
+			s_x_kernel.la.push_back(&rxn_ptr->s->la);
+			s_x_kernel.coefs.push_back(rxn_ptr->coef);
+		}
+	}
+	s_x_kernel.first.push_back(s_x_kernel.la.size());
+
+	class gamma_group *groups[] = {&gammas_groups.uncharged,
+		&gammas_groups.davies, &gammas_groups.wateq_dh, &gammas_groups.llnl_dh};
+	for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); g++)
+	{
+		groups[g]->species.clear();
+		groups[g]->z.clear();
+		groups[g]->dha.clear();
+		groups[g]->dhb.clear();
+	}
+	gammas_groups.others.clear();
+	for (i = 0; i < (int)s_x.size(); i++)
+	{
+		class gamma_group *group = NULL;
+		switch (s_x[i]->gflag)
+		{
+		case 0:
+			group = &gammas_groups.uncharged;
+			break;
+		case 1:
+			group = &gammas_groups.davies;
+			break;
+		case 2:
+			group = &gammas_groups.wateq_dh;
+			break;
+		case 7:
+			if (s_x[i]->z != 0)
+				group = &gammas_groups.llnl_dh;
+			break;
+		}
+		if (group == NULL)
+		{
+			gammas_groups.others.push_back(i);
+			continue;
+		}
+		group->species.push_back(s_x[i]);
+		group->z.push_back(s_x[i]->z);
+		group->dha.push_back(s_x[i]->dha);
+		group->dhb.push_back(s_x[i]->dhb);
+	}
+	for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); g++)
+	{
+		groups[g]->moles.resize(groups[g]->species.size());
+		groups[g]->lg.resize(groups[g]->species.size());
+		groups[g]->dg.resize(groups[g]->species.size());
+	}
+
+	static const LDBLE one = 1.0;
+	class term
+	{
+	public:
+		LDBLE *target;
+		const LDBLE *source;
+		LDBLE coef;
+	};
+	std::vector<term> terms;
+	terms.reserve(sum_mb1.size() + sum_mb2.size());
+	for (size_t k = 0; k < sum_mb1.size(); k++)
+	{
+		terms.push_back({sum_mb1[k].target, sum_mb1[k].source, one});
+	}
+	for (size_t k = 0; k < sum_mb2.size(); k++)
+	{
+		terms.push_back({sum_mb2[k].target, sum_mb2[k].source,
+			sum_mb2[k].coef});
+	}
+	std::stable_sort(terms.begin(), terms.end(),
+		[](const term &a, const term &b)
+		{
+			return std::less<LDBLE *>()(a.target, b.target);
+		});
+
+	sum_mb.targets.clear();
+	sum_mb.first.clear();
+	sum_mb.sources.resize(terms.size());
+	sum_mb.coefs.resize(terms.size());
+	for (size_t k = 0; k < terms.size(); k++)
+	{
+		if (k == 0 || terms[k].target != terms[k - 1].target)
+		{
+			sum_mb.targets.push_back(terms[k].target);
+			sum_mb.first.push_back(k);
+		}
+		sum_mb.sources[k] = terms[k].source;
+		sum_mb.coefs[k] = terms[k].coef;
+	}
+	sum_mb.first.push_back(terms.size());
+	species_kernel_stale = false;
+	return (OK);
+}
+
 /* ---------------------------------------------------------------------- */
 int Phreeqc::
 jacobian_sums(void)
 /* ---------------------------------------------------------------------- */
 {
 /*
- *   Fills in jacobian array, uses arrays sum_jacob0, sum_jacob1, and
- *   sum_jacob2.
+ *   Fills in jacobian array, uses sum_jacob compiled from arrays
+ *   sum_jacob0, sum_jacob1, and sum_jacob2.
  */
-	int i, j, k;
+	int i, j;
 	LDBLE sinh_constant;
 /*
  *   Clear array, note residuals are in array[i, count_unknowns+1]
@@ -1943,25 +2392,28 @@ jacobian_sums(void)
 			   (void *) &(my_array[0]), (size_t) count_unknowns * sizeof(LDBLE));
 	}
 /*
- *   Add constant terms
+ *   Add constant terms, terms with coefficients of 1.0 and != 1.0,
+ *   each element of the array is written once
  */
-	for (k = 0; k < (int)sum_jacob0.size(); k++)
+	if (sum_jacob_stale)
 	{
-		*sum_jacob0[k].target += sum_jacob0[k].coef;
+		compile_jacobian_sums();
 	}
-/*
- *   Add terms with coefficients of 1.0
- */
-	for (k = 0; k < (int)sum_jacob1.size(); k++)
 	{
-		*sum_jacob1[k].target += *sum_jacob1[k].source;
-	}
-/*
- *   Add terms with coefficients != 1.0
- */
-	for (k = 0; k < (int)sum_jacob2.size(); k++)
-	{
-		*sum_jacob2[k].target += *sum_jacob2[k].source * sum_jacob2[k].coef;
+		const size_t *targets = sum_jacob.targets.data();
+		const size_t *first = sum_jacob.first.data();
+		const LDBLE * const *sources = sum_jacob.sources.data();
+		const LDBLE *coefs = sum_jacob.coefs.data();
+		LDBLE *a = my_array.data();
+		for (size_t t = 0; t < sum_jacob.targets.size(); t++)
+		{
+			LDBLE sum = a[targets[t]];
+			for (size_t k = first[t]; k < first[t + 1]; k++)
+			{
+				sum += *sources[k] * coefs[k];
+			}
+			a[targets[t]] = sum;
+		}
 	}
 /*
  *   Make final adjustments to jacobian array
@@ -2119,18 +2571,27 @@ mb_sums(void)
 		x[k]->sum = 0.0;
 	}
 /*
- *   Add terms with coefficients of 1.0
+ *   Add terms of sum_mb1 and sum_mb2, each target is written once
  */
-	for (k = 0; k < (int)sum_mb1.size(); k++)
+	if (species_kernel_stale)
 	{
-		*sum_mb1[k].target += *sum_mb1[k].source;
+		compile_species_kernel();
 	}
-/*
- *   Add terms with coefficients != 1.0
- */
-	for (k = 0; k < (int)sum_mb2.size(); k++)
 	{
-		*sum_mb2[k].target += *sum_mb2[k].source * sum_mb2[k].coef;
+		LDBLE * const *targets = sum_mb.targets.data();
+		const size_t *first = sum_mb.first.data();
+		const LDBLE * const *sources = sum_mb.sources.data();
+		const LDBLE *coefs = sum_mb.coefs.data();
+		size_t count_targets = sum_mb.targets.size();
+		for (size_t t = 0; t < count_targets; t++)
+		{
+			LDBLE sum = *targets[t];
+			for (size_t j = first[t]; j < first[t + 1]; j++)
+			{
+				sum += *sources[j] * coefs[j];
+			}
+			*targets[t] = sum;
+		}
 	}
 	return (OK);
 }
@@ -2339,7 +2800,6 @@ molalities(int allow_overflow)
  */
 	int i, j;
 	LDBLE total_g;
-	class rxn_token *rxn_ptr;
 /*
  *   la for master species
  */
@@ -2361,52 +2821,50 @@ molalities(int allow_overflow)
 		s_h2o->tot_g_moles = s_h2o->moles;
 		s_h2o->tot_dh2o_moles = 0.0;
 	}
-	for (i = 0; i < (int)this->s_x.size(); i++)
+	if (species_kernel_stale)
+	{
+		compile_species_kernel();
+	}
 	{
-		if (s_x[i]->type > HPLUS && s_x[i]->type != EX
-			&& s_x[i]->type != SURF)
-			continue;
 /*
- *   lm and moles for all aqueous species
+ *   lm and moles for all aqueous species, uses s_x_kernel compiled from
+ *   s_x and the mass-action equations rxn_x
  */
-		s_x[i]->lm = s_x[i]->lk - s_x[i]->lg;
-		for (rxn_ptr = &s_x[i]->rxn_x.token[0] + 1; rxn_ptr->s != NULL;
-			 rxn_ptr++)
+		class species * const *species = s_x_kernel.species.data();
+		const int *types = s_x_kernel.types.data();
+		const size_t *first = s_x_kernel.first.data();
+		const LDBLE * const *la = s_x_kernel.la.data();
+		const LDBLE *coefs = s_x_kernel.coefs.data();
+		size_t count_species = s_x_kernel.species.size();
+		for (size_t k = 0; k < count_species; k++)
 		{
-			s_x[i]->lm += rxn_ptr->s->la * rxn_ptr->coef;
-			/*
-			if (isnan(rxn_ptr->s->la))
+			class species *s_ptr = species[k];
+			LDBLE lm = s_ptr->lk - s_ptr->lg;
+			for (size_t j = first[k]; j < first[k + 1]; j++)
 			{
-				fprintf(stderr,"molalities la %s %e\n", rxn_ptr->s->name, rxn_ptr->s->la);
+				lm += *la[j] * coefs[j];
 			}
-			*/
-		}
-		if (s_x[i]->type == EX)
-		{
-			s_x[i]->moles = Utilities::safe_exp(s_x[i]->lm * LOG_10);
-
-		}
-		else if (s_x[i]->type == SURF)
-		{
-			s_x[i]->moles = Utilities::safe_exp(s_x[i]->lm * LOG_10);
-
-		}
-		else
-		{
-			s_x[i]->moles = under(s_x[i]->lm) * mass_water_aq_x;
-			if (s_x[i]->moles / mass_water_aq_x > 100)
+			s_ptr->lm = lm;
+			if (types[k] == EX || types[k] == SURF)
 			{
-				log_msg(sformatf( "Overflow: %s\t%e\t%e\t%d\n",
-						   s_x[i]->name,
-						   (double) (s_x[i]->moles / mass_water_aq_x),
-						   (double) s_x[i]->lm, iterations));
-
-				if (iterations >= 0 && allow_overflow == FALSE)
+				s_ptr->moles = Utilities::safe_exp(lm * LOG_10);
+			}
+			else
+			{
+				s_ptr->moles = under(lm) * mass_water_aq_x;
+				if (s_ptr->moles / mass_water_aq_x > 100)
 				{
-					return (ERROR);
+					log_msg(sformatf( "Overflow: %s\t%e\t%e\t%d\n",
+							   s_ptr->name,
+							   (double) (s_ptr->moles / mass_water_aq_x),
+							   (double) lm, iterations));
+
+					if (iterations >= 0 && allow_overflow == FALSE)
+					{
+						return (ERROR);
+					}
 				}
 			}
-
 		}
 	}
 /*
@@ -5166,6 +5624,9 @@ free_model_allocs(void)
 	sum_jacob0.clear();
 	sum_jacob1.clear();
 	sum_jacob2.clear();
+	sum_jacob_stale = true;
+	species_kernel_stale = true;
+	logk_model_stale = true;
 	sum_delta.clear();
 	return (OK);
 }
@@ -5568,6 +6029,53 @@ numerical_jacobian(void)
 		return(OK);
 
 	//jacobian_sums();
+	/*
+	 *   Without numerical_deriv, jacobian_sums has filled my_array.
+	 *   Its columns for la's that do not enter the mass-action equations
+	 *   of surface species are kept, in log10 units like the perturbed
+	 *   columns; the d-plane rows of CD_MUSIC are set by
+	 *   jacobian_cd_music_ddl. Only the other columns are perturbed.
+	 *   All columns are perturbed with Pitzer, SIT or a diffuse layer.
+	 */
+	std::vector<bool> perturb(count_unknowns, true);
+	if (numerical_deriv == FALSE && pitzer_model == FALSE && sit_model == FALSE &&
+		(use.Get_surface_ptr() == NULL || dl_type_x == cxxSurface::NO_DL))
+	{
+		std::vector<class species *> surface_s;
+		for (i = 0; i < (int)s_x.size(); i++)
+		{
+			if (s_x[i]->type != SURF)
+				continue;
+			for (class rxn_token *rxn_ptr = &s_x[i]->rxn_x.token[0] + 1;
+				rxn_ptr->s != NULL; rxn_ptr++)
+			{
+				surface_s.push_back(rxn_ptr->s);
+			}
+		}
+		for (i = 0; i < count_unknowns; i++)
+		{
+			switch (x[i]->type)
+			{
+			case MB:
+			case ALK:
+			case CB:
+			case SOLUTION_PHASE_BOUNDARY:
+			case EXCH:
+				if (std::find(surface_s.begin(), surface_s.end(),
+					x[i]->master[0]->s) != surface_s.end())
+					break;
+				perturb[i] = false;
+				count_analytic_columns++;
+				for (j = 0; j < count_unknowns; j++)
+				{
+					my_array[(size_t)j * (count_unknowns + 1) + (size_t)i] *= LOG_10;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	}
 	if (use.Get_surface_ptr() != NULL)
 	{
 		base_surface = *use.Get_surface_ptr();
@@ -5613,6 +6121,8 @@ numerical_jacobian(void)
 	d2 = 0;
 	for (i = 0; i < count_unknowns; i++)
 	{
+		if (!perturb[i])
+			continue;
 		switch (x[i]->type)
 		{
 		case MB:
@@ -5788,6 +6298,10 @@ numerical_jacobian(void)
 	//mb_gases();
 	//mb_ss();
 	residuals();
+	if (use.Get_surface_ptr() != NULL && use.Get_surface_ptr()->Get_type() == cxxSurface::CD_MUSIC)
+	{
+		jacobian_cd_music_ddl(perturb);
+	}
 	//for (i = 0; i < count_unknowns; i++)
 	//{
 	//	//Debugging
@@ -5803,6 +6317,104 @@ numerical_jacobian(void)
 }
 #endif
 /* ---------------------------------------------------------------------- */
+int Phreeqc::
+jacobian_cd_music_ddl(const std::vector<bool> &perturb)
+/* ---------------------------------------------------------------------- */
+{
+/*
+ *   Sets the derivatives of the d-plane charge balance of CD_MUSIC
+ *   surfaces without diffuse layer, eqns A-6 and A-7, for the columns
+ *   that numerical_jacobian does not perturb. sigmaddl depends on the
+ *   molalities of all aqueous species, which jacobian_sums leaves out.
+ *   Derivatives are per log10 unit of la, as in numerical_jacobian.
+ */
+	int i, j, k;
+	LDBLE sinh_constant, negfpsirt, sum, sum1, m, z_term, ddl_term;
+	LDBLE sign, sign1, dsigmaddl;
+	class master *master_ptr2;
+	std::vector<LDBLE> dsum, dsum1;
+
+	if (dl_type_x != cxxSurface::NO_DL)
+		return (OK);
+	for (i = 0; i < count_unknowns; i++)
+	{
+		if (x[i]->type != SURFACE_CB2)
+			continue;
+		cxxSurfaceCharge *charge_ptr = use.Get_surface_ptr()->Find_charge(x[i]->surface_charge);
+		for (j = 0; j < count_unknowns; j++)
+		{
+			if (!perturb[j])
+				my_array[(size_t)i * (count_unknowns + 1) + (size_t)j] = 0.0;
+		}
+		if (charge_ptr->Get_grams() == 0)
+			continue;
+		sinh_constant =
+			sqrt(8 * eps_r * EPSILON_ZERO * (R_KJ_DEG_MOL * 1000) *
+				 tk_x * 1000);
+		master_ptr2 =
+			surface_get_psi_master(charge_ptr->Get_name().c_str(),
+								   SURF_PSI2);
+		negfpsirt = master_ptr2->s->la * LOG_10;
+		sum = 0;
+		sum1 = 0;
+		dsum.assign(count_unknowns, 0.0);
+		dsum1.assign(count_unknowns, 0.0);
+		for (k = 0; k < (int)this->s_x.size(); k++)
+		{
+			if (s_x[k]->type >= H2O)
+				continue;
+			m = under(s_x[k]->lm);
+			z_term = exp(s_x[k]->z * negfpsirt) - 1;
+			sum += m * z_term;
+			sum1 += m * s_x[k]->z;
+			/* d(m)/d(la) = m * LOG_10 * coef */
+			for (class rxn_token *rxn_ptr = &s_x[k]->rxn_x.token[0] + 1;
+				rxn_ptr->s != NULL; rxn_ptr++)
+			{
+				for (j = 0; j < count_unknowns; j++)
+				{
+					if (perturb[j] || x[j]->master[0]->s != rxn_ptr->s)
+						continue;
+					dsum[j] += m * LOG_10 * rxn_ptr->coef * z_term;
+					dsum1[j] += m * LOG_10 * rxn_ptr->coef * s_x[k]->z;
+				}
+			}
+		}
+		/* fictitious monovalent ion that balances charge, as in residuals */
+		if (sum1 >= 0)
+		{
+			ddl_term = exp(-negfpsirt) - 1;
+			sign1 = 1;
+		}
+		else
+		{
+			ddl_term = exp(negfpsirt) - 1;
+			sign1 = -1;
+		}
+		sum += fabs(sum1) * ddl_term;
+		sign = 1;
+		if (sum < 0)
+		{
+			sum = -sum;
+			sign = -1;
+		}
+		if (sum == 0)
+			continue;
+		/* sigmaddl = +-0.5 * sinh_constant * sqrt(sum) */
+		if (negfpsirt < 0)
+			sign = -sign;
+		for (j = 0; j < count_unknowns; j++)
+		{
+			if (perturb[j])
+				continue;
+			dsigmaddl = sign * 0.25 * sinh_constant / sqrt(sum) *
+				(dsum[j] + sign1 * dsum1[j] * ddl_term);
+			my_array[(size_t)i * (count_unknowns + 1) + (size_t)j] = -dsigmaddl;
+		}
+	}
+	return (OK);
+}
+/* ---------------------------------------------------------------------- */
 void Phreeqc::
 set_inert_moles(void)
 /* ---------------------------------------------------------------------- */
@@ -1305,20 +1305,28 @@ pitzer(void)
 			theta_params[i]->ethetap = ethetap;
 		}
 	}
+	/*
+	 *  G, GP and exp for each distinct alpha of the B1 and B2 terms
+	 */
+	for (size_t k = 0; k < pitz_alphas.size(); k++)
+	{
+		l_alpha = pitz_alphas[k];
+		pitz_alpha_g[k] = G(l_alpha * DI);
+		pitz_alpha_gp[k] = GP(l_alpha * DI);
+		pitz_alpha_exp[k] = exp(-l_alpha * DI);
+	}
 	/*
 	 *  Sums for F, LGAMMA, and OSMOT
 	 */
- 	for (size_t j = 0; j < param_list.size(); j++)
- 	{
- 		int i = param_list[j];
-		i0 = pitz_params[i]->ispec[0];
-		i1 = pitz_params[i]->ispec[1];
-		z0 = spec[i0]->z;
-		z1 = spec[i1]->z;
-		param = pitz_params[i]->p;
-		l_alpha = pitz_params[i]->alpha;
+	const class pitz_term *terms = pitz_terms.data();
+	for (size_t j = 0; j < pitz_terms.size(); j++)
+	{
+		const class pitz_term &term = terms[j];
+		i0 = term.i0;
+		i1 = term.i1;
+		param = pitz_params[term.param]->p;
 		F_var = 0;
-		switch (pitz_params[i]->type)
+		switch (term.type)
 		{
 		case TYPE_B0:
 			LGAMMA[i0] += M[i1] * 2.0 * param;
@@ -1326,31 +1334,20 @@ pitzer(void)
 			OSMOT += M[i0] * M[i1] * param;
 			break;
 		case TYPE_B1:
-			if (param != 0.0)
-			{
-				F_var = M[i0] * M[i1] * param * GP(l_alpha * DI) / I;
-				LGAMMA[i0] += M[i1] * 2.0 * param * G(l_alpha * DI);
-				LGAMMA[i1] += M[i0] * 2.0 * param * G(l_alpha * DI);
-				OSMOT += M[i0] * M[i1] * param * exp(-l_alpha * DI);
-			}
-			break;
 		case TYPE_B2:
 			if (param != 0.0)
 			{
-				F_var = M[i0] * M[i1] * param * GP(l_alpha * DI) / I;
-				LGAMMA[i0] += M[i1] * 2.0 * param * G(l_alpha * DI);
-				LGAMMA[i1] += M[i0] * 2.0 * param * G(l_alpha * DI);
-				OSMOT += M[i0] * M[i1] * param * exp(-l_alpha * DI);
+				F_var = M[i0] * M[i1] * param * pitz_alpha_gp[term.alpha] / I;
+				LGAMMA[i0] += M[i1] * 2.0 * param * pitz_alpha_g[term.alpha];
+				LGAMMA[i1] += M[i0] * 2.0 * param * pitz_alpha_g[term.alpha];
+				OSMOT += M[i0] * M[i1] * param * pitz_alpha_exp[term.alpha];
 			}
 			break;
 		case TYPE_C0:
-			CSUM +=
-				M[i0] * M[i1] * pitz_params[i]->p / (2.0 *
-													 sqrt(fabs(z0 * z1)));
-			LGAMMA[i0] += M[i1] * BIGZ * param / (2.0 * sqrt(fabs(z0 * z1)));
-			LGAMMA[i1] += M[i0] * BIGZ * param / (2.0 * sqrt(fabs(z0 * z1)));
-			OSMOT +=
-				M[i0] * M[i1] * BIGZ * param / (2.0 * sqrt(fabs(z0 * z1)));
+			CSUM += M[i0] * M[i1] * param / term.c0_div;
+			LGAMMA[i0] += M[i1] * BIGZ * param / term.c0_div;
+			LGAMMA[i1] += M[i0] * BIGZ * param / term.c0_div;
+			OSMOT += M[i0] * M[i1] * BIGZ * param / term.c0_div;
 			break;
 		case TYPE_THETA:
 			LGAMMA[i0] += 2.0 * M[i1] * (param /*+ ETHETA(z0, z1, I) */ );
@@ -1358,13 +1355,10 @@ pitzer(void)
 			OSMOT += M[i0] * M[i1] * param;
 			break;
 		case TYPE_ETHETA:
-			/*
-			   ETHETAS(z0, z1, I, &etheta, &ethetap);
-			 */
 			if (use_etheta == TRUE)
 			{
-				etheta = pitz_params[i]->thetas->etheta;
-				ethetap = pitz_params[i]->thetas->ethetap;
+				etheta = pitz_params[term.param]->thetas->etheta;
+				ethetap = pitz_params[term.param]->thetas->ethetap;
 				F_var = M[i0] * M[i1] * ethetap;
 				LGAMMA[i0] += 2.0 * M[i1] * etheta;
 				LGAMMA[i1] += 2.0 * M[i0] * etheta;
@@ -1372,7 +1366,9 @@ pitzer(void)
 			}
 			break;
 		case TYPE_PSI:
-			i2 = pitz_params[i]->ispec[2];
+		case TYPE_ZETA:
+		case TYPE_ETA:
+			i2 = term.i2;
 			if (IPRSNT[i2] == FALSE)
 				continue;
 			LGAMMA[i0] += M[i1] * M[i2] * param;
@@ -1381,37 +1377,19 @@ pitzer(void)
 			OSMOT += M[i0] * M[i1] * M[i2] * param;
 			break;
 		case TYPE_LAMBDA:
-			LGAMMA[i0] += M[i1] * param * pitz_params[i]->ln_coef[0];
-			LGAMMA[i1] += M[i0] * param * pitz_params[i]->ln_coef[1];
-			OSMOT += M[i0] * M[i1] * param * pitz_params[i]->os_coef;
-			break;
-		case TYPE_ZETA:
-			i2 = pitz_params[i]->ispec[2];
-			if (IPRSNT[i2] == FALSE)
-				continue;
-			LGAMMA[i0] += M[i1] * M[i2] * param;
-			LGAMMA[i1] += M[i0] * M[i2] * param;
-			LGAMMA[i2] += M[i0] * M[i1] * param;
-			OSMOT += M[i0] * M[i1] * M[i2] * param;
+			LGAMMA[i0] += M[i1] * param * term.ln_coef[0];
+			LGAMMA[i1] += M[i0] * param * term.ln_coef[1];
+			OSMOT += M[i0] * M[i1] * param * term.os_coef;
 			break;
 		case TYPE_MU:
-			i2 = pitz_params[i]->ispec[2];
+			i2 = term.i2;
 			if (IPRSNT[i2] == FALSE)
 				continue;
 
-			LGAMMA[i0] += M[i1] * M[i2] * param * pitz_params[i]->ln_coef[0];
-			LGAMMA[i1] += M[i0] * M[i2] * param * pitz_params[i]->ln_coef[1];
-			LGAMMA[i2] += M[i0] * M[i1] * param * pitz_params[i]->ln_coef[2];
-			OSMOT += M[i0] * M[i1] * M[i2] * param * pitz_params[i]->os_coef;
-			break;
-		case TYPE_ETA:
-			i2 = pitz_params[i]->ispec[2];
-			if (IPRSNT[i2] == FALSE)
-				continue;
-			LGAMMA[i0] += M[i1] * M[i2] * param;
-			LGAMMA[i1] += M[i0] * M[i2] * param;
-			LGAMMA[i2] += M[i0] * M[i1] * param;
-			OSMOT += M[i0] * M[i1] * M[i2] * param;
+			LGAMMA[i0] += M[i1] * M[i2] * param * term.ln_coef[0];
+			LGAMMA[i1] += M[i0] * M[i2] * param * term.ln_coef[1];
+			LGAMMA[i2] += M[i0] * M[i1] * param * term.ln_coef[2];
+			OSMOT += M[i0] * M[i1] * M[i2] * param * term.os_coef;
 			break;
 		case TYPE_ALPHAS:
 			break;
@@ -2706,4 +2684,43 @@ pitzer_make_lists(void)
 		}
 		param_list.push_back(i);
 	}
+/*
+ *   Copy the data of param_list that does not depend on temperature or
+ *   molalities into pitz_terms, collect the distinct alphas of B1 and B2
+ */
+	pitz_terms.resize(param_list.size());
+	pitz_alphas.clear();
+	for (size_t j = 0; j < param_list.size(); j++)
+	{
+		const class pitz_param *pz_ptr = pitz_params[param_list[j]];
+		class pitz_term &term = pitz_terms[j];
+		term.type = pz_ptr->type;
+		term.param = param_list[j];
+		term.i0 = pz_ptr->ispec[0];
+		term.i1 = pz_ptr->ispec[1];
+		term.i2 = pz_ptr->ispec[2];
+		term.alpha = -1;
+		term.c0_div = 0.0;
+		if (term.type == TYPE_B1 || term.type == TYPE_B2)
+		{
+			size_t k = 0;
+			while (k < pitz_alphas.size() && pitz_alphas[k] != pz_ptr->alpha)
+				k++;
+			if (k == pitz_alphas.size())
+				pitz_alphas.push_back(pz_ptr->alpha);
+			term.alpha = (int)k;
+		}
+		if (term.type == TYPE_C0)
+		{
+			term.c0_div = 2.0 * sqrt(fabs(spec[term.i0]->z * spec[term.i1]->z));
+		}
+		term.os_coef = pz_ptr->os_coef;
+		for (int k = 0; k < 3; k++)
+		{
+			term.ln_coef[k] = pz_ptr->ln_coef[k];
+		}
+	}
+	pitz_alpha_g.resize(pitz_alphas.size());
+	pitz_alpha_gp.resize(pitz_alphas.size());
+	pitz_alpha_exp.resize(pitz_alphas.size());
 }
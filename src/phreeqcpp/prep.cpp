@@ -36,11 +36,17 @@ prep(void)
  */
 	cxxSolution *solution_ptr;
 
-        // UP: we force to reset the model
-        same_model = FALSE;
-        last_model.force_prep = true;
-        solution_ptr = use.Get_solution_ptr();
-        if (solution_ptr == NULL)
+	if (state >= REACTION)
+	{
+		same_model = check_same_model();
+	}
+	else
+	{
+		same_model = FALSE;
+		last_model.force_prep = true;
+	}
+	solution_ptr = use.Get_solution_ptr();
+	if (solution_ptr == NULL)
 	{
 		error_msg("Solution needed for calculation not found, stopping.",
 				  STOP);
@@ -102,6 +108,15 @@ prep(void)
  *   If model is same, just update masses, don`t rebuild unknowns and lists
  */
 		quick_setup();
+		count_same_model++;
+/*
+ *   log k's are recalculated as for a new model, results do not depend on
+ *   the cells calculated before
+ */
+		current_tc = NAN;
+		current_pa = NAN;
+		current_mu = NAN;
+		mu_terms_in_logk = true;
 	}
 	if (debug_mass_balance)
 	{
@@ -1103,6 +1118,14 @@ build_model(void)
 	sum_jacob0.clear();
 	sum_jacob1.clear();
 	sum_jacob2.clear();
+	sum_jacob_stale = true;
+	species_kernel_stale = true;
+	logk_model_stale = true;
+/*
+ *   The reactions of s_x are rewritten, e.g. for a new basis after
+ *   switch_bases, so k_temp must not keep the log k's of the old ones
+ */
+	current_tc = NAN;
 	sum_delta.clear();
 	species_list.clear();
 /*
@@ -2554,6 +2577,9 @@ reprep(void)
 	sum_jacob0.clear();
 	sum_jacob1.clear();
 	sum_jacob2.clear();
+	sum_jacob_stale = true;
+	species_kernel_stale = true;
+	logk_model_stale = true;
 	sum_delta.clear(); 
 /*
  *   Build model again
@@ -4753,6 +4779,7 @@ store_jacob(LDBLE * source, LDBLE * target, LDBLE coef)
  *   If coef is 1.0, adds to sum_jacob1, which does not require a multiply
  *   Otherwise, adds to sum_jacob2, which allows multiply by coef
  */
+	sum_jacob_stale = true;
 	if (equal(coef, 1.0, TOL) == TRUE)
 	{
 		size_t count_sum_jacob1 = sum_jacob1.size();
@@ -4787,6 +4814,7 @@ store_jacob0(int row, int column, LDBLE coef)
 /*
  *   Stores in list a constant coef which will be added into jacobian array
  */
+	sum_jacob_stale = true;
 	size_t count_sum_jacob0 = sum_jacob0.size();
 	sum_jacob0.resize(count_sum_jacob0 + 1);
 	sum_jacob0[count_sum_jacob0].target =
@@ -4805,6 +4833,7 @@ store_mb(LDBLE * source, LDBLE * target, LDBLE coef)
  *   If coef is 1.0, adds to sum_mb1, which does not require a multiply
  *   else, adds to sum_mb2, which will multiply by coef
  */
+	species_kernel_stale = true;
 	if (equal(coef, 1.0, TOL) == TRUE)
 	{
 		size_t count_sum_mb1 = sum_mb1.size();
@@ -5318,7 +5347,7 @@ calc_lk_phase(phase *p_ptr, LDBLE TK, LDBLE pa)
 
 /* ---------------------------------------------------------------------- */
 int Phreeqc::
-calc_vm(LDBLE tc, LDBLE pa)
+calc_vm(LDBLE tc, const class logk_tp &tp)
 /* ---------------------------------------------------------------------- */
 {
 /*
@@ -5332,9 +5361,10 @@ calc_vm(LDBLE tc, LDBLE pa)
  *	  coef(tc) = logk[vmi1] + logk[vmi2] / (TK - 228) + logk[vmi3] * (TK - 228).
  *    b4 = logk[vmi4], or
  *	  coef(tc) = millero[3] + millero[4] * tc + millero[5] * tc^2
+ *    Vm0(tc) and the coef(tc) of the supcrt parms are taken from tp.
  */
 	if (llnl_temp.size() > 0) return OK;
-	LDBLE pb_s = 2600. + pa * 1.01325, TK_s = tc + 45.15, sqrt_mu = sqrt(mu_x); 
+	LDBLE sqrt_mu = sqrt(mu_x); 
 	for (int i = 0; i < (int)this->s_x.size(); i++)
 	{
 		//if (!strcmp(s_x[i]->name, "H2O"))
@@ -5346,9 +5376,7 @@ calc_vm(LDBLE tc, LDBLE pa)
 		if (s_x[i]->logk[vma1])
 		{
 		/* supcrt volume at I = 0... */
-			s_x[i]->rxn_x.logk[vm_tc] = s_x[i]->logk[vma1] + s_x[i]->logk[vma2] / pb_s +
-				(s_x[i]->logk[vma3] + s_x[i]->logk[vma4] / pb_s) / TK_s -
-				s_x[i]->logk[wref] * QBrn;
+			s_x[i]->rxn_x.logk[vm_tc] = tp.s_vm0[i];
 			/* A (small) correction by Shock et al., 1992, for 155 < tc < 255, P_sat < P < 1e3.
 			   The vma1..a4 and wref numbers are refitted for major cations and anions on xpts,
 			   probably invalidates the correction. */
@@ -5376,7 +5404,7 @@ calc_vm(LDBLE tc, LDBLE pa)
 				/* plus the volume terms * I... */
 				if (s_x[i]->logk[vmi1] != 0.0 || s_x[i]->logk[vmi2] != 0.0 || s_x[i]->logk[vmi3] != 0.0)
 				{
-					LDBLE bi = s_x[i]->logk[vmi1] + s_x[i]->logk[vmi2] / TK_s + s_x[i]->logk[vmi3] * TK_s;
+					LDBLE bi = tp.s_bi[i];
 					if (s_x[i]->logk[vmi4] == 1.0)
 						s_x[i]->rxn_x.logk[vm_tc] += bi * mu_x;
 					else
@@ -5387,7 +5415,7 @@ calc_vm(LDBLE tc, LDBLE pa)
 		else if (s_x[i]->millero[0])
 		{
 		/* Millero volume at I = 0... */
-			s_x[i]->rxn_x.logk[vm_tc] = s_x[i]->millero[0] + tc * (s_x[i]->millero[1] + tc * s_x[i]->millero[2]);
+			s_x[i]->rxn_x.logk[vm_tc] = tp.s_vm0[i];
 			if (s_x[i]->z)
 			{
 			/* the ionic strength terms... */
@@ -5462,6 +5490,9 @@ k_temp(LDBLE tc, LDBLE pa) /* pa - pressure in atm */
 
 	// if (tc == current_tc && pa == current_pa && ((fabs(mu_x - current_mu) < 1e-3 * mu_x) || !mu_terms_in_logk))
 	// 	return OK;
+	/* nothing changed since the last call, e.g. gammas() after prep() */
+	if (tc == current_tc && pa == current_pa && mu_x == current_mu && ah2o_x == current_ah2o)
+		return OK;
 	if (tc != current_tc) goto proceed;
 	if (pa != current_pa) goto proceed;
 	if (fabs(mu_x - current_mu) > 1e-3 * mu_x) goto proceed;
@@ -5481,32 +5512,47 @@ proceed:
 	pa = patm_x;
 	calc_dielectrics(tc, pa);
 
-	calc_vm(tc, pa);
+	const class logk_tp *tp = logk_tp_find(tc, pa);
+	calc_vm(tc, *tp);
 
+	/* at or below 1 atm, delta_v only tells if the log k's depend on mu */
+	bool pressure_term = (pa * PASCAL_PER_ATM - REF_PRES_PASCAL > 0);
 	mu_terms_in_logk = false;
 	for (i = 0; i < (int)this->s_x.size(); i++)
 	{
+		if (!pressure_term && mu_terms_in_logk)
+		{
+			s_x[i]->lk = tp->s_lk[i];
+			continue;
+		}
 		//if (s_x[i]->rxn_x.logk[vm_tc])
 		/* calculate delta_v for the reaction... */
 			s_x[i]->rxn_x.logk[delta_v] = calc_delta_v(*&s_x[i]->rxn_x, false);
 		if (tc == current_tc && s_x[i]->rxn_x.logk[delta_v] == 0)
 			continue;
 		mu_terms_in_logk = true;
-		s_x[i]->lk = k_calc(s_x[i]->rxn_x.logk, tempk, pa * PASCAL_PER_ATM);
+		s_x[i]->lk = k_calc_pressure(tp->s_lk[i], s_x[i]->rxn_x.logk[delta_v],
+			tempk, pa * PASCAL_PER_ATM);
 	}
 /*
  *    Calculate log k for all pure phases
  */
+	size_t j = 0;
 	for (i = 0; i < (int)phases.size(); i++)
 	{
 		if (phases[i]->in == TRUE)  
 		{
-
+			if (!pressure_term && mu_terms_in_logk)
+			{
+				phases[i]->lk = tp->p_lk[j++];
+				continue;
+			}
 			phases[i]->rxn_x.logk[delta_v] = calc_delta_v(*&phases[i]->rxn_x, true) -
 				phases[i]->logk[vm0];
 			if (phases[i]->rxn_x.logk[delta_v])
 				mu_terms_in_logk = true;
-			phases[i]->lk = k_calc(phases[i]->rxn_x.logk, tempk, pa * PASCAL_PER_ATM);
+			phases[i]->lk = k_calc_pressure(tp->p_lk[j++], phases[i]->rxn_x.logk[delta_v],
+				tempk, pa * PASCAL_PER_ATM);
 
 		}
 	}
@@ -5528,6 +5574,7 @@ proceed:
 	current_tc = tc;
 	current_pa = pa;
 	current_mu = mu_x;
+	current_ah2o = ah2o_x;
 
 	return (OK);
 }
@@ -5543,14 +5590,22 @@ k_calc(LDBLE * l_logk, LDBLE tempk, LDBLE presPa)
 	 *
 	 *   delta_v is in cm3/mol.
 	 */
+	return k_calc_pressure(k_calc_tempk(l_logk, tempk), l_logk[delta_v], tempk, presPa);
+}
+
+/* ---------------------------------------------------------------------- */
+LDBLE Phreeqc::
+k_calc_tempk(LDBLE * l_logk, LDBLE tempk)
+/* ---------------------------------------------------------------------- */
+{
+	/*
+	 *   Calculates log k at specified temperature and the reference pressure
+	 */
 
 	/* Molar energy */
 	LDBLE me = tempk * R_KJ_DEG_MOL;
 
-	/* Pressure difference */
-	LDBLE delta_p = presPa - REF_PRES_PASCAL;
-
-	/* Calculate new log k value for this temperature and pressure */
+	/* Calculate new log k value for this temperature */
 	LDBLE lk = l_logk[logK_T0] 
 		- l_logk[delta_h] * (298.15 - tempk) / (LOG_10 * me * 298.15)
 		+ l_logk[T_A1]
@@ -5559,12 +5614,163 @@ k_calc(LDBLE * l_logk, LDBLE tempk, LDBLE presPa)
 		+ l_logk[T_A4] * log10(tempk)
 		+ l_logk[T_A5] / (tempk * tempk)
 		+ l_logk[T_A6] * tempk * tempk;
+	return lk;
+}
+
+/* ---------------------------------------------------------------------- */
+LDBLE Phreeqc::
+k_calc_pressure(LDBLE lk, LDBLE l_delta_v, LDBLE tempk, LDBLE presPa)
+/* ---------------------------------------------------------------------- */
+{
+	/*
+	 *   Adds the pressure term to lk from k_calc_tempk
+	 *
+	 *   delta_v is in cm3/mol.
+	 */
+
+	/* Molar energy */
+	LDBLE me = tempk * R_KJ_DEG_MOL;
+
+	/* Pressure difference */
+	LDBLE delta_p = presPa - REF_PRES_PASCAL;
+
 	if (delta_p > 0)
 		/* cm3 * J /mol = 1e-9 m3 * kJ /mol */
-		lk -= l_logk[delta_v] * 1E-9 * delta_p / (LOG_10 * me);
+		lk -= l_delta_v * 1E-9 * delta_p / (LOG_10 * me);
 	return lk;
 }
 
+/* ---------------------------------------------------------------------- */
+int Phreeqc::
+logk_cache_model(void)
+/* ---------------------------------------------------------------------- */
+{
+	/*
+	 *   Looks up the log k and molar volume parameters of s_x and the
+	 *   phases in the model in logk_tp_cache. Models with the same id have
+	 *   the same entries at a given tc and pa.
+	 *   Returns the id of the model, -1 if the cache is full.
+	 */
+	std::vector<LDBLE> signature;
+	signature.push_back((LDBLE) s_x.size());
+	for (size_t i = 0; i < s_x.size(); i++)
+	{
+		const class species *s_ptr = s_x[i];
+		signature.push_back(s_ptr == s_h2o ? 1.0 : 0.0);
+		signature.insert(signature.end(), &s_ptr->rxn_x.logk[logK_T0], &s_ptr->rxn_x.logk[T_A6] + 1);
+		signature.insert(signature.end(), &s_ptr->logk[vma1], &s_ptr->logk[wref] + 1);
+		signature.insert(signature.end(), &s_ptr->logk[vmi1], &s_ptr->logk[vmi3] + 1);
+		signature.insert(signature.end(), &s_ptr->millero[0], &s_ptr->millero[2] + 1);
+	}
+	for (size_t i = 0; i < phases.size(); i++)
+	{
+		if (phases[i]->in != TRUE)
+			continue;
+		signature.push_back((LDBLE) i);
+		signature.insert(signature.end(), &phases[i]->rxn_x.logk[logK_T0], &phases[i]->rxn_x.logk[T_A6] + 1);
+	}
+
+	std::unique_lock<std::shared_mutex> guard(logk_tp_cache->mutex);
+	std::map<std::vector<LDBLE>, int>::iterator it = logk_tp_cache->models.find(signature);
+	if (it != logk_tp_cache->models.end())
+		return it->second;
+	if (logk_tp_cache->models.size() >= logk_cache::max_entries)
+		return -1;
+	int id = (int) logk_tp_cache->models.size();
+	logk_tp_cache->models[signature] = id;
+	return id;
+}
+
+/* ---------------------------------------------------------------------- */
+const class logk_tp * Phreeqc::
+logk_tp_find(LDBLE tc, LDBLE pa)
+/* ---------------------------------------------------------------------- */
+{
+	/*
+	 *   Returns the log k's without the pressure term and the molar volumes
+	 *   at I = 0 of the model at tc and pa. The values only depend on the
+	 *   model, tc and pa, and are shared with all instances using the same
+	 *   logk_tp_cache. QBrn must have been calculated for tc and pa.
+	 */
+	if (logk_model_stale)
+	{
+		logk_model = logk_cache_model();
+		logk_model_stale = false;
+		logk_tp_x.reset();
+	}
+	if (logk_tp_x && tc == logk_tp_tc && pa == logk_tp_pa)
+		return logk_tp_x.get();
+	logk_tp_tc = tc;
+	logk_tp_pa = pa;
+	std::tuple<int, LDBLE, LDBLE> key(logk_model, tc, pa);
+	if (logk_model >= 0)
+	{
+		std::shared_lock<std::shared_mutex> guard(logk_tp_cache->mutex);
+		std::map<std::tuple<int, LDBLE, LDBLE>, std::shared_ptr<const class logk_tp> >::iterator it =
+			logk_tp_cache->entries.find(key);
+		if (it != logk_tp_cache->entries.end())
+		{
+			logk_tp_x = it->second;
+			logk_tp_cache->hits.fetch_add(1, std::memory_order_relaxed);
+			return logk_tp_x.get();
+		}
+	}
+	logk_tp_cache->misses.fetch_add(1, std::memory_order_relaxed);
+/*
+ *   Calculate the entry, as in calc_vm and k_calc
+ */
+	std::shared_ptr<class logk_tp> tp = std::make_shared<class logk_tp>();
+	LDBLE tempk = tc + 273.15;
+	LDBLE pb_s = 2600. + pa * 1.01325, TK_s = tc + 45.15;
+	tp->s_lk.resize(s_x.size());
+	tp->s_vm0.resize(s_x.size(), 0.0);
+	tp->s_bi.resize(s_x.size(), 0.0);
+	for (size_t i = 0; i < s_x.size(); i++)
+	{
+		const class species *s_ptr = s_x[i];
+		tp->s_lk[i] = k_calc_tempk(s_x[i]->rxn_x.logk, tempk);
+		if (llnl_temp.size() > 0 || s_ptr == s_h2o)
+			continue;
+		if (s_ptr->logk[vma1])
+		{
+			tp->s_vm0[i] = s_ptr->logk[vma1] + s_ptr->logk[vma2] / pb_s +
+				(s_ptr->logk[vma3] + s_ptr->logk[vma4] / pb_s) / TK_s -
+				s_ptr->logk[wref] * QBrn;
+			tp->s_bi[i] = s_ptr->logk[vmi1] + s_ptr->logk[vmi2] / TK_s + s_ptr->logk[vmi3] * TK_s;
+		}
+		else if (s_ptr->millero[0])
+		{
+			tp->s_vm0[i] = s_ptr->millero[0] + tc * (s_ptr->millero[1] + tc * s_ptr->millero[2]);
+		}
+	}
+	for (size_t i = 0; i < phases.size(); i++)
+	{
+		if (phases[i]->in == TRUE)
+			tp->p_lk.push_back(k_calc_tempk(phases[i]->rxn_x.logk, tempk));
+	}
+
+	logk_tp_x = tp;
+	if (logk_model >= 0)
+	{
+		std::unique_lock<std::shared_mutex> guard(logk_tp_cache->mutex);
+		/* another instance may have inserted the same values meanwhile */
+		std::pair<std::map<std::tuple<int, LDBLE, LDBLE>, std::shared_ptr<const class logk_tp> >::iterator, bool> inserted =
+			logk_tp_cache->entries.emplace(key, logk_tp_x);
+		logk_tp_x = inserted.first->second;
+		if (inserted.second)
+		{
+			/* drop the oldest entry, instances using it keep their copy */
+			logk_tp_cache->order.push_back(key);
+			if (logk_tp_cache->entries.size() > logk_cache::max_entries)
+			{
+				logk_tp_cache->entries.erase(logk_tp_cache->order.front());
+				logk_tp_cache->order.pop_front();
+			}
+		}
+	}
+	return logk_tp_x.get();
+}
+
 
 /* ---------------------------------------------------------------------- */
  int Phreeqc::
@@ -5688,6 +5894,16 @@ save_model(void)
 		last_model.surface_charge.clear();
 	}
 
+	if (use.Get_surface_ptr() != NULL)
+	{
+		last_model.only_counter_ions = use.Get_surface_ptr()->Get_only_counter_ions();
+	}
+	else
+	{
+		last_model.only_counter_ions = false;
+	}
+	save_model_signature();
+
 	current_tc = NAN;
 	current_pa = NAN;
 	current_mu = NAN;
@@ -5697,6 +5913,97 @@ save_model(void)
 
 	return (OK);
 }
+/* ---------------------------------------------------------------------- */
+void Phreeqc::
+save_model_signature(void)
+/* ---------------------------------------------------------------------- */
+{
+/*
+ *   Parts of the model that are not described by master->total:
+ *      names of the solution totals (unknowns of setup_solution),
+ *      exchange formulas and related phases.
+ *   solution_redox is set if the solution is defined by redox states, i.e.
+ *   unknowns are set up for secondary master species. quick_setup only
+ *   updates unknowns of primary master species from master->total, so such
+ *   a model can not be reused.
+ *   Only called for a new model; check_model_signature compares the names
+ *   without looking them up.
+ */
+	last_model.solution_redox = false;
+	last_model.solution_totals.clear();
+	cxxSolution *solution_ptr = use.Get_solution_ptr();
+	if (solution_ptr != NULL)
+	{
+		cxxNameDouble::iterator it = solution_ptr->Get_totals().begin();
+		for ( ; it != solution_ptr->Get_totals().end(); it++)
+		{
+			if (it->second <= 0.0)
+				continue;
+			class master *master_ptr = master_bsearch(it->first.c_str());
+			if (master_ptr != NULL && master_ptr->primary == FALSE)
+			{
+				last_model.solution_redox = true;
+			}
+			last_model.solution_totals.push_back(it->first);
+		}
+	}
+
+	last_model.exchange_comp.clear();
+	last_model.exchange_phase.clear();
+	if (use.Get_exchange_ptr() != NULL)
+	{
+		std::vector<cxxExchComp> &comps = use.Get_exchange_ptr()->Get_exchange_comps();
+		for (size_t i = 0; i < comps.size(); i++)
+		{
+			last_model.exchange_comp.push_back(comps[i].Get_formula());
+			last_model.exchange_phase.push_back(comps[i].Get_phase_name());
+		}
+	}
+}
+/* ---------------------------------------------------------------------- */
+bool Phreeqc::
+check_model_signature(void)
+/* ---------------------------------------------------------------------- */
+{
+/*
+ *   Returns true if the names saved by save_model_signature are the ones of
+ *   the current solution and exchanger. Names are compared in place, so
+ *   nothing is allocated or looked up for a reused model.
+ */
+	if (last_model.solution_redox)
+		return false;
+
+	size_t k = 0;
+	cxxSolution *solution_ptr = use.Get_solution_ptr();
+	if (solution_ptr != NULL)
+	{
+		cxxNameDouble::iterator it = solution_ptr->Get_totals().begin();
+		for ( ; it != solution_ptr->Get_totals().end(); it++)
+		{
+			if (it->second <= 0.0)
+				continue;
+			if (k >= last_model.solution_totals.size() ||
+				it->first != last_model.solution_totals[k])
+				return false;
+			k++;
+		}
+	}
+	if (k != last_model.solution_totals.size())
+		return false;
+
+	if (use.Get_exchange_ptr() == NULL)
+		return last_model.exchange_comp.empty();
+	std::vector<cxxExchComp> &comps = use.Get_exchange_ptr()->Get_exchange_comps();
+	if (comps.size() != last_model.exchange_comp.size())
+		return false;
+	for (size_t i = 0; i < comps.size(); i++)
+	{
+		if (comps[i].Get_formula() != last_model.exchange_comp[i] ||
+			comps[i].Get_phase_name() != last_model.exchange_phase[i])
+			return false;
+	}
+	return true;
+}
 
 /* ---------------------------------------------------------------------- */
 int Phreeqc::
@@ -5714,6 +6021,11 @@ check_same_model(void)
 	}
 	if (state == TRANSPORT && cell_data[cell_no].same_model)
 		return TRUE;
+/*
+ *   Check solution totals and exchangers
+ */
+	if (!check_model_signature())
+		return (FALSE);
 /*
  *   Check master species
  */
@@ -5754,6 +6066,9 @@ check_same_model(void)
 			return (FALSE);
 		if (last_model.gas_phase_type != gas_phase_ptr->Get_type())
 			return (FALSE);
+		/* pressure of fixed-volume gas phases is not reproduced by quick_setup */
+		if (gas_phase_ptr->Get_type() == cxxGasPhase::GP_VOLUME)
+			return (FALSE);
 		for (i = 0; i < (int) gas_phase_ptr->Get_gas_comps().size(); i++)
 		{
 			cxxGasComp *gc_ptr = &(gas_phase_ptr->Get_gas_comps()[i]);
@@ -5843,12 +6158,14 @@ check_same_model(void)
 			return (FALSE);
 		if (last_model.dl_type != use.Get_surface_ptr()->Get_dl_type())
 			return (FALSE);
+		/* diffuse layer data is initialized while setting up the surface */
+		if (use.Get_surface_ptr()->Get_dl_type() != cxxSurface::NO_DL)
+			return (FALSE);
 		/*if (last_model.edl != use.Get_surface_ptr()->edl) return(FALSE); */
 		if (last_model.surface_type != use.Get_surface_ptr()->Get_type())
 			return (FALSE);
-		/*
-		   if (last_model.only_counter_ions != use.Get_surface_ptr()->only_counter_ions) return(FALSE);
-		 */
+		if (last_model.only_counter_ions != use.Get_surface_ptr()->Get_only_counter_ions())
+			return (FALSE);
 		for (i = 0; i < (int) use.Get_surface_ptr()->Get_surface_comps().size(); i++)
 		{
 			if (last_model.surface_comp[i] !=
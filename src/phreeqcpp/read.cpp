@@ -1996,15 +1996,30 @@ int Phreeqc::read_kinetics(void)
     case 9:  /* runge_kutta */
     case 10: /* rk */
     {
-      int j = copy_token(token, &next_char);
-      if (j == DIGIT) {
-        char *ptr;
-        temp_kinetics.Set_rk((int)strtod(token.c_str(), &ptr));
-      } else if (j == EMPTY) {
-      } else {
-        error_string = sformatf("Expecting order for Runge-Kutta method.");
-        error_msg(error_string, CONTINUE);
-        input_error++;
+      /* order of the Runge-Kutta-Fehlberg method and/or the integrator */
+      int j;
+      while ((j = copy_token(token, &next_char)) != EMPTY) {
+        if (j == DIGIT) {
+          char *ptr;
+          temp_kinetics.Set_rk((int)strtod(token.c_str(), &ptr));
+        } else if (strcmp_nocase(token.c_str(), "cash_karp") == 0 ||
+                   strcmp_nocase(token.c_str(), "fehlberg") == 0) {
+          temp_kinetics.Set_rk_method(cxxKinetics::RK_CASH_KARP);
+        } else if (strcmp_nocase(token.c_str(), "dormand_prince") == 0 ||
+                   strcmp_nocase(token.c_str(), "dopri5") == 0) {
+          temp_kinetics.Set_rk_method(cxxKinetics::RK_DORMAND_PRINCE);
+        } else if (strcmp_nocase(token.c_str(), "rosenbrock") == 0 ||
+                   strcmp_nocase(token.c_str(), "ros2") == 0) {
+          temp_kinetics.Set_rk_method(cxxKinetics::RK_ROSENBROCK);
+        } else {
+          error_string = sformatf(
+              "Expecting order for Runge-Kutta method, or cash_karp, "
+              "dormand_prince or rosenbrock, but found %s.",
+              token.c_str());
+          error_msg(error_string, CONTINUE);
+          input_error++;
+          break;
+        }
       }
     } break;
     case 11: /* bad_step_max */
@@ -6921,9 +6936,15 @@ int Phreeqc::read_debug(void)
       "minimum_total",                /* 21 */
       "min_total",                    /* 22 */
       "debug_mass_action",            /* 23 */
-      "debug_mass_balance"            /* 24 */
+      "debug_mass_balance",           /* 24 */
+      "cl1_compensated_sum",          /* 25 */
+      "dense_linear_solver",          /* 26 */
+      "vectorized_gammas",            /* 27 */
+      "compiled_rates",               /* 28 */
+      "cvode_jacobian_threads",       /* 29 */
+      "cvode_jacobian_reuse"          /* 30 */
   };
-  int count_opt_list = 25;
+  int count_opt_list = 31;
   /*
    *   Read parameters:
    *	ineq_tol;
@@ -7027,10 +7048,46 @@ int Phreeqc::read_debug(void)
     case 24: /* debug_mass_balance */
       debug_mass_balance = get_true_false(next_char, TRUE);
       break;
+    case 25: /* cl1_compensated_sum */
+      cl1_compensated_sum = get_true_false(next_char, TRUE);
+      break;
+    case 26: /* dense_linear_solver */
+      dense_linear_solver = get_true_false(next_char, TRUE);
+      break;
+    case 27: /* vectorized_gammas */
+      vectorized_gammas = get_true_false(next_char, TRUE);
+      break;
+    case 28: /* compiled_rates */
+      compiled_rates = get_true_false(next_char, TRUE);
+      break;
+    case 29: /* cvode_jacobian_threads */
+      if (sscanf(next_char, "%d", &cvode_jacobian_threads) != 1 ||
+          cvode_jacobian_threads < 1) {
+        input_error++;
+        error_msg("Expecting a positive number of threads for "
+                  "-cvode_jacobian_threads.",
+                  CONTINUE);
+        error_msg(line_save, CONTINUE);
+        cvode_jacobian_threads = 1;
+      }
+      break;
+    case 30: /* cvode_jacobian_reuse */
+      if (sscanf(next_char, SCANFORMAT, &cvode_jacobian_reuse) != 1 ||
+          cvode_jacobian_reuse < 0) {
+        input_error++;
+        error_msg("Expecting a relative tolerance >= 0 for "
+                  "-cvode_jacobian_reuse.",
+                  CONTINUE);
+        error_msg(line_save, CONTINUE);
+        cvode_jacobian_reuse = 0.0;
+      }
+      break;
     }
     if (return_value == EOF || return_value == KEYWORD)
       break;
   }
+  /* the workers of the CVODE Jacobian are copies of the old knobs */
+  cvode_jacobian_free();
   return (return_value);
 }
 
@@ -7665,6 +7722,7 @@ int Phreeqc::read_rates(void)
       rate_ptr->linebase = NULL;
       rate_ptr->varbase = NULL;
       rate_ptr->loopbase = NULL;
+      rate_ptr->program = NULL;
       opt_save = OPT_1;
       break;
     case OPT_1: /* read command */
@@ -3,6 +3,8 @@
 #include "Exchange.h"
 #include "Solution.h"
 
+#include <algorithm>
+
 #if defined(PHREEQCI_GUI)
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -298,7 +300,7 @@ sit(void)
 /* ---------------------------------------------------------------------- */
 {
   int i, i0, i1;
-  LDBLE param, z0, z1;
+  LDBLE z0;
   LDBLE A, AGAMMA, T;
 	/*
 	   LDBLE CONV, XI, XX, OSUM, BIGZ, DI, F, XXX, GAMCLM, 
@@ -409,60 +411,30 @@ sit(void)
 	 *  epsilons are tabulated for log10 gamma (not ln gamma)
 	 */
 	LDBLE logmu = log10(I);
-	for (size_t j = 0; j < param_list.size(); j++)
+	/*
+	 *  sit_epsilons, kinds multiply by 1, mu, or log10(mu)
+	 */
+	const LDBLE scale[3] = {1.0, I, logmu};
+	const int *kinds = sit_epsilons.kinds.data();
+	const LDBLE *eps = sit_epsilons.eps.data();
+	for (size_t j = 0; j < sit_epsilons.kinds.size(); j++)
 	{
-		int i = param_list[j];
-		i0 = sit_params[i]->ispec[0];
-		i1 = sit_params[i]->ispec[1];
-		//if (sit_IPRSNT[i0] == FALSE || sit_IPRSNT[i1] == FALSE) continue;
-		z0 = spec[i0]->z;
-		z1 = spec[i1]->z;
-		param = sit_params[i]->p;
-		switch (sit_params[i]->type)
+		i0 = sit_epsilons.i0[j];
+		i1 = sit_epsilons.i1[j];
+		OSMOT += sit_M[i0] * sit_M[i1] * eps[j] * scale[kinds[j]] /
+			sit_epsilons.osmot_div[j];
+	}
+	const int *columns = sit_epsilons.columns.data();
+	const size_t *params = sit_epsilons.params.data();
+	const size_t *first = sit_epsilons.first.data();
+	for (size_t t = 0; t < sit_epsilons.targets.size(); t++)
+	{
+		LDBLE lgamma = 0.0;
+		for (size_t k = first[t]; k < first[t + 1]; k++)
 		{
-		case TYPE_SIT_EPSILON:
-			sit_LGAMMA[i0] += sit_M[i1] * param;
-			sit_LGAMMA[i1] += sit_M[i0] * param;
-			if (z0 == 0.0 && z1 == 0.0)
-			{
-				OSMOT += sit_M[i0] * sit_M[i1] * param / 2.0;
-			}
-			else
-			{
-				OSMOT += sit_M[i0] * sit_M[i1] * param;
-			}
-			break;
-		case TYPE_SIT_EPSILON_MU:
-			sit_LGAMMA[i0] += sit_M[i1] * I * param;
-			sit_LGAMMA[i1] += sit_M[i0] * I * param;
-			//OSMOT += sit_M[i0] * sit_M[i1] * param;
-			if (z0 == 0.0 && z1 == 0.0)
-			{
-				OSMOT += sit_M[i0] * sit_M[i1] * param * I / 2.0;
-			}
-			else
-			{
-				OSMOT += sit_M[i0] * sit_M[i1] * param * I;
-			}
-			break;
-		case TYPE_SIT_EPSILON2:
-			sit_LGAMMA[i0] += sit_M[i1] * logmu * param;
-			sit_LGAMMA[i1] += sit_M[i0] * logmu * param;
-			//OSMOT += sit_M[i0] * sit_M[i1] * param;
-			if (z0 == 0.0 && z1 == 0.0)
-			{
-				OSMOT += sit_M[i0] * sit_M[i1] * param * logmu / 2.0;
-			}
-			else
-			{
-				OSMOT += sit_M[i0] * sit_M[i1] * param * logmu;
-			}
-			break;
-		default:
-		case TYPE_Other:
-			error_msg("TYPE_Other in pitz_param list.", STOP);
-			break;
+			lgamma += sit_M[columns[k]] * scale[kinds[params[k]]] * eps[params[k]];
 		}
+		sit_LGAMMA[sit_epsilons.targets[t]] = lgamma;
 	}
 
 	/*
@@ -1624,6 +1596,7 @@ C     Set DW0
 	{
 		int i = param_list[j];
 		calc_sit_param(sit_params[i], TK, TR);
+		sit_epsilons.eps[j] = sit_params[i]->p;
 	}
 	calc_dielectrics(TK - 273.15, patm_x);
 	sit_A0 = A0;
@@ -1704,4 +1677,66 @@ sit_make_lists(void)
 		if (sit_IPRSNT[i0] == FALSE || sit_IPRSNT[i1] == FALSE) continue;
 		param_list.push_back(i);
 	}
+/*
+ *   Compact param_list into sit_epsilons, entries sorted by row
+ */
+	class sit_epsilon_matrix &m = sit_epsilons;
+	size_t count_params = param_list.size();
+	m.i0.resize(count_params);
+	m.i1.resize(count_params);
+	m.kinds.resize(count_params);
+	m.osmot_div.resize(count_params);
+	m.eps.assign(count_params, 0.0);
+	class entry
+	{
+	public:
+		int row;
+		int column;
+		size_t param;
+	};
+	std::vector<entry> entries;
+	entries.reserve(2 * count_params);
+	for (size_t j = 0; j < count_params; j++)
+	{
+		const class pitz_param *pz_ptr = sit_params[param_list[j]];
+		m.i0[j] = pz_ptr->ispec[0];
+		m.i1[j] = pz_ptr->ispec[1];
+		switch (pz_ptr->type)
+		{
+		case TYPE_SIT_EPSILON:
+			m.kinds[j] = 0;
+			break;
+		case TYPE_SIT_EPSILON_MU:
+			m.kinds[j] = 1;
+			break;
+		case TYPE_SIT_EPSILON2:
+			m.kinds[j] = 2;
+			break;
+		default:
+		case TYPE_Other:
+			error_msg("TYPE_Other in pitz_param list.", STOP);
+			break;
+		}
+		m.osmot_div[j] =
+			(spec[m.i0[j]]->z == 0.0 && spec[m.i1[j]]->z == 0.0) ? 2.0 : 1.0;
+		entries.push_back({m.i0[j], m.i1[j], j});
+		entries.push_back({m.i1[j], m.i0[j], j});
+	}
+	std::stable_sort(entries.begin(), entries.end(),
+		[](const entry &a, const entry &b) { return a.row < b.row; });
+	m.targets.clear();
+	m.first.clear();
+	m.columns.resize(entries.size());
+	m.params.resize(entries.size());
+	for (size_t k = 0; k < entries.size(); k++)
+	{
+		if (k == 0 || entries[k].row != entries[k - 1].row)
+		{
+			m.targets.push_back(entries[k].row);
+			m.first.push_back(k);
+		}
+		m.columns[k] = entries[k].column;
+		m.params[k] = entries[k].param;
+	}
+	m.first.push_back(entries.size());
 }
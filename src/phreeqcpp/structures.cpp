@@ -196,6 +196,7 @@ clean_up(void)
 	free_tally_table();
 	/* CVODE memory */
 	free_cvode();
+	cvode_jacobian_free();
 	/* pitzer */
 	pitzer_clean_up();
 	/* sit */
@@ -1375,6 +1376,7 @@ rate_free(class rate *rate_ptr)
 	if (rate_ptr == NULL)
 		return (ERROR);
 	rate_ptr->commands.clear();
+	basic_free_program(&rate_ptr->program);
 	if (rate_ptr->linebase != NULL)
 	{
 		char cmd[] = "new; quit";
@@ -1403,6 +1405,7 @@ rate_copy(const class rate *rate_ptr)
 	rate_new->linebase = NULL;
 	rate_new->varbase = NULL;
 	rate_new->loopbase = NULL;
+	rate_new->program = NULL;
 	return (rate_new);
 }
 
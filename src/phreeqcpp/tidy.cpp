@@ -157,6 +157,7 @@ tidy_model(void)
 
 	if (new_model == TRUE)
 	{
+		definitions_serial++;
 		/* species */
 		if (s.size() > 1) //qsort(&s[0], s.size(), sizeof(class species*), s_compare);
 		{
@@ -94,14 +94,22 @@ calc_dielectrics(LDBLE tc, LDBLE pa)
 		tc = 350.;
 	}
 	LDBLE T = tc + 273.15;
-	LDBLE u1 = 3.4279e2, u2 = -5.0866e-3, u3 = 9.469e-7, u4 = -2.0525,
-		u5 = 3.1159e3, u6 = -1.8289e2, u7 = -8.0325e3, u8 = 4.2142e6,
-		u9 = 2.1417;
-	LDBLE d1000 = u1 * exp(T * (u2 + T * u3)); // relative dielectric constant at 1000 bar
-	LDBLE c = u4 + u5 / (u6 + T);
-	LDBLE b = u7 + u8 / T + u9 * T;
-	LDBLE pb = pa * 1.01325; // pa in bar
-	eps_r = d1000 + c * log((b + pb) / (b + 1e3)); // relative dielectric constant
+	/* the terms without rho_0 and kappa_0 only depend on tc and pa */
+	if (tc != dielectrics_tc || pa != dielectrics_pa)
+	{
+		LDBLE u1 = 3.4279e2, u2 = -5.0866e-3, u3 = 9.469e-7, u4 = -2.0525,
+			u5 = 3.1159e3, u6 = -1.8289e2, u7 = -8.0325e3, u8 = 4.2142e6,
+			u9 = 2.1417;
+		LDBLE d1000 = u1 * exp(T * (u2 + T * u3)); // relative dielectric constant at 1000 bar
+		LDBLE c = u4 + u5 / (u6 + T);
+		LDBLE b = u7 + u8 / T + u9 * T;
+		LDBLE pb = pa * 1.01325; // pa in bar
+		dielectrics_eps_r = d1000 + c * log((b + pb) / (b + 1e3)); // relative dielectric constant
+		dielectrics_c_b = c / (b + pb);
+		dielectrics_tc = tc;
+		dielectrics_pa = pa;
+	}
+	eps_r = dielectrics_eps_r;
 	if (eps_r <= 0)
 	{
 		eps_r = 10.;
@@ -128,13 +136,13 @@ calc_dielectrics(LDBLE tc, LDBLE pa)
 	}
 
 	/* Debye-Hueckel limiting slope = DH_B *  e2_DkT * RT * (d(ln(eps_r)) / d(P) - compressibility) */
-	DH_Av = DH_B * e2_DkT * R_LITER_ATM * 1e3 * T * (c / (b + pb) * 1.01325 / eps_r - kappa_0 / 3.); // (cm3/mol)(mol/kg)^-0.5
+	DH_Av = DH_B * e2_DkT * R_LITER_ATM * 1e3 * T * (dielectrics_c_b * 1.01325 / eps_r - kappa_0 / 3.); // (cm3/mol)(mol/kg)^-0.5
 
 	DH_B /= 1e8; // kappa, 1/Angstrom(mol/kg)^-0.5
 
 	/* the Born functions, * 41.84 to give molal volumes in cm3/mol... */
 	ZBrn = (-1 / eps_r + 1.0) * 41.84004;
-	QBrn = c / (b + pb) / eps_r / eps_r * 41.84004;
+	QBrn = dielectrics_c_b / eps_r / eps_r * 41.84004;
 	/* dgdP from subroutine gShok2 in supcrt92, g is neglected here (at tc < 300)...
 	   and, dgdP is small. Better, adapt Wref to experimental Vm's */
 	dgdP = 0;
@@ -180,17 +188,24 @@ calc_rho_0(LDBLE tc, LDBLE pa)
 		tc = 350.;
 	}
 	LDBLE T = tc + 273.15;
-	//eqn. 2.6...
-	LDBLE Tc = 647.096, th = 1 - T / Tc;
-	LDBLE b1 = 1.99274064, b2 = 1.09965342, b3 = -0.510839303,
-		b4 = -1.75493479, b5 = -45.5170352, b6 = -6.7469445e5;
-    rho_0_sat = 322.0 * (1.0 + b1 * pow(th, (LDBLE) 1./3.) + b2 * pow(th, (LDBLE) 2./3.) + b3 * pow(th, (LDBLE) 5./3.) +\
-               b4 * pow(th, (LDBLE) 16./3.) + b5 * pow(th, (LDBLE) 43./3.) + b6 * pow(th, (LDBLE) 110./3));
-	//pressure...
-	LDBLE p0 =  5.1880000E-02 + tc * (-4.1885519E-04 + tc * ( 6.6780748E-06 + tc * (-3.6648699E-08 + tc *  8.3501912E-11)));
-	LDBLE p1 = -6.0251348E-06 + tc * ( 3.6696407E-07 + tc * (-9.2056269E-09 + tc * ( 6.7024182E-11 + tc * -1.5947241E-13)));
-	LDBLE p2 = -2.2983596E-09 + tc * (-4.0133819E-10 + tc * ( 1.2619821E-11 + tc * (-9.8952363E-14 + tc *  2.3363281E-16)));
-	LDBLE p3 =  7.0517647E-11 + tc * ( 6.8566831E-12 + tc * (-2.2829750E-13 + tc * ( 1.8113313E-15 + tc * -4.2475324E-18)));
+	/* the density at saturation and the pressure coefficients only depend on tc */
+	if (tc != rho_0_tc)
+	{
+		//eqn. 2.6...
+		LDBLE Tc = 647.096, th = 1 - T / Tc;
+		LDBLE b1 = 1.99274064, b2 = 1.09965342, b3 = -0.510839303,
+			b4 = -1.75493479, b5 = -45.5170352, b6 = -6.7469445e5;
+		rho_0_sat_tc = 322.0 * (1.0 + b1 * pow(th, (LDBLE) 1./3.) + b2 * pow(th, (LDBLE) 2./3.) + b3 * pow(th, (LDBLE) 5./3.) +\
+			b4 * pow(th, (LDBLE) 16./3.) + b5 * pow(th, (LDBLE) 43./3.) + b6 * pow(th, (LDBLE) 110./3));
+		//pressure...
+		rho_0_p[0] =  5.1880000E-02 + tc * (-4.1885519E-04 + tc * ( 6.6780748E-06 + tc * (-3.6648699E-08 + tc *  8.3501912E-11)));
+		rho_0_p[1] = -6.0251348E-06 + tc * ( 3.6696407E-07 + tc * (-9.2056269E-09 + tc * ( 6.7024182E-11 + tc * -1.5947241E-13)));
+		rho_0_p[2] = -2.2983596E-09 + tc * (-4.0133819E-10 + tc * ( 1.2619821E-11 + tc * (-9.8952363E-14 + tc *  2.3363281E-16)));
+		rho_0_p[3] =  7.0517647E-11 + tc * ( 6.8566831E-12 + tc * (-2.2829750E-13 + tc * ( 1.8113313E-15 + tc * -4.2475324E-18)));
+		rho_0_tc = tc;
+	}
+	rho_0_sat = rho_0_sat_tc;
+	LDBLE p0 = rho_0_p[0], p1 = rho_0_p[1], p2 = rho_0_p[2], p3 = rho_0_p[3];
 	/* The minimal pressure equals the saturation pressure... */
 	if (ah2o_x <= 1.0)
 		p_sat = exp(11.6702 - 3816.44 / (T - 46.13)) * ah2o_x;